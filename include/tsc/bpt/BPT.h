@@ -15,6 +15,7 @@
 #ifndef _BPT_H
 #define	_BPT_H
 
+#include "NodeIdContext.hpp"
 #include "BPTNode.hpp"
 #include "BPTDissimilarity.hpp"
 #include "policies/BPTPolicies.h"
@@ -23,9 +24,13 @@
 #include "DissimilarityMeasure.hpp"
 #include "DenseWRAGGenerator.hpp"
 #include "BPTDataSource.hpp"
+#include "BPTMultiDataSource.hpp"
 #include "BPTReconstructor.hpp"
 #include "PruneCriteria.h"
+#include "NodeShapeTable.hpp"
+#include "NodeLeafOrder.hpp"
 #include "TemporalStability.hpp"
+#include "TemporalStabilityEngine.hpp"
 
 #include "VectorDissimilarityMeasures.hpp"
 #include "MatrixDissimilarityMeasure.hpp"
@@ -18,12 +18,16 @@
 #include "../policies/Storage.hpp"
 #include "../policies/CheckingPolicy.hpp"
 #include "policies/BPTDataSavingPolicy.hpp"
+#include "policies/BPTMergeTracePolicy.hpp"
+#include "policies/BPTMemoryPolicy.hpp"
 #include "../log/Logger.hpp"
 #include "../log/ProgressDisplay.hpp"
 #include "models/ModelMerge.hpp"
+#include "NodeIdContext.hpp"
 #include "../util/ToString.hpp"
 #include <set>
 #include <map>
+#include <algorithm>
 #include <iostream>
 #include <fstream>
 #include <string>
@@ -34,6 +38,18 @@ namespace tscbpt
 /**
  * Template to construct the BPT structure from the original
  * Weighted Region Adjacency Graph (WRAG)
+ *
+ * The merging loop may be traced through TracePol (see
+ * BPTMergeTracePolicy.hpp), with no overhead by default, and the memory
+ * freed during the construction returned to the system through MemoryPol
+ * (see BPTMemoryPolicy.hpp).
+ *
+ * With a ReleaseCheckingPolicy only the O(1) checks of each merge are
+ * performed, the resulting tree may be validated with BPTFrame::validate().
+ *
+ * The merged nodes get their IDs from the NodeIdContext of the tree (given by
+ * the WRAG generator, or after the highest leaf ID), so that several trees
+ * may be constructed concurrently.
  */
 template <
 	class NodeStoragePol,
@@ -42,9 +58,11 @@ template <
 	class CheckingPol 					= FullCheckingPolicy,
 	class SavingPol						= BPTDataSavingPolicy,
 	class DissimilaritySetType			= set<typename DissimilarityStoragePol::pointerType, pdiss_value_less<typename DissimilarityStoragePol::pointerType> >,
-	class NodeSetType					= set<typename NodeStoragePol::pointerType>
+	class NodeSetType					= set<typename NodeStoragePol::pointerType>,
+	class TracePol						= NoMergeTracePolicy,
+	class MemoryPol						= NoMemoryReclaimPolicy
 >
-class BPTConstructor : public CheckingPol, public Logger, public SavingPol
+class BPTConstructor : public CheckingPol, public Logger, public SavingPol, public TracePol, public MemoryPol
 {
 public:
 
@@ -55,11 +73,15 @@ public:
 	typedef DissimilaritySetType				 				DissimilaritySet;
 	typedef NodeSetType				 							NodeSet;
 	typedef SavingPol											SavingPolicy;
+	typedef TracePol											TracePolicy;
+	typedef MemoryPol											MemoryPolicy;
 
 	typedef typename NodeStoragePolicy::pointerType				NodePointer;
 	typedef typename DissimilarityStoragePolicy::pointerType 	DissimilarityPointer;
 
 	typedef typename NodeStoragePolicy::valueType::RegionModel	RegionModel;
+	typedef typename NodeStoragePolicy::valueType::IDType		IDType;
+	typedef NodeIdContext<IDType>								IdContext;
 	typedef typename NodeSet::iterator							NodeIterator;
 	typedef typename NodeSet::const_iterator 					NodeConstIterator;
 	typedef typename DissimilaritySet::iterator 				DissimilarityIterator;
@@ -69,6 +91,16 @@ public:
 private:
 	NodeSet aliveNodes;
 	DissimilaritySet aliveDissimilarities;
+	IdContext ids;
+
+	// The merged nodes follow the highest leaf ID
+	void inferIds() {
+		size_t leaves = 0;
+		for (NodeConstIterator it = aliveNodes.begin(); it != aliveNodes.end(); ++it) {
+			leaves = max(leaves, static_cast<size_t>((*it)->getId()) + 1);
+		}
+		ids.reset(leaves);
+	}
 
 
 public:
@@ -78,6 +110,15 @@ public:
 			const DissimilaritySet& nodeDiss = (*it)->getDissimilarities();
 			aliveDissimilarities.insert(*(nodeDiss.begin()));
 		}
+		inferIds();
+	}
+
+	BPTConstructor(const NodeSet& leaves, const IdContext& leafIds) : ids(leafIds) {
+		for (NodeConstIterator it = leaves.begin(); it != leaves.end(); it++) {
+			aliveNodes.insert(*it);
+			const DissimilaritySet& nodeDiss = (*it)->getDissimilarities();
+			aliveDissimilarities.insert(*(nodeDiss.begin()));
+		}
 	}
 
 	template<typename InputIterator1, typename InputIterator2>
@@ -87,6 +128,22 @@ public:
 			const DissimilaritySet& nodeDiss = (*first)->getDissimilarities();
 			aliveDissimilarities.insert(*(nodeDiss.begin()));
 		}
+		inferIds();
+	}
+
+	template<typename InputIterator1, typename InputIterator2>
+	BPTConstructor(InputIterator1 first, InputIterator2 last, const IdContext& leafIds) : ids(leafIds) {
+		for (; first != last; ++first) {
+			aliveNodes.insert(*first);
+			const DissimilaritySet& nodeDiss = (*first)->getDissimilarities();
+			aliveDissimilarities.insert(*(nodeDiss.begin()));
+		}
+	}
+
+	// Output directory of the files of the saving and trace policies
+	void setOutputDir(const std::string& dir) {
+		SavingPolicy::setOutputDir(dir);
+		TracePolicy::setOutputDir(dir);
 	}
 
 	template<class TDissimilarityMeasure, template <class,class> class MergeOp >
@@ -102,8 +159,13 @@ public:
 
 		ProgressDisplay show_progress( aliveNodes.size() - numTrees );
 
+		TracePolicy::startMergeTrace();
+
 		while (aliveNodes.size() > numTrees && aliveDissimilarities.size() > 0) {
 
+			TracePolicy::traceMergeStart();
+			size_t evaluations = 0;	// Dissimilarity evaluations of this merge
+
 			if(this->infoLogTest(aliveNodes.size() % 256 == 0)){
 				this->infoLog(string("Subnodes: \t") + to_string(aliveNodes.size()) + string(" \tDissimilarities: \t") + to_string(aliveDissimilarities.size()));
 			}
@@ -131,7 +193,7 @@ public:
 			if(this->errorCheck(removed == 0)) this->errorLog("ERROR: nodeb is not in aliveNodes!!!!");
 
 			// Generate father node by fusion of nodea and nodeb
-			NodePointer father = NodeStoragePolicy::create(merge(nodea, nodeb), nodea, nodeb);
+			NodePointer father = NodeStoragePolicy::create(merge(nodea, nodeb), nodea, nodeb, ids.merged());
 			nodea->setFather(father);
 			nodeb->setFather(father);
 
@@ -153,12 +215,14 @@ public:
 					// Create and insert dissimilarity into father's dissimilarities
 					DissimilarityPointer fdiss = DissimilarityStoragePolicy::create(father, neighbor,
 						dissimilarityMeasure(father, neighbor));
+					++evaluations;
 					father->getDissimilarities().insert(fdiss);
 					if (DissimilarityMeasureType::isSymmetric == true) {
 						neighbor->getDissimilarities().insert(fdiss);
 					} else {
 						DissimilarityPointer dissRev = DissimilarityStoragePolicy::create(neighbor, father,
 							dissimilarityMeasure(neighbor, father));
+						++evaluations;
 						neighbor->getDissimilarities().insert(dissRev);
 					}
 
@@ -184,12 +248,14 @@ public:
 						// Create and insert dissimilarity into father's dissimilarities
 						DissimilarityPointer diss = DissimilarityStoragePolicy::create(father, neighbor,
 							dissimilarityMeasure(father, neighbor));
+						++evaluations;
 						father->getDissimilarities().insert(diss);
 						if (DissimilarityMeasureType::isSymmetric == true) {
 							neighbor->getDissimilarities().insert(diss);
 						} else {
 							DissimilarityPointer dissRev = DissimilarityStoragePolicy::create(neighbor, father,
 								dissimilarityMeasure(neighbor, father));
+							++evaluations;
 							neighbor->getDissimilarities().insert(dissRev);
 						}
 					}
@@ -203,13 +269,16 @@ public:
 				}
 			}
 
-			if (this->errorCheck(fatherNeigbors.find(nodea)!=fatherNeigbors.end())) {
+			// Set lookups, only when validating (see CheckingPolicy.hpp)
+			if (this->validating() && this->errorCheck(fatherNeigbors.find(nodea) != fatherNeigbors.end())) {
 				this->errorLog("ERROR: nodea as father neighbor!!!!");
 			}
-			if (this->errorCheck(fatherNeigbors.find(nodeb) != fatherNeigbors.end())) {
+			if (this->validating() && this->errorCheck(fatherNeigbors.find(nodeb) != fatherNeigbors.end())) {
 				this->errorLog("ERROR: nodeb as father neighbor!!!!");
 			}
 
+			TracePolicy::traceMeasureEnd();
+
 			SavingPolicy::saveFatherNode(father);
 
 			// Add father node to aliveNodes
@@ -252,11 +321,19 @@ public:
 			}
 			nodeb->getDissimilarities().clear();
 
+			TracePolicy::traceMergeEnd(father->getDissimilarities().size(), evaluations, aliveDissimilarities.size());
+
+			MemoryPolicy::reclaimAfterMerge();
+
 			++show_progress;
 		}
 
+		TracePolicy::endMergeTrace();
+
 		SavingPolicy::endBPTConstruction();
 
+		MemoryPolicy::endMemoryReclaim();
+
 		this->infoLog(
 			string("Construction process finished\n") + "AliveNodes: \t" + to_string(aliveNodes.size())
 				+ "AliveDissimilarities: \t" + to_string(aliveDissimilarities.size()));
@@ -22,7 +22,9 @@
 #include <boost/multi_array.hpp>
 #include <boost/static_assert.hpp>
 #include <set>
+#include <vector>
 #include <tsc/util/Algorithms.h>
+#include "NodeLeafOrder.hpp"
 
 namespace tscbpt
 {
@@ -107,6 +109,21 @@ public:
 		populateLeaves(prunedSet, f);
 	}
 
+	/**
+	 * Image of the pruned set (Dims == 2, row major) scattering the value of
+	 * each region into the pixels of its slice of the leaf order, without
+	 * traversing the region subtrees
+	 */
+	template <class PrunedSet>
+	BPTDataSource(const PrunedSet& prunedSet, const NodeLeafOrder& order, functor_type f = functor_type()) {
+		BOOST_STATIC_ASSERT(Dims==2);
+		boost::array<typename array_type::index, Dims> extents;
+		extents[0] = order.getRows();
+		extents[1] = order.getCols();
+		_leaves.resize(extents);
+		populateLeaves(prunedSet, order, f);
+	}
+
 	iterator begin(){
 		return _leaves.data();
 	}
@@ -166,24 +183,40 @@ private:
 	template<class NodePointerSet>
 	void populateLeaves(const NodePointerSet& prunedSet, functor_type func){
 		typedef typename NodePointerSet::const_iterator 		pruned_iterator;
+		std::vector<NodePointer> remaining;
 		for(pruned_iterator it = prunedSet.begin(); it != prunedSet.end(); ++it){
-			NodePointerSet leaves = NodePointerSet();
-			addLeaves(*it, leaves);
 			value_type value = func(*it);
-			for(pruned_iterator itl = leaves.begin(); itl != leaves.end(); ++itl){
-				accessor(_leaves, *itl) = value;
+			// Write the value to all the leaves of the region
+			remaining.push_back(*it);
+			while(!remaining.empty()){
+				NodePointer np = remaining.back();
+				remaining.pop_back();
+				assert(np);
+				if(np->isLeaf()){
+					accessor(_leaves, np) = value;
+				}else{
+					remaining.push_back(np->getLeftSoon());
+					remaining.push_back(np->getRightSoon());
+				}
 			}
 		}
 	}
 
-	template<class PrunedSet>
-	void addLeaves(NodePointer np, PrunedSet& leaves){
-		assert(np);
-		if(np->isLeaf()){
-			leaves.insert(np);
-		} else {
-			addLeaves(np->getLeftSoon(), leaves);
-			addLeaves(np->getRightSoon(), leaves);
+	template<class NodePointerSet>
+	void populateLeaves(const NodePointerSet& prunedSet, const NodeLeafOrder& order, functor_type func){
+		const std::vector<NodePointer> regions(prunedSet.begin(), prunedSet.end());
+		std::vector<value_type> values;
+		values.reserve(regions.size());
+		for(size_t i = 0; i < regions.size(); ++i) values.push_back(func(regions[i]));
+
+		value_type* data = _leaves.data();
+		const int n = static_cast<int>(regions.size());
+		#pragma omp parallel for schedule(dynamic, 64)
+		for(int i = 0; i < n; ++i){
+			const size_t id = regions[i]->getId();
+			for(NodeLeafOrder::pixel_iterator p = order.begin(id); p != order.end(id); ++p){
+				data[*p] = values[i];
+			}
 		}
 	}
 };
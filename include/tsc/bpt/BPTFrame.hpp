@@ -25,12 +25,20 @@
 #include "PNodeComparators.h"
 #include "policies/BPTDataSavingPolicy.hpp"
 #include "policies/AddSavingPolicy.hpp"
+#include "policies/BPTMergeTracePolicy.hpp"
+#include "policies/BPTMemoryPolicy.hpp"
 #include "policies/SaveMergingSequence.hpp"
 #include "policies/SaveMergedNodeModel.hpp"
+#include "policies/AsyncSaveMergedNodeModel.hpp"
 #include "policies/SaveMergedNodeHomogeneity.hpp"
 #include <tsc/io/data_saver/PolSARProMatrixDataSaver.hpp>
 #include <set>
 #include <deque>
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <functional>
+#include <iostream>
 #include <stdint.h>
 
 namespace tscbpt
@@ -85,7 +93,11 @@ class BPTFrame:
 		typedef set<DissimilarityPointer, pdiss_value_less<DissimilarityPointer> >	DissimilaritySet;
 
 		typedef SaveMergingSequence<IDType,CheckingPolicy>							SaveMSPol;
+#if defined(ASYNC_SAVE_BPT_MODELS)
+		typedef AsyncSaveMergedNodeModel<RegionModel, CheckingPol>									SaveMNPol;
+#else
 		typedef SaveMergedNodeModel<RegionModel, PolSARProMatrixDataSaver<>, CheckingPol>			SaveMNPol;
+#endif
 		typedef SaveMergedNodeHomogeneity<>															SaveHomogPol;
 
 #if defined(SAVE_BPT_MODELS_AND_HOMOGENEITY)
@@ -96,9 +108,23 @@ class BPTFrame:
 		typedef BPT_SAVING_POLICY_1(SaveMSPol)										DefaultDataSavingPolicy;
 #endif
 
+#if defined(TRACE_BPT_CONSTRUCTION)
+		typedef SampledMergeTracePolicy<CheckingPol>								MergeTracePol;
+#else
+		typedef NoMergeTracePolicy													MergeTracePol;
+#endif
+
+		// Disabled unless its high-water mark is set
+		typedef ReclaimMemoryPolicy<CheckingPol>									MemoryPol;
+
 		typedef BPTConstructor<NodeStoragePolicy,DissimilarityStoragePolicy,
 			Logger,	CheckingPol, DefaultDataSavingPolicy, DissimilaritySet,
-			NodeSet>																Constructor;
+			NodeSet, MergeTracePol, MemoryPol>										Constructor;
+
+		// Constructor without saving the merging sequence nor the node models (the BPT is kept in memory)
+		typedef BPTConstructor<NodeStoragePolicy,DissimilarityStoragePolicy,
+			Logger,	CheckingPol, BPTDataSavingPolicy, DissimilaritySet,
+			NodeSet, MergeTracePol, MemoryPol>										InMemoryConstructor;
 
 		typedef BPTReconstructor<NodeStoragePolicy, Logger, CheckingPol, NodeSet>	Reconstructor;
 
@@ -129,22 +155,217 @@ class BPTFrame:
 		return out;
 	}
 
+	/**
+	 * Prune the BPT into (at most) regs regions, undoing the last regs-1
+	 * merges. As the node ids follow the merging order, the merged nodes to
+	 * be split are the regs-1 ones with the highest ids, selected in linear
+	 * time, and the regions are obtained with a single pass over the tree.
+	 */
 	static NodeSet& NRegs_prune(NodePointer root, NodeSet& out, size_t regs) {
 		assert(regs > 0);
-		std::set<NodePointer, pnode_later<NodePointer> > remaining;
-		remaining.insert(root);
-		while (remaining.size() && remaining.size() < regs) {
-			NodePointer np = *(remaining.begin());
-			remaining.erase(remaining.begin());
+		NRegs_pass(root, NRegs_threshold(root, regs), &out, NULL, 0);
+		return out;
+	}
+
+	/**
+	 * Same as NRegs_prune, also writing the id of the region of each pixel
+	 * (row major, rows x cols) into labels, within the same pass
+	 */
+	static NodeSet& NRegs_prune(NodePointer root, NodeSet& out, size_t regs, std::vector<NodeID>& labels, size_t rows, size_t cols) {
+		assert(regs > 0);
+		labels.resize(rows * cols);
+		NRegs_pass(root, NRegs_threshold(root, regs), &out, &(labels[0]), cols);
+		return out;
+	}
+
+	/**
+	 * Region id label maps (row major, rows x cols) of the NRegs prunes for
+	 * each of the given number of regions, for multiscale products. The
+	 * merging order is computed once and the label maps in parallel.
+	 */
+	static void NRegs_labels(NodePointer root, const std::vector<size_t>& regs, size_t rows, size_t cols,
+			std::vector<std::vector<NodeID> >& labels) {
+		std::vector<NodeID> ids;
+		NRegs_merged_ids(root, ids);
+		std::sort(ids.begin(), ids.end(), std::greater<NodeID>());
+
+		labels.resize(regs.size());
+		const int n = static_cast<int>(regs.size());
+		#pragma omp parallel for schedule(dynamic, 1)
+		for (int k = 0; k < n; ++k) {
+			assert(regs[k] > 0);
+			labels[k].resize(rows * cols);
+			const NodeID threshold = (regs[k] == 1 || ids.empty()) ? std::numeric_limits<NodeID>::max() :
+					ids[std::min(regs[k] - 2, ids.size() - 1)];
+			NRegs_pass(root, threshold, NULL, &(labels[k][0]), cols);
+		}
+	}
+
+	/**
+	 * Free the model data (see VectorMatrixModel::releaseData()) of all the
+	 * nodes below root but the ones in keep (e.g. the regions of all the
+	 * prunes to be generated), once all the node tables have been built.
+	 * The tree topology and the positions of the leaves are kept. Returns
+	 * the number of models released.
+	 */
+	static size_t releaseModels(NodePointer root, const NodeSet& keep) {
+		size_t released = 0;
+		std::vector<NodePointer> remaining(1, root);
+		while (!remaining.empty()) {
+			NodePointer np = remaining.back();
+			remaining.pop_back();
+			if (keep.find(np) == keep.end()) {
+				np->getModel().releaseData();
+				++released;
+			}
+			if (!np->isLeaf()) {
+				remaining.push_back(np->getLeftSoon());
+				remaining.push_back(np->getRightSoon());
+			}
+		}
+		return released;
+	}
+
+	/**
+	 * Free the forest grown from the given leaves (e.g. the WRAG of a
+	 * construction aborted by an exception): the nodes below each root and
+	 * the dissimilarities still linking the roots.
+	 */
+	template<typename InputIterator>
+	static void removeForest(InputIterator first, InputIterator last) {
+		NodeSet roots, visited;
+		for (; first != last; ++first) {
+			NodePointer np = *first;
+			while (visited.insert(np).second) {
+				if (!np->getFather()) {
+					roots.insert(np);
+					break;
+				}
+				np = np->getFather();
+			}
+		}
+		// Symmetric dissimilarities are shared by both nodes
+		std::set<DissimilarityPointer> dissimilarities;
+		for (typename NodeSet::iterator it = roots.begin(); it != roots.end(); ++it) {
+			dissimilarities.insert((*it)->getDissimilarities().begin(), (*it)->getDissimilarities().end());
+			(*it)->getDissimilarities().clear();
+		}
+		for (typename std::set<DissimilarityPointer>::iterator it = dissimilarities.begin(); it != dissimilarities.end(); ++it) {
+			DissimilarityPointer diss = *it;
+			DissimilarityStoragePolicy::remove(diss);
+		}
+		for (typename NodeSet::iterator it = roots.begin(); it != roots.end(); ++it) {
+			Node::removeBPTNodes(*it);
+		}
+	}
+
+	/**
+	 * Debug validation pass of the BPT below root, with the expensive checks
+	 * not performed during the construction with a ReleaseCheckingPolicy:
+	 * each node is reached once (no cycles nor shared sons), both sons of
+	 * each merged node exist, point to it as father and have lower IDs, no
+	 * dissimilarities are left and the tree has the given number of leaves
+	 * (and 2*leaves-1 nodes). The errors found are written into log. Returns
+	 * the number of errors.
+	 */
+	static size_t validate(NodePointer root, size_t leaves, std::ostream& log = std::cerr) {
+		size_t errors = 0, nodes = 0, leafNodes = 0;
+		if (!root) {
+			log << "ERROR: The BPT root is null" << std::endl;
+			return 1;
+		}
+		if (root->getFather()) {
+			log << "ERROR: The BPT root " << root->getId() << " has a father" << std::endl;
+			++errors;
+		}
+		NodeSet visited;
+		std::vector<NodePointer> remaining(1, root);
+		while (!remaining.empty()) {
+			NodePointer np = remaining.back();
+			remaining.pop_back();
+			++nodes;
+			if (!visited.insert(np).second) {
+				log << "ERROR: Node " << np->getId() << " reached twice" << std::endl;
+				++errors;
+				continue;
+			}
+			if (!np->getDissimilarities().empty()) {
+				log << "ERROR: Node " << np->getId() << " has " << np->getDissimilarities().size() << " dissimilarities left" << std::endl;
+				++errors;
+			}
 			if (np->isLeaf()) {
-				out.insert(np);
-			}else{
-				remaining.insert(np->getLeftSoon());
-				remaining.insert(np->getRightSoon());
+				++leafNodes;
+				continue;
+			}
+			NodePointer sons[2] = {np->getLeftSoon(), np->getRightSoon()};
+			for (size_t i = 0; i < 2; ++i) {
+				if (!sons[i]) {
+					log << "ERROR: Merged node " << np->getId() << " has a single son" << std::endl;
+					++errors;
+					continue;
+				}
+				if (sons[i]->getFather() != np) {
+					log << "ERROR: Node " << sons[i]->getId() << " is not linked to its father " << np->getId() << std::endl;
+					++errors;
+				}
+				if (sons[i]->getId() >= np->getId()) {
+					log << "ERROR: Node " << sons[i]->getId() << " is not older than its father " << np->getId() << std::endl;
+					++errors;
+				}
+				remaining.push_back(sons[i]);
+			}
+		}
+		if (leafNodes != leaves || nodes != 2 * leaves - 1) {
+			log << "ERROR: The BPT has " << nodes << " nodes and " << leafNodes << " leaves, "
+					<< leaves << " leaves were expected" << std::endl;
+			++errors;
+		}
+		return errors;
+	}
+
+private:
+
+	// Ids of all the merged (non leaf) nodes below root
+	static void NRegs_merged_ids(NodePointer root, std::vector<NodeID>& ids) {
+		std::vector<NodePointer> remaining(1, root);
+		while (!remaining.empty()) {
+			NodePointer np = remaining.back();
+			remaining.pop_back();
+			if (!np->isLeaf()) {
+				ids.push_back(np->getId());
+				remaining.push_back(np->getLeftSoon());
+				remaining.push_back(np->getRightSoon());
+			}
+		}
+	}
+
+	// Lowest id of the regs-1 merged nodes with the highest ids (the ones to be split)
+	static NodeID NRegs_threshold(NodePointer root, size_t regs) {
+		if (regs == 1) return std::numeric_limits<NodeID>::max();
+		std::vector<NodeID> ids;
+		NRegs_merged_ids(root, ids);
+		if (ids.empty()) return std::numeric_limits<NodeID>::max();
+		typename std::vector<NodeID>::iterator nth = ids.begin() + std::min(regs - 2, ids.size() - 1);
+		std::nth_element(ids.begin(), nth, ids.end(), std::greater<NodeID>());
+		return *nth;
+	}
+
+	// Split the merged nodes with id >= threshold, the rest of nodes reached are the regions
+	static void NRegs_pass(NodePointer root, NodeID threshold, NodeSet* out, NodeID* labels, size_t cols) {
+		std::vector<std::pair<NodePointer, NodeID> > remaining(1, std::make_pair(root, root->getId()));
+		while (!remaining.empty()) {
+			NodePointer np = remaining.back().first;
+			const NodeID region = remaining.back().second;
+			remaining.pop_back();
+			const bool split = !np->isLeaf() && np->getId() >= threshold;
+			if (out && !split && region == np->getId()) out->insert(np);
+			if (np->isLeaf()) {
+				if (labels) labels[static_cast<size_t>(np->getModel().getDim(1)) * cols + static_cast<size_t>(np->getModel().getDim(0))] = region;
+			} else if (split || labels) {
+				remaining.push_back(std::make_pair(np->getLeftSoon(), split ? np->getLeftSoon()->getId() : region));
+				remaining.push_back(std::make_pair(np->getRightSoon(), split ? np->getRightSoon()->getId() : region));
 			}
 		}
-		out.insert(remaining.begin(), remaining.end());
-		return out;
 	}
 
 };
@@ -0,0 +1,151 @@
+/*
+ * BPTMultiDataSource.hpp
+ *
+ * Copyright (c) 2015 Alberto Alonso Gonzalez
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ *  Created on: 19/10/2026
+ *      Author: Alberto Alonso-Gonzalez
+ */
+
+#ifndef BPTMULTIDATASOURCE_HPP_
+#define BPTMULTIDATASOURCE_HPP_
+
+#include <cstddef>
+#include <stdint.h>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <tsc/policies/CheckingPolicy.hpp>
+
+namespace tscbpt
+{
+
+using namespace std;
+
+/**
+ * Data source of several per-region values at once (e.g. all the acquisition
+ * pair change measures), to generate one image per value.
+ *
+ * The VectorFunctor computes all the values of a region in a single call:
+ *	typedef ... value_type;
+ *	size_t getNOutputs() const;
+ *	void operator()(NodePointer np, value_type* out) const;
+ *
+ * The values are computed once per pruned region, and the images are written
+ * at the same time from a single pass over the pixel regions (e.g. a
+ * BPTDataSource without functor), scattering the region values into one
+ * buffered file per output.
+ */
+template<
+	typename	TNodePointer,
+	class		VectorFunctor,
+	class 		CheckingPolicy		= FullCheckingPolicy
+	>
+class BPTMultiDataSource
+{
+public:
+	typedef TNodePointer							NodePointer;
+	typedef VectorFunctor							functor_type;
+	typedef typename functor_type::value_type		value_type;
+	typedef CheckingPolicy							CheckPol;
+
+	static const size_t		DEFAULT_BUFFER_MB	= 32;
+
+	template <class PrunedSet>
+	BPTMultiDataSource(const PrunedSet& prunedSet, functor_type f = functor_type()) : _nOutputs(f.getNOutputs()) {
+		_values.resize(prunedSet.size() * _nOutputs);
+		size_t r = 0;
+		for(typename PrunedSet::const_iterator it = prunedSet.begin(); it != prunedSet.end(); ++it, ++r){
+			_index[*it] = r;
+			if(_nOutputs > 0) f(*it, &(_values[r * _nOutputs]));
+		}
+	}
+
+	size_t getNOutputs() const {
+		return _nOutputs;
+	}
+
+	size_t getNRegions() const {
+		return _index.size();
+	}
+
+	// Write one file per output, taking the region of each pixel from [first, last)
+	template<typename InputIteratorStart, typename InputIteratorEnd>
+	void writeToFiles(const vector<string>& files, InputIteratorStart first, InputIteratorEnd last, size_t bufferMB = DEFAULT_BUFFER_MB){
+		if(files.size() != _nOutputs) __throw_invalid_argument(__N("ERROR: The number of files differs from the number of outputs"));
+		vector<ofstream*> fileOut(files.size());
+		for(size_t f = 0; f < files.size(); ++f){
+			fileOut[f] = new ofstream(files[f].c_str(), ios::out | ios::trunc | ios::binary);
+		}
+		try{
+			for(size_t f = 0; f < fileOut.size(); ++f) check.ioStateOK(*(fileOut[f]));
+
+			const size_t capacity = max(static_cast<size_t>(1),
+					(max(bufferMB, static_cast<size_t>(1)) << 20) / (max(_nOutputs, static_cast<size_t>(1)) * sizeof(value_type)));
+			vector<uint32_t> regions;
+			regions.reserve(capacity);
+			vector<vector<value_type> > buffers(fileOut.size(), vector<value_type>(capacity));
+			NodePointer current = NodePointer();
+			size_t index = 0;
+			while(first != last){
+				// Region index of the next pixels (consecutive pixels usually share the region)
+				regions.clear();
+				for(; first != last && regions.size() < capacity; ++first){
+					if(regions.empty() || *first != current){
+						current = *first;
+						typename map<NodePointer, size_t>::const_iterator it = _index.find(current);
+						if(it == _index.end()) __throw_invalid_argument(__N("ERROR: Pixel region not found in the pruned set"));
+						index = it->second;
+					}
+					regions.push_back(index);
+				}
+
+				const int nFiles = static_cast<int>(fileOut.size());
+				const size_t nPixels = regions.size();
+				#pragma omp parallel for schedule(dynamic, 1)
+				for(int f = 0; f < nFiles; ++f){
+					value_type* buffer = &(buffers[f][0]);
+					for(size_t p = 0; p < nPixels; ++p){
+						buffer[p] = _values[regions[p] * _nOutputs + f];
+					}
+					fileOut[f]->write(reinterpret_cast<const char*>(buffer), nPixels * sizeof(value_type));
+				}
+				for(size_t f = 0; f < fileOut.size(); ++f) check.ioStateOK(*(fileOut[f]));
+			}
+		}catch(...){
+			closeFiles(fileOut);
+			throw;
+		}
+		closeFiles(fileOut);
+	}
+
+private:
+	size_t						_nOutputs;
+	map<NodePointer, size_t>	_index;
+	vector<value_type>			_values;
+
+	static void closeFiles(vector<ofstream*>& fileOut){
+		for(size_t f = 0; f < fileOut.size(); ++f){
+			fileOut[f]->close();
+			delete fileOut[f];
+		}
+		fileOut.clear();
+	}
+
+protected:
+	static const CheckPol		check;
+};
+
+template <typename TNodePointer, class VectorFunctor, class CheckingPolicy>
+const typename BPTMultiDataSource<TNodePointer, VectorFunctor, CheckingPolicy>::CheckPol BPTMultiDataSource<TNodePointer, VectorFunctor, CheckingPolicy>::check;
+
+}
+
+#endif /* BPTMULTIDATASOURCE_HPP_ */
@@ -39,6 +39,7 @@ class BPTNode;
 #include <vector>
 #include <stdint.h>
 #include "BPTDissimilarity.hpp"
+#include "NodeIdContext.hpp"
 #include "BPTFrame.hpp"
 #include <tsc/policies/policies.h>
 #include <boost/concept_check.hpp>
@@ -79,24 +80,24 @@ private:
     StrongNodePointer _leftSoon, _rightSoon;
     DissimilaritySet _dissimilarities;
     IDType			_id;
-    static IDType	next_id;
 
 public:
     BOOST_CONCEPT_ASSERT((boost::CopyConstructible<RegionModel>));
-    BPTNode(const RegionModel& model) :
-		_model(model), _father(NULL), _leftSoon(NULL), _rightSoon(NULL), _id(next_id++) {
+    // NOTE: The IDs are allocated by the construction of each tree (see NodeIdContext)
+    BPTNode(const RegionModel& model, IDType id) :
+		_model(model), _father(NULL), _leftSoon(NULL), _rightSoon(NULL), _id(id) {
 	}
 
     /**
      * Generic BPTNode creation
      */
     template<typename T>
-    BPTNode(T modelParam) :
-		_model(modelParam), _father(NULL), _leftSoon(NULL), _rightSoon(NULL), _id(next_id++) {
+    BPTNode(T modelParam, IDType id) :
+		_model(modelParam), _father(NULL), _leftSoon(NULL), _rightSoon(NULL), _id(id) {
 	}
 
-    BPTNode(const RegionModel& model, StrongNodePointer leftSoon, StrongNodePointer rightSoon) :
-		_model(model), _father(NULL), _leftSoon(leftSoon), _rightSoon(rightSoon), _id(next_id++) {
+    BPTNode(const RegionModel& model, StrongNodePointer leftSoon, StrongNodePointer rightSoon, IDType id) :
+		_model(model), _father(NULL), _leftSoon(leftSoon), _rightSoon(rightSoon), _id(id) {
 	}
 
     IDType getId() const {
@@ -182,28 +183,22 @@ public:
     	return !_rightSoon && !_leftSoon;
     }
 
+    // Remove all the nodes of the tree below p (iteratively, trees may be very deep)
     static void removeBPTNodes(StrongNodePointer p){
-    	if(!p->isLeaf()){
-    		removeBPTNodes(p->getLeftSoon());
-    		removeBPTNodes(p->getRightSoon());
+    	vector<StrongNodePointer> remaining(1, p);
+    	while(!remaining.empty()){
+    		StrongNodePointer np = remaining.back();
+    		remaining.pop_back();
+    		if(!np->isLeaf()){
+    			remaining.push_back(np->getLeftSoon());
+    			remaining.push_back(np->getRightSoon());
+    		}
+    		StoragePol::remove(np);
     	}
-    	StoragePol::remove(p);
     }
 
 };
 
-
-// Initialize next_it to 0 (IDs from nodes will start from 0)
-// Subsequent generated nodes will increase ID sequentially
-template
-<
-	class 					TRegionModel,
-	typename				DissimilaritySetTypeContainer,
-	typename 				TId,
-	template<class> class 	StoragePolicy
->
-TId BPTNode<TRegionModel,DissimilaritySetTypeContainer,TId, StoragePolicy>::next_id = 0;
-
 }
 
 #endif	/* _BPTNODE_HPP */
@@ -19,11 +19,13 @@
 #include "../log/Logger.hpp"
 #include "../log/ProgressDisplay.hpp"
 #include "models/ModelMerge.hpp"
+#include "NodeIdContext.hpp"
 #include <set>
 #include <vector>
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <stdexcept>
 
 namespace tscbpt
 {
@@ -33,6 +35,9 @@ using namespace std;
 /**
  * Reconstruct the BPT structure from a given merging sequence.
  * Thus, there is no need to generate dissimilarities --> faster
+ *
+ * The leaves must have the IDs 0 .. leaves - 1, the merged nodes get the
+ * following ones in merge order (as when the sequence was generated).
  */
 template <
 	class NodeStoragePolicyType,
@@ -52,6 +57,7 @@ public:
 
 	typedef typename NodeStoragePolicy::valueType::RegionModel	RegionModel;
 	typedef typename NodeStoragePolicy::valueType::IDType		IDType;
+	typedef NodeIdContext<IDType>								IdContext;
 	typedef typename NodeSet::iterator							NodeIterator;
 	typedef typename NodeSet::const_iterator 					NodeConstIterator;
 
@@ -59,10 +65,20 @@ public:
 private:
 	vector<NodePointer>	nodeId;
 	NodeSet				aliveNodes;
+	IdContext			ids;
 
 public:
 
-	BPTReconstructor(const NodeSet& leaves) {
+	BPTReconstructor(const NodeSet& leaves) : ids(leaves.size()) {
+		// Reserve space in nodeId
+		nodeId.resize(2*leaves.size() - 1);
+		for (NodeConstIterator it = leaves.begin(); it != leaves.end(); it++) {
+			aliveNodes.insert(*it);
+			nodeId.at((*it)->getId()) = *it;
+		}
+	}
+
+	BPTReconstructor(const NodeSet& leaves, const IdContext& leafIds) : ids(leafIds) {
 		// Reserve space in nodeId
 		nodeId.resize(2*leaves.size() - 1);
 		for (NodeConstIterator it = leaves.begin(); it != leaves.end(); it++) {
@@ -73,6 +89,17 @@ public:
 
 	template<typename InputIterator1, typename InputIterator2>
 	BPTReconstructor(InputIterator1 first, InputIterator2 last) {
+		for (; first != last; ++first) {
+			aliveNodes.insert(*first);
+			nodeId.push_back(*first);
+			this->errorAssert(nodeId.at((*first)->getId()) == *first);
+		}
+		ids.reset(nodeId.size());
+		nodeId.resize(2*nodeId.size() - 1);
+	}
+
+	template<typename InputIterator1, typename InputIterator2>
+	BPTReconstructor(InputIterator1 first, InputIterator2 last, const IdContext& leafIds) : ids(leafIds) {
 		for (; first != last; ++first) {
 			aliveNodes.insert(*first);
 			nodeId.push_back(*first);
@@ -112,28 +139,43 @@ public:
 				this->errorLog("ERROR: Unexpected IO error!!!!");
 			}
 
-			NodePointer nodea = nodeId.at(ida); // Get nodes from the merging sequence input
-			NodePointer nodeb = nodeId.at(idb);
-
-			if(this->errorCheck(nodea==NULL || nodeb==NULL)){
-				this->errorLog("ERROR: Selected nodes for merging do not exist!!!! (Maybe caused by a wrong merging sequence source)");
-				this->errorLog(string("\tida: ") + to_string(ida) + "\tidb" + to_string(idb));
+			// NOTE: The O(1) checks of the input IDs are performed whatever the checking policy (only
+			// the logging depends on it), so that a wrong merging sequence never corrupts the memory
+			if(ida >= nodeId.size() || idb >= nodeId.size()){
+				if(this->errorCheck(true)) this->errorLog(string("\tida: ") + to_string(ida) + "\tidb" + to_string(idb));
+				std::__throw_out_of_range(__N("ERROR: Node ID out of range!!!! (Maybe caused by a wrong merging sequence source)"));
 			}
-			if(this->errorCheck(nodea->getFather() || nodeb->getFather())){
-				this->errorLog("ERROR: Selected nodes already merged!!!!");
-				this->errorLog(string("nodea merged: \t") + to_string(nodea->getFather()));
-				this->errorLog(string("nodeb merged: \t") + to_string(nodeb->getFather()));
+			NodePointer nodea = nodeId[ida]; // Get nodes from the merging sequence input
+			NodePointer nodeb = nodeId[idb];
+
+			if(nodea==NULL || nodeb==NULL){
+				if(this->errorCheck(true)){
+					this->errorLog("ERROR: Selected nodes for merging do not exist!!!! (Maybe caused by a wrong merging sequence source)");
+					this->errorLog(string("\tida: ") + to_string(ida) + "\tidb" + to_string(idb));
+				}
+				std::__throw_out_of_range(__N("ERROR: Selected nodes for merging do not exist!!!! (Maybe caused by a wrong merging sequence source)"));
+			}
+			if(nodea->getFather() || nodeb->getFather() || nodea == nodeb){
+				if(this->errorCheck(true)){
+					this->errorLog("ERROR: Selected nodes already merged!!!!");
+					this->errorLog(string("nodea merged: \t") + to_string(nodea->getFather()));
+					this->errorLog(string("nodeb merged: \t") + to_string(nodeb->getFather()));
+				}
+				std::__throw_invalid_argument(__N("ERROR: Selected nodes already merged!!!! (Maybe caused by a wrong merging sequence source)"));
 			}
 
 			aliveNodes.erase(nodea); // Remove nodes from alive nodes
 			aliveNodes.erase(nodeb);
 
 			// Generate father node by fusion of nodea and nodeb
-			NodePointer father = NodeStoragePolicy::create(merge(nodea, nodeb), nodea, nodeb);
+			NodePointer father = NodeStoragePolicy::create(merge(nodea, nodeb), nodea, nodeb, ids.merged());
 			nodea->setFather(father);
 			nodeb->setFather(father);
 
-			nodeId.at(father->getId()) = father;
+			if(father->getId() >= nodeId.size()){
+				std::__throw_out_of_range(__N("ERROR: Father node ID out of range!!!!"));
+			}
+			nodeId[father->getId()] = father;
 
 			aliveNodes.insert(father);
 
@@ -16,9 +16,13 @@
 #define DENSEWRAGGENERATOR_HPP_
 
 #include <vector>
+#include <algorithm>
 #include "../policies/Storage.hpp"
 #include "../policies/CheckingPolicy.hpp"
+#include "NodeIdContext.hpp"
 #include <tsc/log/log.h>
+#include <tsc/image/Pixel.hpp>
+#include <tsc/util/types/StridedArrayRef.hpp>
 
 namespace tscbpt
 {
@@ -50,6 +54,7 @@ public:
 	typedef std::vector<Size>								SizeVector;
 	typedef std::vector<RelPos>								RelPosVector;
 	typedef CheckingPolicy									CheckPol;
+	typedef NodeIdContext<typename Node::IDType>			IdContext;
 
 public:
 
@@ -59,7 +64,7 @@ public:
 		setTotal();
 		_data.reserve(_totalSize);
 		for(; first != last; ++first)
-			_data.push_back(NodeStoragePol::create(*first));
+			_data.push_back(NodeStoragePol::create(*first, _ids.leaf(_data.size())));
 		Check.sizeMatches(_data.size(), _dimensions);
 	}
 
@@ -69,7 +74,7 @@ public:
 		setTotal();
 		_data.reserve(_totalSize);
 		for (; first != last; ++first)
-			_data.push_back(NodeStoragePol::create(*first));
+			_data.push_back(NodeStoragePol::create(*first, _ids.leaf(_data.size())));
 		Check.sizeMatches(_data.size(), _dimensions);
 	}
 
@@ -80,7 +85,7 @@ public:
 		setTotal();
 		_data.reserve(_totalSize);
 		for (; first != last; ++first)
-			_data.push_back(NodeStoragePol::create(*first));
+			_data.push_back(NodeStoragePol::create(*first, _ids.leaf(_data.size())));
 		Check.sizeMatches(_data.size(), _dimensions);
 	}
 
@@ -92,7 +97,63 @@ public:
 		setTotal();
 		_data.reserve(_totalSize);
 		for (; first != last; ++first)
-			_data.push_back(NodeStoragePol::create(*first));
+			_data.push_back(NodeStoragePol::create(*first, _ids.leaf(_data.size())));
+		Check.sizeMatches(_data.size(), _dimensions);
+	}
+
+	/**
+	 * Bulk construction of the leaves of a 2D dataset, faster than the pixel
+	 * iterators, from a reader giving strips of planar data (like
+	 * MultiFileBlockReader::getStrip()). The leaves are allocated by blocks
+	 * of rows, in pixel order (as with the iterators). Then the rows of the
+	 * block are converted in parallel to scattering vectors with SOperator::planar() and the leaf
+	 * models are computed directly into the nodes.
+	 * The region model must be default constructible and constructible
+	 * from a 2D Pixel of StridedArrayRef (like VectorMatrixModel).
+	 */
+	template<class StripReader, class SOperator>
+	DenseWRAGGenerator(StripReader& reader, SOperator) {
+		typedef typename StripReader::value_type::value_type	DataType;
+		typedef typename Node::RegionModel						RegionModel;
+		typedef StridedArrayRef<DataType>						ScatteringVectorRef;
+		typedef Pixel<ScatteringVectorRef, 2>					LeafPixel;
+
+		const Size cols = reader.getCols();
+		_dimensions.push_back(reader.getRows());
+		_dimensions.push_back(cols);
+		setTotal();
+		_data.reserve(_totalSize);
+
+		const Size nfiles = reader.getNFiles();
+		const Size channels = SOperator::outputChannels(nfiles);
+		const Size blockRows = max(static_cast<Size>(1), LEAF_BLOCK_PIXELS / cols);
+		const RegionModel emptyModel = RegionModel();
+		for(Size strip = 0; strip < reader.getNStrips(); ++strip){
+			const DataType* data = reader.getStrip(strip);
+			const Size planeSize = reader.getPlaneSize();
+			const Size stripHeight = reader.getStripHeight(strip);
+			for(Size blockRow = 0; blockRow < stripHeight; blockRow += blockRows){
+				const Size first = _data.size();
+				const Size nrows = min(blockRows, stripHeight - blockRow);
+				for(Size i = 0; i < nrows * cols; ++i)
+					_data.push_back(NodeStoragePol::template create<const RegionModel&>(emptyModel, _ids.leaf(_data.size())));
+
+				#pragma omp parallel
+				{
+					vector<DataType> vectors(channels * cols);
+					#pragma omp for schedule(static)
+					for(int r = 0; r < static_cast<int>(nrows); ++r){
+						SOperator::planar(data + (blockRow + r) * cols, planeSize, &(vectors[0]), cols, nfiles, cols);
+						const Size leaf = first + r * cols;
+						const float row = static_cast<float>(leaf / cols);
+						for(Size c = 0; c < cols; ++c){
+							LeafPixel pixel(ScatteringVectorRef(&(vectors[c]), channels, cols), static_cast<float>(c), row);
+							_data[leaf + c]->getModel() = RegionModel(pixel);
+						}
+					}
+				}
+			}
+		}
 		Check.sizeMatches(_data.size(), _dimensions);
 	}
 
@@ -703,17 +764,27 @@ public:
 		return _data;
 	}
 
+	// IDs of the tree: the leaves have the pixel indices, to be passed to the BPT constructor
+	const IdContext& getIdContext() const {
+		return _ids;
+	}
+
 
 protected:
 	SizeVector				_dimensions;
 	NodePointerVector		_data;
 	Size					_totalSize;
+	IdContext				_ids;
 	static CheckPol			Check;
 
+	// Leaves initialized in each parallel block of the bulk construction (approximately)
+	static const Size		LEAF_BLOCK_PIXELS	= 16384;
+
 	void setTotal(){
 		_totalSize = _dimensions.at(0);
 		for (Size i = 1; i < _dimensions.size(); i++)
 			_totalSize *= _dimensions[i];
+		_ids.reset(_totalSize);
 	}
 
 	template<class DissimilarityMeasure, typename Pos>
@@ -755,6 +826,13 @@ template<
 >
 CheckingPolicy DenseWRAGGenerator<StoredType, PtrStoragePolicy, CheckingPolicy>::Check = CheckingPolicy();
 
+template<
+	typename StoredType,
+	template<class> class PtrStoragePolicy,
+	class CheckingPolicy
+>
+const size_t DenseWRAGGenerator<StoredType, PtrStoragePolicy, CheckingPolicy>::LEAF_BLOCK_PIXELS;
+
 }
 
 #endif /* DENSEWRAGGENERATOR_HPP_ */
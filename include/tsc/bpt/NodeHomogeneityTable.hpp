@@ -0,0 +1,93 @@
+/*
+ * NodeHomogeneityTable.hpp
+ *
+ * Copyright (c) 2015 Alberto Alonso Gonzalez
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ *  Created on: 19/10/2026
+ *      Author: Alberto Alonso-Gonzalez
+ */
+
+#ifndef NODEHOMOGENEITYTABLE_HPP_
+#define NODEHOMOGENEITYTABLE_HPP_
+
+#include <cstddef>
+#include <vector>
+
+namespace tscbpt
+{
+
+/**
+ * Homogeneity of each BPT node, as computed by HomogOp over the node model,
+ * stored in an array indexed by node id (the node ids of a BPT are
+ * consecutive, starting from 0).
+ *
+ * It is computed once for the whole tree, so that the prune criteria
+ * accepting a table (e.g. RelErrorHomogeneityPruneCriterion) read one value
+ * per visited node instead of accessing its model.
+ */
+template <class HomogOp>
+class NodeHomogeneityTable
+{
+public:
+	typedef HomogOp									homogeneity_operator;
+	typedef typename HomogOp::ParameterValueType	value_type;
+
+	NodeHomogeneityTable(HomogOp op = HomogOp()) : _op(op) {}
+
+	// Compute the homogeneity of all the nodes of the tree below root (included)
+	template <typename NodePointer>
+	void build(NodePointer root){
+		std::vector<NodePointer> nodes;
+		std::vector<NodePointer> remaining(1, root);
+		size_t maxId = 0;
+		while(!remaining.empty()){
+			NodePointer np = remaining.back();
+			remaining.pop_back();
+			nodes.push_back(np);
+			if(np->getId() > maxId) maxId = np->getId();
+			if(!np->isLeaf()){
+				remaining.push_back(np->getLeftSoon());
+				remaining.push_back(np->getRightSoon());
+			}
+		}
+		if(_values.size() <= maxId) _values.resize(maxId + 1);
+
+		const int n = static_cast<int>(nodes.size());
+		#pragma omp parallel for schedule(static)
+		for(int i = 0; i < n; ++i){
+			_values[nodes[i]->getId()] = _op(nodes[i]->getModel());
+		}
+	}
+
+	// Add the homogeneity of a single node (e.g. on creation)
+	template <typename NodePointer>
+	void add(NodePointer np){
+		if(_values.size() <= np->getId()) _values.resize(np->getId() + 1);
+		_values[np->getId()] = _op(np->getModel());
+	}
+
+	value_type operator[](size_t id) const {
+		return _values[id];
+	}
+
+	size_t size() const {
+		return _values.size();
+	}
+
+	void clear(){
+		std::vector<value_type>().swap(_values);
+	}
+
+private:
+	HomogOp						_op;
+	std::vector<value_type>		_values;
+};
+
+}
+
+#endif /* NODEHOMOGENEITYTABLE_HPP_ */
@@ -0,0 +1,83 @@
+/*
+ * NodeIdContext.hpp
+ *
+ * Copyright (c) 2015 Alberto Alonso Gonzalez
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ *  Created on: 19/10/2026
+ *      Author: Alberto Alonso-Gonzalez
+ */
+
+#ifndef NODEIDCONTEXT_HPP_
+#define NODEIDCONTEXT_HPP_
+
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+
+namespace tscbpt
+{
+
+/**
+ * Allocation of the node IDs of a BPT, owned by its construction instead
+ * of being shared by all the trees of the process: the leaves get their
+ * index (the pixel index row * cols + col of a 2D dataset, see
+ * DenseWRAGGenerator) and the merged nodes consecutive IDs after the
+ * leaves, in merge order.
+ *
+ * Every tree has then the IDs 0 .. 2 * leaves - 2 (as expected by
+ * BPTReconstructor, the node tables and the BPT.tree files), whatever other
+ * trees were built before or are being built concurrently by other threads,
+ * each one with its own context. The context is passed by value from the
+ * WRAG generator to the BPT constructor (see getIdContext()).
+ */
+template<typename IDType>
+class NodeIdContext
+{
+public:
+	typedef IDType		id_type;
+
+	explicit NodeIdContext(size_t leaves = 0) {
+		reset(leaves);
+	}
+
+	// ID of the leaf with the given index
+	IDType leaf(size_t index) const {
+		return static_cast<IDType>(index);
+	}
+
+	// ID of the next merged node
+	IDType merged() {
+		return _next++;
+	}
+
+	// Restart the context for a tree with the given number of leaves
+	void reset(size_t leaves){
+		if(leaves > 0 && 2 * leaves - 1 > static_cast<size_t>(std::numeric_limits<IDType>::max())){
+			std::__throw_overflow_error(__N("ERROR: The node IDs of the BPT exceed the range of its ID type"));
+		}
+		_leaves = leaves;
+		_next = static_cast<IDType>(leaves);
+	}
+
+	size_t getLeaves() const {
+		return _leaves;
+	}
+
+	// Number of IDs allocated (leaves and merged nodes)
+	size_t size() const {
+		return _next;
+	}
+
+private:
+	size_t		_leaves;
+	IDType		_next;
+};
+
+}
+
+#endif /* NODEIDCONTEXT_HPP_ */
@@ -0,0 +1,154 @@
+/*
+ * NodeLeafOrder.hpp
+ *
+ * Copyright (c) 2015 Alberto Alonso Gonzalez
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ *  Created on: 19/10/2026
+ *      Author: Alberto Alonso-Gonzalez
+ */
+
+#ifndef NODELEAFORDER_HPP_
+#define NODELEAFORDER_HPP_
+
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+namespace tscbpt
+{
+
+/**
+ * Depth first ordering of the leaves of a BPT, computed once after its
+ * construction: the pixels (row * cols + col) of the leaves in DFS order,
+ * and for each node (indexed by node id) the contiguous range of this
+ * permutation holding the pixels of its leaves.
+ *
+ * The pixels of any region (e.g. of a pruned set) are then enumerated as a
+ * slice of the permutation, without traversing its subtree, so that rasters
+ * are generated with a streaming scatter (see BPTDataSource) and region crops
+ * are extracted in O(region pixels).
+ *
+ * The leaves must provide their pixel position (getDim(0) column, getDim(1)
+ * row) through their model.
+ */
+class NodeLeafOrder
+{
+public:
+	typedef const uint32_t*		pixel_iterator;
+
+	NodeLeafOrder() : _rows(0), _cols(0){}
+
+	// Compute the leaf ordering of the tree below root (included)
+	template <typename NodePointer>
+	void build(NodePointer root, size_t rows, size_t cols){
+		_rows = rows;
+		_cols = cols;
+		_pixels.clear();
+		_pixels.reserve(rows * cols);
+
+		// Preorder (left son first): the first leaf of each node
+		std::vector<NodePointer> preorder;
+		std::vector<NodePointer> remaining(1, root);
+		size_t maxId = 0;
+		while(!remaining.empty()){
+			NodePointer np = remaining.back();
+			remaining.pop_back();
+			preorder.push_back(np);
+			if(np->getId() > maxId) maxId = np->getId();
+			if(np->isLeaf()){
+				const size_t row = static_cast<size_t>(np->getModel().getDim(1)), col = static_cast<size_t>(np->getModel().getDim(0));
+				if(row >= rows || col >= cols) std::__throw_out_of_range(__N("ERROR: BPT leaf position out of the image"));
+				_pixels.push_back(row * cols + col);
+			}else{
+				remaining.push_back(np->getRightSoon());
+				remaining.push_back(np->getLeftSoon());
+			}
+		}
+		if(_pixels.size() != rows * cols) std::__throw_invalid_argument(__N("ERROR: The number of BPT leaves differs from rows x cols"));
+
+		// Ranges, in reverse preorder (sons before their father)
+		_first.assign(maxId + 1, 0);
+		_last.assign(maxId + 1, 0);
+		uint32_t next = static_cast<uint32_t>(_pixels.size());
+		for(size_t i = preorder.size(); i-- > 0;){
+			const NodePointer& np = preorder[i];
+			if(np->isLeaf()){
+				_last[np->getId()] = next;
+				_first[np->getId()] = --next;
+			}else{
+				_first[np->getId()] = _first[np->getLeftSoon()->getId()];
+				_last[np->getId()] = _last[np->getRightSoon()->getId()];
+			}
+		}
+	}
+
+	// Pixels of the leaves of the node with the given id
+	pixel_iterator begin(size_t id) const {
+		return &(_pixels[0]) + _first[id];
+	}
+
+	pixel_iterator end(size_t id) const {
+		return &(_pixels[0]) + _last[id];
+	}
+
+	size_t getNPixels(size_t id) const {
+		return _last[id] - _first[id];
+	}
+
+	/**
+	 * Crop of the image containing the region of the node with the given id
+	 * (its bounding box), with mask set to 1 for its pixels (row major,
+	 * height x width)
+	 */
+	void getCrop(size_t id, size_t& row, size_t& col, size_t& height, size_t& width, std::vector<unsigned char>& mask) const {
+		size_t minRow = _rows, minCol = _cols, maxRow = 0, maxCol = 0;
+		for(pixel_iterator p = begin(id); p != end(id); ++p){
+			minRow = std::min(minRow, static_cast<size_t>(*p / _cols));
+			maxRow = std::max(maxRow, static_cast<size_t>(*p / _cols));
+			minCol = std::min(minCol, static_cast<size_t>(*p % _cols));
+			maxCol = std::max(maxCol, static_cast<size_t>(*p % _cols));
+		}
+		row = minRow;
+		col = minCol;
+		height = maxRow - minRow + 1;
+		width = maxCol - minCol + 1;
+		mask.assign(height * width, 0);
+		for(pixel_iterator p = begin(id); p != end(id); ++p){
+			mask[(*p / _cols - row) * width + (*p % _cols - col)] = 1;
+		}
+	}
+
+	size_t getRows() const {
+		return _rows;
+	}
+
+	size_t getCols() const {
+		return _cols;
+	}
+
+	bool empty() const {
+		return _pixels.empty();
+	}
+
+	void clear(){
+		std::vector<uint32_t>().swap(_pixels);
+		std::vector<uint32_t>().swap(_first);
+		std::vector<uint32_t>().swap(_last);
+	}
+
+private:
+	size_t					_rows, _cols;
+	std::vector<uint32_t>	_pixels;
+	std::vector<uint32_t>	_first, _last;
+};
+
+}
+
+#endif /* NODELEAFORDER_HPP_ */
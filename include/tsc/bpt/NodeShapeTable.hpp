@@ -0,0 +1,164 @@
+/*
+ * NodeShapeTable.hpp
+ *
+ * Copyright (c) 2015 Alberto Alonso Gonzalez
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ *  Created on: 19/10/2026
+ *      Author: Alberto Alonso-Gonzalez
+ */
+
+#ifndef NODESHAPETABLE_HPP_
+#define NODESHAPETABLE_HPP_
+
+#include <cstddef>
+#include <stdint.h>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+namespace tscbpt
+{
+
+/**
+ * Bounding box and perimeter of each BPT node, stored in an array indexed by
+ * node id (the node ids of a BPT are consecutive, starting from 0).
+ *
+ * They are accumulated bottom-up replaying the merges in merging order (node
+ * id order), so that they are obtained for all the nodes without scanning the
+ * pixels of each region. The perimeter is the number of pixel sides in the
+ * region boundary (4-connectivity, the image borders included): when two
+ * regions are merged, the sides shared between them are found iterating the
+ * pixels of the smallest one, so the whole tree costs O(N log N).
+ *
+ * The leaves must provide their pixel position (getDim(0) column, getDim(1)
+ * row) through their model.
+ */
+class NodeShapeTable
+{
+public:
+	struct Shape
+	{
+		uint32_t	minRow, minCol, maxRow, maxCol;		// Bounding box (inclusive)
+		uint64_t	perimeter;
+	};
+
+	NodeShapeTable() : _rows(0), _cols(0){}
+
+	// Compute the shape of all the nodes of the tree below root (included)
+	template <typename NodePointer>
+	void build(NodePointer root, size_t rows, size_t cols){
+		static const uint32_t NONE = 0xFFFFFFFF;
+		_rows = rows;
+		_cols = cols;
+
+		// Sons of the merged nodes and pixel of the leaves, by node id
+		std::vector<uint32_t> left, right, pixel;
+		std::vector<uint32_t> merged;
+		std::vector<NodePointer> remaining(1, root);
+		while(!remaining.empty()){
+			NodePointer np = remaining.back();
+			remaining.pop_back();
+			const size_t id = np->getId();
+			if(left.size() <= id){
+				left.resize(id + 1, NONE);
+				right.resize(id + 1, NONE);
+				pixel.resize(id + 1, NONE);
+			}
+			if(np->isLeaf()){
+				const size_t row = static_cast<size_t>(np->getModel().getDim(1)), col = static_cast<size_t>(np->getModel().getDim(0));
+				if(row >= rows || col >= cols) std::__throw_out_of_range(__N("ERROR: BPT leaf position out of the image"));
+				pixel[id] = row * cols + col;
+			}else{
+				left[id] = np->getLeftSoon()->getId();
+				right[id] = np->getRightSoon()->getId();
+				merged.push_back(id);
+				remaining.push_back(np->getLeftSoon());
+				remaining.push_back(np->getRightSoon());
+			}
+		}
+		std::sort(merged.begin(), merged.end());
+
+		_shapes.assign(left.size(), Shape());
+		// Per set of pixels (merged region): owner set of each pixel, linked
+		// list of its pixels and number of pixels
+		std::vector<uint32_t> owner(rows * cols, NONE), next(rows * cols, NONE), tail(rows * cols, NONE), npixels(rows * cols, 0);
+		std::vector<uint32_t> region(left.size(), NONE);
+		std::vector<uint64_t> internal(left.size(), 0);
+		for(size_t id = 0; id < pixel.size(); ++id){
+			const uint32_t p = pixel[id];
+			if(p == NONE) continue;
+			if(owner[p] != NONE) std::__throw_invalid_argument(__N("ERROR: Repeated BPT leaf position"));
+			owner[p] = tail[p] = p;
+			npixels[p] = 1;
+			region[id] = p;
+			Shape& s = _shapes[id];
+			s.minRow = s.maxRow = p / cols;
+			s.minCol = s.maxCol = p % cols;
+			s.perimeter = 4;
+		}
+
+		for(size_t m = 0; m < merged.size(); ++m){
+			const uint32_t id = merged[m];
+			uint32_t small = region[left[id]], big = region[right[id]];
+			if(npixels[small] > npixels[big]) std::swap(small, big);
+
+			// Sides shared between both sons, moving the pixels of the smallest one
+			uint64_t shared = 0;
+			for(uint32_t p = small; p != NONE; p = next[p]){
+				const size_t row = p / cols, col = p % cols;
+				if(row > 0 && owner[p - cols] == big) ++shared;
+				if(row + 1 < rows && owner[p + cols] == big) ++shared;
+				if(col > 0 && owner[p - 1] == big) ++shared;
+				if(col + 1 < cols && owner[p + 1] == big) ++shared;
+			}
+			for(uint32_t p = small; p != NONE; p = next[p]) owner[p] = big;
+			next[tail[big]] = small;
+			tail[big] = tail[small];
+			npixels[big] += npixels[small];
+			region[id] = big;
+
+			internal[id] = internal[left[id]] + internal[right[id]] + shared;
+			const Shape& a = _shapes[left[id]];
+			const Shape& b = _shapes[right[id]];
+			Shape& s = _shapes[id];
+			s.minRow = std::min(a.minRow, b.minRow);
+			s.minCol = std::min(a.minCol, b.minCol);
+			s.maxRow = std::max(a.maxRow, b.maxRow);
+			s.maxCol = std::max(a.maxCol, b.maxCol);
+			s.perimeter = 4 * static_cast<uint64_t>(npixels[big]) - 2 * internal[id];
+		}
+	}
+
+	const Shape& operator[](size_t id) const {
+		return _shapes[id];
+	}
+
+	size_t size() const {
+		return _shapes.size();
+	}
+
+	size_t getRows() const {
+		return _rows;
+	}
+
+	size_t getCols() const {
+		return _cols;
+	}
+
+	void clear(){
+		std::vector<Shape>().swap(_shapes);
+	}
+
+private:
+	size_t				_rows, _cols;
+	std::vector<Shape>	_shapes;
+};
+
+}
+
+#endif /* NODESHAPETABLE_HPP_ */
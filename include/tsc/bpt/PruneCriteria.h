@@ -19,21 +19,52 @@
 #include <cmath>
 #include <boost/concept_check.hpp>
 #include <tsc/bpt/models/concepts/HasLogDetAverage.h>
+#include "NodeHomogeneityTable.hpp"
 
 namespace tscbpt{
 
 template <typename HomogType = double>
-struct RelErrorHomogeneityPruneCriterion{
+struct RelativeMSEHomogeneityOperator{
+	typedef HomogType		ParameterValueType;
+
+	template<typename RegionModel>
+	HomogType operator()(const RegionModel& model) const {
+		static const HomogType MIN_NORM_THRESHOLD = 1e-12;
+		return model.getTotalSumOfSquares() / max(norm2(model), MIN_NORM_THRESHOLD) / model.getSubnodes();
+	}
+};
+
+template <typename HomogType = double>
+struct LogDetAverageHomogeneityOperator{
 	typedef HomogType		ParameterValueType;
 
-	RelErrorHomogeneityPruneCriterion(HomogType pruneFactordB) : pruneFactor(std::pow(10.0, pruneFactordB/10.0)) {}
+	template<typename RegionModel>
+	HomogType operator()(const RegionModel& model) const {
+		BOOST_CONCEPT_ASSERT( (concept::HasLogDetAverage< RegionModel > ) );
+		return model.getLogDetAverage();
+	}
+};
+
+template <typename HomogType = double>
+struct RelErrorHomogeneityPruneCriterion{
+	typedef HomogType		ParameterValueType;
+	typedef NodeHomogeneityTable<RelativeMSEHomogeneityOperator<HomogType> >	HomogeneityTable;
+
+	/**
+	 * If a homogeneity table of the tree is given, the homogeneity of the
+	 * nodes is read from it instead of being computed from their models
+	 */
+	RelErrorHomogeneityPruneCriterion(HomogType pruneFactordB, const HomogeneityTable* table = NULL) :
+		pruneFactor(std::pow(10.0, pruneFactordB/10.0)), homogTable(table) {}
 	template<typename NodePointer>
 	bool operator()(NodePointer np){
 		static const HomogType MIN_NORM_THRESHOLD = 1e-12;
+		if(homogTable) return (*homogTable)[np->getId()] < pruneFactor;
 		return np->getModel().getTotalSumOfSquares() / max(norm2(np->getModel()), MIN_NORM_THRESHOLD) / np->getModel().getSubnodes() < pruneFactor;
 	}
 private:
 	HomogType pruneFactor;
+	const HomogeneityTable* homogTable;
 };
 
 template <typename HomogType = double>
@@ -53,26 +84,19 @@ template <typename HomogType = double>
 struct LogDetPruneCriterion{
 	typedef HomogType		ParameterValueType;
 	typedef HomogType		homogeneity_value;
+	typedef NodeHomogeneityTable<LogDetAverageHomogeneityOperator<HomogType> >	HomogeneityTable;
 
-	LogDetPruneCriterion(HomogType pruneFactordB) : pruneFactor(std::pow(10.0, pruneFactordB/10.0)) {}
+	LogDetPruneCriterion(HomogType pruneFactordB, const HomogeneityTable* table = NULL) :
+		pruneFactor(std::pow(10.0, pruneFactordB/10.0)), homogTable(table) {}
 	template<typename NodePointer>
 	bool operator()(NodePointer np){
+		if(homogTable) return (*homogTable)[np->getId()] < pruneFactor;
 		BOOST_CONCEPT_ASSERT( (concept::HasLogDetAverage< typeof(np->getModel()) > ) );
 		return np->getModel().getLogDetAverage() < pruneFactor;
 	}
 private:
 	HomogType pruneFactor;
-};
-
-template <typename HomogType = double>
-struct RelativeMSEHomogeneityOperator{
-	typedef HomogType		ParameterValueType;
-
-	template<typename RegionModel>
-	HomogType operator()(RegionModel model){
-		static const HomogType MIN_NORM_THRESHOLD = 1e-12;
-		return model.getTotalSumOfSquares() / max(norm2(model), MIN_NORM_THRESHOLD) / model.getSubnodes();
-	}
+	const HomogeneityTable* homogTable;
 };
 
 template <typename HomogType = double>
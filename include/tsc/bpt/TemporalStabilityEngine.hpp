@@ -0,0 +1,247 @@
+/*
+ * TemporalStabilityEngine.hpp
+ *
+ * Copyright (c) 2015 Alberto Alonso Gonzalez
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ *  Created on: 19/10/2026
+ *      Author: Alberto Alonso-Gonzalez
+ */
+
+#ifndef TEMPORALSTABILITYENGINE_HPP_
+#define TEMPORALSTABILITYENGINE_HPP_
+
+#include <armadillo>
+#include <cmath>
+#include <vector>
+#include <map>
+#include <functional>
+#include <algorithm>
+#include <tsc/util/ArmadilloWrapper.hpp>
+
+namespace tscbpt
+{
+
+/**
+ * Geodesic distance between two Hermitian positive definite matrices:
+ * sqrt(sum(log(lambda)^2)), lambda being the generalized eigenvalues of (b, a).
+ *
+ * With the Cholesky factorization a = R^H R the problem is reduced to the
+ * Hermitian matrix R^-H b R^-1, which has the same eigenvalues as a^-1 b.
+ * If a is not positive definite (e.g. a zero filled region) it falls back to
+ * the general eigenvalue problem, as GeodesicVectorPairChangeMeasure does.
+ */
+inline double hermitianGeodesicDistance(const arma::cx_mat& a, const arma::cx_mat& b){
+	arma::cx_mat r;
+	if(arma::chol(r, a)){
+		const arma::cx_mat rh = arma::htrans(r);
+		arma::cx_mat m = arma::htrans(arma::solve(rh, arma::htrans(arma::solve(rh, b))));
+		m = (m + arma::htrans(m)) / 2.0;
+		arma::vec eigval;
+		if(arma::eig_sym(eigval, m)){
+			double res = 0;
+			for(size_t k = 0; k < eigval.n_elem; ++k){
+				const double l = std::log(std::abs(eigval[k]));
+				res += l * l;
+			}
+			return std::sqrt(res);
+		}
+	}
+	arma::cx_vec eigval;
+	arma::cx_mat eigvec;
+	arma::eig_gen(eigval, eigvec, arma::solve(a, b));
+	return std::sqrt(arma::accu(arma::pow(arma::log(arma::abs(eigval)), 2)));
+}
+
+/**
+ * Temporal stability of the regions of a pruned BPT.
+ *
+ * For each region it computes, in a single pass, the geodesic distance of all
+ * the acquisition pairs, from which GEIG (GeodesicVectorChangeMeasureFull),
+ * DG (DiagonalGeodesicVectorChangeMeasureFull) and the pair values
+ * (GeodesicVectorPairChangeMeasure) are obtained. The regions of a prune are
+ * evaluated in parallel and the results are cached by node, so the regions
+ * surviving from a prune level to the next one are not computed again.
+ *
+ * Usage: call evaluate() with the pruned set, then use the GEIG, DG and Pair
+ * functors (e.g. with BPTDataSource) to access the results, or the Pairs
+ * functor with BPTMultiDataSource to write all the pair images at once.
+ */
+template <class TNodePointer, class ValueType = double>
+class TemporalStabilityEngine
+{
+public:
+	typedef TNodePointer		NodePointer;
+	typedef ValueType			value_type;
+
+	struct Result
+	{
+		value_type				geig;
+		value_type				dg;
+		std::vector<value_type>	pairs;
+	};
+
+	typedef std::map<NodePointer, Result>	cache_type;
+
+	struct GEIG: public std::unary_function<NodePointer, value_type>
+	{
+		GEIG(const TemporalStabilityEngine& e): engine(&e){}
+		value_type operator()(NodePointer np) const {
+			return engine->getResult(np).geig;
+		}
+	private:
+		const TemporalStabilityEngine* engine;
+	};
+
+	struct DG: public std::unary_function<NodePointer, value_type>
+	{
+		DG(const TemporalStabilityEngine& e): engine(&e){}
+		value_type operator()(NodePointer np) const {
+			return engine->getResult(np).dg;
+		}
+	private:
+		const TemporalStabilityEngine* engine;
+	};
+
+	struct Pair: public std::unary_function<NodePointer, value_type>
+	{
+		Pair(const TemporalStabilityEngine& e, size_t i, size_t j): engine(&e), index(e.getPairIndex(i, j)){}
+		value_type operator()(NodePointer np) const {
+			return engine->getResult(np).pairs[index];
+		}
+	private:
+		const TemporalStabilityEngine* engine;
+		size_t index;
+	};
+
+	// All the pair values of a region at once (for BPTMultiDataSource)
+	struct Pairs
+	{
+		typedef TemporalStabilityEngine::value_type		value_type;
+
+		Pairs(const TemporalStabilityEngine& e): engine(&e){}
+		size_t getNOutputs() const {
+			return engine->_covariances * (engine->_covariances - 1) / 2;
+		}
+		void operator()(NodePointer np, value_type* out) const {
+			const std::vector<value_type>& pairs = engine->getResult(np).pairs;
+			std::copy(pairs.begin(), pairs.end(), out);
+		}
+	private:
+		const TemporalStabilityEngine* engine;
+	};
+
+	TemporalStabilityEngine(size_t covariances, bool keepPairs = true) :
+		_covariances(covariances), _keepPairs(keepPairs), _computed(0), _reused(0) {}
+
+	// Compute the results of the regions not already in the cache
+	template <class NodeSet>
+	void evaluate(const NodeSet& regions){
+		std::vector<NodePointer> pending;
+		for(typename NodeSet::const_iterator it = regions.begin(); it != regions.end(); ++it){
+			if(_cache.find(*it) == _cache.end()) pending.push_back(*it);
+		}
+		_reused += regions.size() - pending.size();
+		_computed += pending.size();
+
+		std::vector<Result> results(pending.size());
+		const int n = static_cast<int>(pending.size());
+		#pragma omp parallel for schedule(dynamic, 1)
+		for(int r = 0; r < n; ++r){
+			compute(pending[r], results[r]);
+		}
+		for(size_t r = 0; r < pending.size(); ++r){
+			_cache[pending[r]].geig = results[r].geig;
+			_cache[pending[r]].dg = results[r].dg;
+			_cache[pending[r]].pairs.swap(results[r].pairs);
+		}
+	}
+
+	const Result& getResult(NodePointer np) const {
+		typename cache_type::const_iterator it = _cache.find(np);
+		if(it == _cache.end()) __throw_invalid_argument(__N("ERROR: Region not evaluated by the TemporalStabilityEngine"));
+		return it->second;
+	}
+
+	GEIG geig() const {
+		return GEIG(*this);
+	}
+
+	DG dg() const {
+		return DG(*this);
+	}
+
+	Pair pair(size_t i, size_t j) const {
+		if(!_keepPairs) __throw_invalid_argument(__N("ERROR: TemporalStabilityEngine created without pair values"));
+		return Pair(*this, i, j);
+	}
+
+	Pairs pairs() const {
+		if(!_keepPairs) __throw_invalid_argument(__N("ERROR: TemporalStabilityEngine created without pair values"));
+		return Pairs(*this);
+	}
+
+	// Position of the pair (i, j), i < j, in Result::pairs
+	size_t getPairIndex(size_t i, size_t j) const {
+		return i * _covariances - i * (i + 1) / 2 + (j - i - 1);
+	}
+
+	size_t getComputed() const {
+		return _computed;
+	}
+
+	size_t getReused() const {
+		return _reused;
+	}
+
+	void clear(){
+		_cache.clear();
+	}
+
+private:
+	size_t			_covariances;
+	bool			_keepPairs;
+	cache_type		_cache;
+	size_t			_computed, _reused;
+
+	void compute(NodePointer a, Result& res) const {
+		static const value_type DG_MIN_THRESHOLD = 1e-12;
+
+		const size_t covariances = a->getModel().getNumCovariances();
+		const size_t subMatrix_size = a->getModel().subMatrix_size;
+		std::vector<arma::cx_mat> vma(covariances);
+		std::vector<double> diag(covariances * subMatrix_size);
+		for(size_t i = 0; i < covariances; ++i){
+			vma[i] = to_arma<arma::cx_mat>::from(a->getModel().getCovariance(i));
+			for(size_t k = 0; k < subMatrix_size; ++k){
+				diag[i * subMatrix_size + k] = std::max(static_cast<value_type>(a->getModel().getCovariance(i)(k, k).real()), DG_MIN_THRESHOLD);
+			}
+		}
+
+		value_type geig = value_type(), dg = value_type();
+		if(_keepPairs) res.pairs.resize(covariances * (covariances - 1) / 2);
+		for(size_t i = 0, p = 0; i < covariances - 1; ++i){
+			for(size_t j = i+1; j < covariances; ++j, ++p){
+				const value_type d = hermitianGeodesicDistance(vma[i], vma[j]);
+				geig += d;
+				if(_keepPairs) res.pairs[p] = d;
+
+				double tmp = 0;
+				for(size_t k = 0; k < subMatrix_size; ++k){
+					tmp += pow(log(diag[i * subMatrix_size + k] / diag[j * subMatrix_size + k]), 2);
+				}
+				dg += sqrt(tmp);
+			}
+		}
+		res.geig = geig / ((covariances - 1) * covariances / 2.0);
+		res.dg = dg / ((covariances - 1) * covariances / 2);
+	}
+};
+
+} /* namespace tscbpt */
+
+#endif /* TEMPORALSTABILITYENGINE_HPP_ */
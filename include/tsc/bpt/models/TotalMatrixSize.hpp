@@ -67,9 +67,9 @@ struct TotalMatrixSize<double> {
 /**
  * Specialization for VectorMatrixModel<>
  */
-template<typename Matrix_ElemType, typename NSubnodesType, typename PositionType, 	size_t SubMatrixSz>
-struct TotalMatrixSize<VectorMatrixModel<Matrix_ElemType, NSubnodesType, PositionType, SubMatrixSz> > {
-	typedef VectorMatrixModel<Matrix_ElemType, NSubnodesType, PositionType, SubMatrixSz> 		main_type;
+template<typename Matrix_ElemType, typename NSubnodesType, typename PositionType, 	size_t SubMatrixSz, size_t NumCovariances>
+struct TotalMatrixSize<VectorMatrixModel<Matrix_ElemType, NSubnodesType, PositionType, SubMatrixSz, NumCovariances> > {
+	typedef VectorMatrixModel<Matrix_ElemType, NSubnodesType, PositionType, SubMatrixSz, NumCovariances> 		main_type;
 	static const size_t value = SubMatrixSz;
 	inline static size_t getValue(const main_type value){
 		return value.getMatrixSize();
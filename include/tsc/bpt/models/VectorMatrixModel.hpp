@@ -21,6 +21,7 @@
 #include <tsc/data/matrix/NormTraits.hpp>
 #include <tsc/data/matrix/BlockDiagonalMatrix.hpp>
 #include <tsc/data/matrix/GetMinDimSize.hpp>
+#include <tsc/util/types/FixedVector.hpp>
 #include <tsc/image/Pixel.hpp>
 
 namespace tscbpt
@@ -28,6 +29,32 @@ namespace tscbpt
 
 using namespace std;
 
+/**
+ * Storage types of VectorMatrixModel. By default (NumCovariances = 0) the
+ * number of covariance matrices is set at runtime (by the first pixel) and
+ * they are allocated on the heap. With NumCovariances > 0 the covariance
+ * matrices and the position are stored inline, so that the whole model is a
+ * fixed size object (see BlockDiagonalMatrixFixed).
+ */
+template<typename Matrix_ElemType, typename PositionType, size_t SubMatrixSize, size_t NumCovariances>
+struct VectorMatrixModelStorage
+{
+	// Maximum number of position dimensions of the fixed size models
+	static const size_t max_dimensions = 3;
+
+	typedef HermitianMatrixFixed<SubMatrixSize, Matrix_ElemType>							matrix_type;
+	typedef BlockDiagonalMatrixFixed<Matrix_ElemType, SubMatrixSize, NumCovariances, matrix_type>	covariance_type;
+	typedef FixedVector<PositionType, max_dimensions>										position_vector;
+};
+
+template<typename Matrix_ElemType, typename PositionType, size_t SubMatrixSize>
+struct VectorMatrixModelStorage<Matrix_ElemType, PositionType, SubMatrixSize, 0>
+{
+	typedef HermitianMatrixFixed<SubMatrixSize, Matrix_ElemType>							matrix_type;
+	typedef BlockDiagonalMatrix<Matrix_ElemType, SubMatrixSize, matrix_type>				covariance_type;
+	typedef vector<PositionType>															position_vector;
+};
+
 /**
  * Model to hold a vector of matrices, representing a Block Diagonal
  * hermitian matrix.
@@ -38,28 +65,39 @@ using namespace std;
  * to be modified to be used with this model. Other full matrix measures
  * are redefined to be more efficient (ending with
  * -VectorMatrixDissimilarityMeasure).
+ *
+ * NumCovariances fixes the number of covariance matrices (e.g. the number of
+ * acquisitions of a time series) at compile time: the model is then a fixed
+ * size, trivially copyable object, without heap allocations. The default (0)
+ * takes it from the data.
  */
 template<
 	typename Matrix_ElemType	= complex<double>,
 	typename NSubnodesType 		= size_t,
 	typename PositionType		= float,
-	size_t SubMatrixSize 		= 3
+	size_t SubMatrixSize 		= 3,
+	size_t NumCovariances		= 0
 	>
 class VectorMatrixModel
 {
+	typedef VectorMatrixModelStorage<Matrix_ElemType, PositionType, SubMatrixSize, NumCovariances>	storage;
+
 public:
 	static const size_t subMatrix_size = SubMatrixSize;
+	static const size_t num_covariances = NumCovariances;
 
 	typedef Matrix_ElemType												matrix_elem_type;
 	typedef NSubnodesType												subnodes_type;
 	typedef PositionType												position_type;
-	typedef vector<position_type>										position_vector;
-	typedef HermitianMatrixFixed<SubMatrixSize, matrix_elem_type>		matrix_type;
-	typedef BlockDiagonalMatrix<matrix_elem_type, subMatrix_size, matrix_type>	covariance_type;
-	typedef VectorMatrixModel<matrix_elem_type, subnodes_type, position_type, SubMatrixSize>		this_type;
+	typedef typename storage::position_vector							position_vector;
+	typedef typename storage::matrix_type								matrix_type;
+	typedef typename storage::covariance_type							covariance_type;
+	typedef VectorMatrixModel<matrix_elem_type, subnodes_type, position_type, SubMatrixSize, NumCovariances>		this_type;
 	typedef this_type													data_type;
+	// Weights of the covariance means (real part type of the matrix elements)
+	typedef typename NormTraits<matrix_elem_type>::type					weight_type;
 
-	VectorMatrixModel(){}
+	VectorMatrixModel() : _subnodes() {}
 
 	VectorMatrixModel(const this_type& b) : _matrix(b._matrix), _position(b._position), _subnodes(b._subnodes) {	}
 
@@ -134,8 +172,7 @@ public:
 		for (size_t i = 0; i < _position.size(); i++) {
 			tmp._position[i] = ((this->_position[i] * this->_subnodes + b._position[i] * b._subnodes) / tmp._subnodes);
 		}
-		tmp._matrix = ((this->_matrix * matrix_elem_type(this->_subnodes) + b._matrix * matrix_elem_type(b._subnodes))
-				/ matrix_elem_type(tmp._subnodes));
+		weighted_mean(tmp._matrix, this->_matrix, weight_type(this->_subnodes), b._matrix, weight_type(b._subnodes));
 		return tmp;
 	}
 
@@ -143,43 +180,50 @@ public:
 		this_type tmp(*this);
 		tmp._subnodes = this->_subnodes - b._subnodes;
 		for (size_t i = 0; i < _position.size(); i++) {
-			tmp._position.push_back(
-				(this->_position[i] * this->_subnodes - b._position[i] * b._subnodes) / tmp._subnodes);
+			tmp._position[i] = ((this->_position[i] * this->_subnodes - b._position[i] * b._subnodes) / tmp._subnodes);
 		}
-		tmp._matrix = ((this->_matrix * matrix_elem_type(this->_subnodes) - b._matrix * matrix_elem_type(b._subnodes))
-				/ matrix_elem_type(tmp._subnodes));
+		weighted_mean(tmp._matrix, this->_matrix, weight_type(this->_subnodes), b._matrix, -weight_type(b._subnodes));
 		return tmp;
 	}
 
+	/**
+	 * Free the covariance matrices of a model which will not be queried any
+	 * more (only with heap storage, NumCovariances = 0), keeping its
+	 * position and number of subnodes.
+	 */
+	void releaseData(){
+		_matrix.release();
+	}
+
 	void initializeToZero(){
 		_matrix = covariance_type();
-		for(typename vector<position_type>::iterator it = _position.begin(); it != _position.end(); ++it) *it = position_type();
+		for(typename position_vector::iterator it = _position.begin(); it != _position.end(); ++it) *it = position_type();
 		_subnodes = subnodes_type();
 	}
 
 private:
 	covariance_type				_matrix;
-	vector<position_type>		_position;
+	position_vector				_position;
 	subnodes_type				_subnodes;
 
 
-	template <typename T>
-	void initialize_covariance(vector<T>& v) {
+	/**
+	 * Covariance of a single pixel: outer product of each subvector of the
+	 * scattering vector v (a vector or any type with size() and operator[],
+	 * like StridedArrayRef) written directly into its block.
+	 */
+	template <typename Vector>
+	void initialize_covariance(const Vector& v) {
 		assert(v.size() % subMatrix_size == 0);
-		_matrix = covariance_type(v.size(), v.size());
-
-		if (MatrixShape<matrix_type>::isHermitian) {
-			for (size_t i = 0; i < v.size(); ++i) {
-				for (size_t j = i; j < (i/subMatrix_size + 1) * subMatrix_size; ++j) {
-					// armadillo stores data column by column
-					_matrix(i, j) = v[j] * conj(v[i]);
-				}
-			}
-		} else {
-			for (size_t i = 0; i < v.size(); ++i) {
-				for (size_t j = (i/subMatrix_size) * subMatrix_size; j < (i/subMatrix_size + 1) * subMatrix_size; ++j) {
-					// armadillo stores data column by column
-					_matrix(i, j) = v[j] * conj(v[i]);
+		if (_matrix.getSize() != v.size()) _matrix = covariance_type(v.size(), v.size());
+
+		for (size_t b = 0; b < v.size() / subMatrix_size; ++b) {
+			matrix_type& m = _matrix.getSubMatrix(b);
+			const size_t offset = b * subMatrix_size;
+			for (size_t i = 0; i < subMatrix_size; ++i) {
+				// Only the upper triangular part is stored for hermitian matrices
+				for (size_t j = MatrixShape<matrix_type>::isHermitian ? i : 0; j < subMatrix_size; ++j) {
+					m(i, j) = v[offset + j] * conj(v[offset + i]);
 				}
 			}
 		}
@@ -191,58 +235,55 @@ template<
 	typename Matrix_ElemType,
 	typename NSubnodesType,
 	typename PositionType,
-	size_t SubMatrixSize
+	size_t SubMatrixSize,
+	size_t NumCovariances
 	>
-typename NormTraits<typename VectorMatrixModel<Matrix_ElemType, NSubnodesType, PositionType, SubMatrixSize>::matrix_elem_type>::type norm2(
-	const VectorMatrixModel<Matrix_ElemType, NSubnodesType, PositionType, SubMatrixSize>& a){
-
-	typedef typename NormTraits<typename VectorMatrixModel<Matrix_ElemType, NSubnodesType, PositionType, SubMatrixSize>::matrix_elem_type>::type	ret_type;
-	ret_type ret = ret_type();
-	for (size_t i = 0; i < a.getNumCovariances(); ++i) {
-		ret += norm2(a.getCovariance(i));
-	}
-	return ret;
+typename NormTraits<typename VectorMatrixModel<Matrix_ElemType, NSubnodesType, PositionType, SubMatrixSize, NumCovariances>::matrix_elem_type>::type norm2(
+	const VectorMatrixModel<Matrix_ElemType, NSubnodesType, PositionType, SubMatrixSize, NumCovariances>& a){
+	return norm2(a.getFullCovariance());
 }
 
 template<
 	typename Matrix_ElemType,
 	typename NSubnodesType,
 	typename PositionType,
-	size_t SubMatrixSize
+	size_t SubMatrixSize,
+	size_t NumCovariances
 	>
-typename NormTraits<typename VectorMatrixModel<Matrix_ElemType, NSubnodesType, PositionType, SubMatrixSize>::matrix_elem_type>::type dist2(
-	const VectorMatrixModel<Matrix_ElemType, NSubnodesType, PositionType, SubMatrixSize>& a,
-	const VectorMatrixModel<Matrix_ElemType, NSubnodesType, PositionType, SubMatrixSize>& b){
-
-	typedef typename NormTraits<typename VectorMatrixModel<Matrix_ElemType, NSubnodesType, PositionType, SubMatrixSize>::matrix_elem_type>::type	ret_type;
-	ret_type ret = ret_type();
-	for (size_t i = 0; i < a.getNumCovariances(); ++i) {
-		ret += norm2(a.getCovariance(i) - b.getCovariance(i));
-	}
-	return ret;
+typename NormTraits<typename VectorMatrixModel<Matrix_ElemType, NSubnodesType, PositionType, SubMatrixSize, NumCovariances>::matrix_elem_type>::type dist2(
+	const VectorMatrixModel<Matrix_ElemType, NSubnodesType, PositionType, SubMatrixSize, NumCovariances>& a,
+	const VectorMatrixModel<Matrix_ElemType, NSubnodesType, PositionType, SubMatrixSize, NumCovariances>& b){
+	return dist2(a.getFullCovariance(), b.getFullCovariance());
 }
 
 // Static member definition needed to avoid compilation errors when optimization disabled
 template<
-	typename Matrix_ElemType, typename NSubnodesType, typename PositionType,size_t SubMatrixSize>
-const size_t VectorMatrixModel<Matrix_ElemType,NSubnodesType,PositionType,SubMatrixSize>::subMatrix_size;
+	typename Matrix_ElemType, typename NSubnodesType, typename PositionType,size_t SubMatrixSize, size_t NumCovariances>
+const size_t VectorMatrixModel<Matrix_ElemType,NSubnodesType,PositionType,SubMatrixSize,NumCovariances>::subMatrix_size;
+
+template<
+	typename Matrix_ElemType, typename NSubnodesType, typename PositionType,size_t SubMatrixSize, size_t NumCovariances>
+const size_t VectorMatrixModel<Matrix_ElemType,NSubnodesType,PositionType,SubMatrixSize,NumCovariances>::num_covariances;
+
+template<typename Matrix_ElemType, typename PositionType, size_t SubMatrixSize, size_t NumCovariances>
+const size_t VectorMatrixModelStorage<Matrix_ElemType, PositionType, SubMatrixSize, NumCovariances>::max_dimensions;
 
 /**
  * Generic functor to get the minimum size of all the dimensions of an array.
  * IMPLEMENTATION for VectorMatrixModel
  */
-template<typename Matrix_ElemType, typename NSubnodesType, typename PositionType,size_t SubMatrixSize>
-struct GetMinDimSize<VectorMatrixModel<Matrix_ElemType,NSubnodesType,PositionType,SubMatrixSize> >:
-public unary_function<VectorMatrixModel<Matrix_ElemType,NSubnodesType,PositionType,SubMatrixSize> ,size_t> {
-	inline size_t operator()(const VectorMatrixModel<Matrix_ElemType,NSubnodesType,PositionType,SubMatrixSize>& m) const {
+template<typename Matrix_ElemType, typename NSubnodesType, typename PositionType,size_t SubMatrixSize, size_t NumCovariances>
+struct GetMinDimSize<VectorMatrixModel<Matrix_ElemType,NSubnodesType,PositionType,SubMatrixSize,NumCovariances> >:
+public unary_function<VectorMatrixModel<Matrix_ElemType,NSubnodesType,PositionType,SubMatrixSize,NumCovariances> ,size_t> {
+	inline size_t operator()(const VectorMatrixModel<Matrix_ElemType,NSubnodesType,PositionType,SubMatrixSize,NumCovariances>& m) const {
 		return m.getFullCovariance().getSize();
 	}
 };
 
 
 // log_det() function implementation
-template<typename Matrix_ElemType,typename NSubnodesType,typename PositionType,size_t SubMatrixSize>
-Matrix_ElemType log_det(const VectorMatrixModel<Matrix_ElemType,NSubnodesType,PositionType,SubMatrixSize>& m){
+template<typename Matrix_ElemType,typename NSubnodesType,typename PositionType,size_t SubMatrixSize,size_t NumCovariances>
+Matrix_ElemType log_det(const VectorMatrixModel<Matrix_ElemType,NSubnodesType,PositionType,SubMatrixSize,NumCovariances>& m){
 	return log_det(m.getFullCovariance());
 }
 
@@ -56,6 +56,11 @@ public:
 		PolicyB::endBPTConstruction();
 	}
 
+	void setOutputDir(const std::string& dir){
+		PolicyA::setOutputDir(dir);
+		PolicyB::setOutputDir(dir);
+	}
+
 protected:
 	~AddSavingPolicy(){}
 };
@@ -0,0 +1,227 @@
+/*
+ * AsyncSaveMergedNodeModel.hpp
+ *
+ * Copyright (c) 2015 Alberto Alonso Gonzalez
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ *  Created on: 19/10/2026
+ *      Author: Alberto Alonso-Gonzalez
+ */
+
+#ifndef ASYNCSAVEMERGEDNODEMODEL_HPP_
+#define ASYNCSAVEMERGEDNODEMODEL_HPP_
+
+#include "BPTDataSavingPolicy.hpp"
+#include <tsc/policies/CheckingPolicy.hpp>
+#include <tsc/bpt/models/SubMatrixSize.hpp>
+#include <tsc/bpt/models/TotalMatrixSize.hpp>
+#include <tsc/io/PolSARProPlaneBuffer.hpp>
+#include <tsc/util/SPSCRingBuffer.hpp>
+#include <iostream>
+#include <string>
+#include <algorithm>
+#include <exception>
+#include <cassert>
+#include <pthread.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+
+namespace tscbpt {
+
+using namespace std;
+
+/**
+ * Asynchronous version of SaveMergedNodeModel<RegionModel, PolSARProMatrixDataSaver<> >.
+ *
+ * The plane values of each father node are copied into a lock-free single
+ * producer / single consumer ring buffer, which is drained by a dedicated
+ * writer thread into a PolSARProPlaneBuffer. The memory is bounded by the ring
+ * buffer size: when it is full the merging loop waits for the writer thread
+ * (back-pressure). The output files are the same as with SaveMergedNodeModel.
+ * Both the ring buffer and the plane buffers are bounded by the number of
+ * father nodes of the tree (see allocatedBytes()).
+ */
+template<
+	typename	RegionModel,
+	class 		CheckingPolicy				= FullCheckingPolicy
+>
+class AsyncSaveMergedNodeModel : public BPTDataSavingPolicy{
+public:
+
+	typedef RegionModel			region_model;
+	typedef CheckingPolicy		CheckingPol;
+	typedef AsyncSaveMergedNodeModel<RegionModel, CheckingPolicy>	this_type;
+
+	typedef PolSARProPlaneBuffer<CheckingPolicy>	planes_type;
+	typedef SPSCRingBuffer<float>					ring_type;
+
+	typedef SubMatrixSize<region_model> 	sub_matrix_size;
+	typedef TotalMatrixSize<region_model> 	total_matrix_size;
+
+	static const char* const DEFAULT_OUTPUT_SUBFOLDER;
+	static const size_t		DEFAULT_QUEUE_MB		= 64;
+
+	AsyncSaveMergedNodeModel(string aBasedir = DEFAULT_OUTPUT_SUBFOLDER, string aPrefix = string("C"), size_t aQueueMB = DEFAULT_QUEUE_MB) :
+		planes(NULL), ring(NULL), basedir(aBasedir), prefix(aPrefix), queueMB(aQueueMB), running(false), done(false), failed(false), stalls(0) {}
+
+	// The construction may be aborted by an exception before endBPTConstruction()
+	~AsyncSaveMergedNodeModel(){
+		stopWriter();
+		releaseBuffers();
+	}
+
+	template <class NodeSet, class DissimilaritySet>
+	void prepareBPTConstruction(NodeSet nodeSet, DissimilaritySet){
+		{	// Creating the directory path basedir
+			struct stat fstat;
+			if (stat(basedir.c_str(), &fstat) != 0){
+				cout << "\n  Creating dir " << basedir.c_str() << endl;
+				assert(mkdir(basedir.c_str(), S_IRWXU)==0);
+			}
+		}
+		size_t matrix_size = total_matrix_size::getValue((*(nodeSet.begin()))->getModel());
+		const size_t merges = fatherNodes(nodeSet.size());
+		planes = new planes_type(matrix_size, sub_matrix_size::getValue((*(nodeSet.begin()))->getModel()), basedir, prefix,
+				planes_type::DEFAULT_BUFFER_MB, merges);
+		ring = new ring_type(queueRecords(planes->getNFiles(), merges, queueMB), planes->getNFiles());
+	}
+
+	void startBPTConstruction() {
+		done = failed = false;
+		stalls = 0;
+		if(pthread_create(&writer, NULL, &this_type::writerThread, this) != 0){
+			__throw_runtime_error(__N("AsyncSaveMergedNodeModel could not create the writer thread"));
+		}
+		running = true;
+	}
+
+	template<class Node>
+	void saveFatherNode(Node node){
+		float* record;
+		while((record = ring->reserve()) == NULL){
+			// Back-pressure: wait for the writer thread to release some space
+			++stalls;
+			pause();
+		}
+		planes->extract(node, record);
+		ring->commit();
+	}
+
+	void endBPTConstruction(){
+		stopWriter();
+		if(failed){
+			releaseBuffers();
+			__throw_ios_failure(__N("ERROR: AsyncSaveMergedNodeModel could not write the node models"));
+		}
+		try{
+			if(planes) planes->close();
+		}catch(...){
+			releaseBuffers();
+			throw;
+		}
+		releaseBuffers();
+	}
+
+	void setOutputDir(const string& dir){
+		basedir = dir + "/" + DEFAULT_OUTPUT_SUBFOLDER;
+	}
+
+	// Bytes of the buffers allocated for a tree of the given leaves, whose models have nFiles planes
+	static size_t allocatedBytes(size_t leaves, size_t nFiles, size_t aQueueMB = DEFAULT_QUEUE_MB){
+		const size_t merges = fatherNodes(leaves);
+		return (ring_type::roundCapacity(queueRecords(nFiles, merges, aQueueMB))
+				+ planes_type::bufferCapacity(nFiles, planes_type::DEFAULT_BUFFER_MB, merges)) * nFiles * sizeof(float);
+	}
+
+	// Number of times the merging loop had to wait for the writer thread
+	size_t getStalls() const {
+		return stalls;
+	}
+
+private:
+	planes_type* planes;
+	ring_type* ring;
+	string basedir, prefix;
+	size_t queueMB;
+	pthread_t writer;
+	bool running, done, failed;
+	size_t stalls;
+	static const CheckingPol			Check;
+
+	AsyncSaveMergedNodeModel(const AsyncSaveMergedNodeModel&);
+	AsyncSaveMergedNodeModel& operator=(const AsyncSaveMergedNodeModel&);
+
+	// Let the writer thread drain the ring buffer and wait for it
+	void stopWriter(){
+		if(running){
+			__atomic_store_n(&done, true, __ATOMIC_RELEASE);
+			pthread_join(writer, NULL);
+			running = false;
+		}
+	}
+
+	// No-throw (the plane buffer ignores the errors on destruction)
+	void releaseBuffers(){
+		planes_type* oldPlanes = planes;
+		ring_type* oldRing = ring;
+		planes = NULL;
+		ring = NULL;
+		delete(oldPlanes);
+		delete(oldRing);
+	}
+
+	static size_t fatherNodes(size_t leaves){
+		return leaves > 1 ? leaves - 1 : 1;
+	}
+
+	// Records of the queue: queueMB megabytes, but no more than the father nodes
+	static size_t queueRecords(size_t nFiles, size_t merges, size_t aQueueMB){
+		return max(static_cast<size_t>(1), min((aQueueMB << 20) / (nFiles * sizeof(float)), merges));
+	}
+
+	static void pause(){
+		timespec t = {0, 50000};
+		nanosleep(&t, NULL);
+	}
+
+	static void* writerThread(void* powner){
+		static_cast<this_type*>(powner)->drain();
+		return NULL;
+	}
+
+	void drain(){
+		while(true){
+			const float* record = ring->front();
+			if(record != NULL){
+				// On a writing error keep draining, so that the merging loop never blocks
+				if(!failed){
+					try{
+						planes->push_values(record);
+					}catch(std::exception&){
+						failed = true;
+					}
+				}
+				ring->pop();
+			}else if(__atomic_load_n(&done, __ATOMIC_ACQUIRE)){
+				if(ring->empty()) break;
+			}else{
+				pause();
+			}
+		}
+	}
+};
+
+template <typename RegionModel, class CheckingPolicy>
+const char* const AsyncSaveMergedNodeModel<RegionModel, CheckingPolicy>::DEFAULT_OUTPUT_SUBFOLDER 		= "BPT/";
+
+template <typename RegionModel, class CheckingPolicy>
+const typename AsyncSaveMergedNodeModel<RegionModel, CheckingPolicy>::CheckingPol AsyncSaveMergedNodeModel<RegionModel, CheckingPolicy>::Check;
+
+} /* namespace tscbpt */
+#endif /* ASYNCSAVEMERGEDNODEMODEL_HPP_ */
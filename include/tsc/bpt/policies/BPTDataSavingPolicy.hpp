@@ -15,6 +15,8 @@
 #ifndef BPTDATASAVINGPOLICY_HPP_
 #define BPTDATASAVINGPOLICY_HPP_
 
+#include <string>
+
 namespace tscbpt
 {
 
@@ -35,6 +37,9 @@ public:
 
 	void endBPTConstruction(){}
 
+	// Directory of the saved files (by default, the working directory)
+	void setOutputDir(const std::string&){}
+
 protected:
 	~BPTDataSavingPolicy(){}
 };
@@ -0,0 +1,151 @@
+/*
+ * BPTMemoryPolicy.hpp
+ *
+ * Copyright (c) 2015 Alberto Alonso Gonzalez
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ *  Created on: 19/10/2026
+ *      Author: Alberto Alonso-Gonzalez
+ */
+
+#ifndef BPTMEMORYPOLICY_HPP_
+#define BPTMEMORYPOLICY_HPP_
+
+#include <tsc/policies/CheckingPolicy.hpp>
+#include <tsc/util/MemoryUsage.hpp>
+#include <cstddef>
+
+namespace tscbpt
+{
+
+/**
+ * Memory policies of the merging loop of BPTConstructor. The constructor
+ * calls reclaimAfterMerge() after each merge, once the dissimilarities of
+ * the sons have been removed, and endMemoryReclaim() at the end of the
+ * construction.
+ *
+ * NoMemoryReclaimPolicy (the default) does nothing.
+ */
+class NoMemoryReclaimPolicy
+{
+public:
+	void reclaimAfterMerge(){}
+
+	void endMemoryReclaim(){}
+
+protected:
+	~NoMemoryReclaimPolicy(){}
+};
+
+/**
+ * Memory policy returning the memory freed during the construction (the
+ * removed dissimilarities and neighborhood sets) to the operating system.
+ * It is disabled until setHighWaterMark() is called. Then, every
+ * checkPeriod merges, when the resident set size exceeds the high-water
+ * mark and the free fraction of the heap exceeds the fragmentation
+ * threshold, the heap is trimmed (see MemoryUsage::trim()).
+ *
+ * When disabled its cost is a single test per merge.
+ */
+template<
+	class 		CheckingPolicy				= FullCheckingPolicy
+>
+class ReclaimMemoryPolicy
+{
+public:
+	typedef CheckingPolicy		CheckingPol;
+
+	static const size_t		DefaultCheckPeriod				= 4096;
+	static const double		DefaultFragmentationThreshold;
+
+	ReclaimMemoryPolicy() : enabled(false), highWaterKB(0), checkPeriod(DefaultCheckPeriod),
+		fragmentation(DefaultFragmentationThreshold), countdown(DefaultCheckPeriod), trims(0), reclaimedKB(0) {}
+
+	void reclaimAfterMerge(){
+		if(enabled && --countdown == 0){
+			countdown = checkPeriod;
+			reclaimMemory(false);
+		}
+	}
+
+	void endMemoryReclaim(){
+		if(enabled) reclaimMemory(true);
+	}
+
+	/**
+	 * Trim the heap (if forced or when the RSS exceeds the high-water mark
+	 * and the heap fragmentation exceeds the threshold). Returns the KB
+	 * returned to the operating system.
+	 */
+	long reclaimMemory(bool force){
+		const long rss = MemoryUsage::currentRSS();
+		if(!force && (rss <= highWaterKB || MemoryUsage::heapFragmentation() < fragmentation)) return 0;
+		MemoryUsage::trim();
+		const long released = rss - MemoryUsage::currentRSS();
+		++trims;
+		if(released > 0) reclaimedKB += released;
+		return released > 0 ? released : 0;
+	}
+
+	// Enable the reclamation, above the given resident set size (0 to trim whenever fragmented)
+	void setHighWaterMark(size_t megabytes){
+		enabled = true;
+		highWaterKB = static_cast<long>(megabytes) * 1024;
+	}
+
+	// Free fraction of the heap needed to trim it
+	void setFragmentationThreshold(double fraction){
+		Check.errorAssert(fraction >= 0 && fraction <= 1);
+		fragmentation = fraction;
+	}
+
+	// Merges between checks of the memory usage
+	void setCheckPeriod(size_t merges){
+		checkPeriod = countdown = (merges > 0) ? merges : 1;
+	}
+
+	bool isMemoryReclaimEnabled() const {
+		return enabled;
+	}
+
+	// Number of times the heap has been trimmed
+	size_t getTrims() const {
+		return trims;
+	}
+
+	// Memory returned to the operating system, in KB
+	long getReclaimedKB() const {
+		return reclaimedKB;
+	}
+
+private:
+	bool		enabled;
+	long		highWaterKB;
+	size_t		checkPeriod;
+	double		fragmentation;
+	size_t		countdown;
+	size_t		trims;
+	long		reclaimedKB;
+	static const CheckingPol			Check;
+
+protected:
+	~ReclaimMemoryPolicy(){}
+};
+
+// Trim when at least a quarter of the heap is free
+template <class CheckingPolicy>
+const double ReclaimMemoryPolicy<CheckingPolicy>::DefaultFragmentationThreshold 		= 0.25;
+
+template <class CheckingPolicy>
+const size_t ReclaimMemoryPolicy<CheckingPolicy>::DefaultCheckPeriod;
+
+template <class CheckingPolicy>
+const typename ReclaimMemoryPolicy<CheckingPolicy>::CheckingPol ReclaimMemoryPolicy<CheckingPolicy>::Check;
+
+}
+
+#endif /* BPTMEMORYPOLICY_HPP_ */
@@ -0,0 +1,219 @@
+/*
+ * BPTMergeTracePolicy.hpp
+ *
+ * Copyright (c) 2015 Alberto Alonso Gonzalez
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ *  Created on: 19/10/2026
+ *      Author: Alberto Alonso-Gonzalez
+ */
+
+#ifndef BPTMERGETRACEPOLICY_HPP_
+#define BPTMERGETRACEPOLICY_HPP_
+
+#include <tsc/policies/CheckingPolicy.hpp>
+#include <cstddef>
+#include <ctime>
+#include <stdint.h>
+#include <vector>
+#include <string>
+#include <fstream>
+
+namespace tscbpt
+{
+
+using namespace std;
+
+/**
+ * Trace policies of the merging loop of BPTConstructor. For each merge, the
+ * constructor calls traceMergeStart(), traceMeasureEnd() once the father
+ * dissimilarities have been evaluated (neighborhood collection) and
+ * traceMergeEnd() after the bookkeeping (queue update and removal of the
+ * sons dissimilarities). startMergeTrace() and endMergeTrace() enclose the
+ * whole loop.
+ *
+ * NoMergeTracePolicy (the default) does nothing: all its methods are empty
+ * inline functions, so that the tracing code is removed by the compiler.
+ */
+class NoMergeTracePolicy
+{
+public:
+	void startMergeTrace(){}
+
+	void traceMergeStart(){}
+
+	void traceMeasureEnd(){}
+
+	void traceMergeEnd(size_t, size_t, size_t){}
+
+	void endMergeTrace(){}
+
+	void setOutputDir(const string&){}
+
+protected:
+	~NoMergeTracePolicy(){}
+};
+
+/**
+ * Trace policy recording statistics of one of every N merges (sampling
+ * period) into a ring buffer, preallocated at the start of the construction
+ * (the last records are kept when it is full). The records are written into
+ * a binary file at the end of the construction (BPT.trace by default, within
+ * the output directory, if any, see setOutputDir()):
+ *
+ *   char[8]	magic ("TSCBPTMT")
+ *   uint32		version (1)
+ *   uint32		size of each record, in bytes (40)
+ *   uint64		total number of merges
+ *   uint64		sampling period
+ *   uint64		number of records
+ *   records, from the oldest one:
+ *     uint64	merge number (0 for the first merge)
+ *     uint64	dissimilarity queue size after the merge
+ *     uint64	nanoseconds evaluating the father dissimilarities
+ *     uint64	nanoseconds of bookkeeping
+ *     uint32	father degree (number of neighbors)
+ *     uint32	dissimilarity evaluations
+ *
+ * all of them in native endianness.
+ */
+template<
+	class 		CheckingPolicy				= FullCheckingPolicy
+>
+class SampledMergeTracePolicy
+{
+public:
+	typedef CheckingPolicy		CheckingPol;
+
+	struct Record
+	{
+		uint64_t	merge;
+		uint64_t	queueSize;
+		uint64_t	measureNs;
+		uint64_t	bookkeepingNs;
+		uint32_t	fatherDegree;
+		uint32_t	evaluations;
+	};
+
+	static const char* const	DefaultTraceFileName;
+	static const size_t			DefaultCapacity = 1 << 16;
+
+	SampledMergeTracePolicy() : traceFileName(DefaultTraceFileName), period(1), capacity(DefaultCapacity),
+		merges(0), countdown(0), sampled(false), start(0), measured(0) {}
+
+	void startMergeTrace(){
+		records.clear();
+		records.reserve(capacity);
+		merges = 0;
+		countdown = 0;
+	}
+
+	void traceMergeStart(){
+		sampled = (countdown == 0);
+		if(sampled){
+			countdown = period;
+			start = now();
+		}
+		--countdown;
+	}
+
+	void traceMeasureEnd(){
+		if(sampled) measured = now();
+	}
+
+	void traceMergeEnd(size_t fatherDegree, size_t evaluations, size_t queueSize){
+		if(sampled){
+			Record r;
+			r.merge = merges;
+			r.queueSize = queueSize;
+			r.measureNs = measured - start;
+			r.bookkeepingNs = now() - measured;
+			r.fatherDegree = static_cast<uint32_t>(fatherDegree);
+			r.evaluations = static_cast<uint32_t>(evaluations);
+			if(records.size() < capacity) records.push_back(r);
+			else records[(merges / period) % capacity] = r;
+		}
+		++merges;
+	}
+
+	void endMergeTrace(){
+		const string file = outputDir.empty() ? string(traceFileName) : outputDir + "/" + traceFileName;
+		ofstream out(file.c_str(), ios::out | ios::trunc | ios::binary);
+		Check.errorAssert(!(out.fail()));
+		const uint32_t version = 1, recordSize = sizeof(Record);
+		const uint64_t header[3] = {merges, period, records.size()};
+		out.write("TSCBPTMT", 8);
+		out.write(reinterpret_cast<const char*>(&version), sizeof(version));
+		out.write(reinterpret_cast<const char*>(&recordSize), sizeof(recordSize));
+		out.write(reinterpret_cast<const char*>(header), sizeof(header));
+		// The oldest record follows the last written one when the buffer has wrapped around
+		const size_t first = (merges > period * capacity) ? ((merges - 1) / period + 1) % capacity : 0;
+		for(size_t i = 0; i < records.size(); ++i){
+			out.write(reinterpret_cast<const char*>(&(records[(first + i) % records.size()])), sizeof(Record));
+		}
+		Check.errorAssert(!(out.fail()));
+		out.close();
+		vector<Record>().swap(records);
+	}
+
+	const char* getTraceFileName() const{
+		return traceFileName;
+	}
+
+	void setTraceFileName(const char* traceFileName){
+		this->traceFileName = traceFileName;
+	}
+
+	// Directory of the trace file (the working directory by default)
+	void setOutputDir(const string& dir){
+		outputDir = dir;
+	}
+
+	// Trace one of every period merges
+	void setTracePeriod(size_t period){
+		this->period = period > 0 ? period : 1;
+	}
+
+	// Maximum number of records kept
+	void setTraceCapacity(size_t capacity){
+		this->capacity = capacity > 0 ? capacity : 1;
+	}
+
+private:
+	// Monotonic clock, in nanoseconds
+	static uint64_t now(){
+		timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+	}
+
+	const char*				traceFileName;
+	string					outputDir;
+	size_t					period, capacity;
+	uint64_t				merges;
+	size_t					countdown;
+	bool					sampled;
+	uint64_t				start, measured;
+	vector<Record>			records;
+	static const CheckingPol			Check;
+
+protected:
+	~SampledMergeTracePolicy(){}
+};
+
+template <class CheckingPolicy>
+const char* const SampledMergeTracePolicy<CheckingPolicy>::DefaultTraceFileName 		= "BPT.trace";
+
+template <class CheckingPolicy>
+const size_t SampledMergeTracePolicy<CheckingPolicy>::DefaultCapacity;
+
+template <class CheckingPolicy>
+const typename SampledMergeTracePolicy<CheckingPolicy>::CheckingPol SampledMergeTracePolicy<CheckingPolicy>::Check;
+
+}
+
+#endif /* BPTMERGETRACEPOLICY_HPP_ */
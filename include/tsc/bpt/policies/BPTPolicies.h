@@ -21,5 +21,6 @@
 #include "SaveMergingSequence.hpp"
 #include "SaveMergedNodeHomogeneity.hpp"
 #include "SaveMergedNodeModel.hpp"
+#include "BPTMergeTracePolicy.hpp"
 
 #endif /* BPTPOLICIES_H_ */
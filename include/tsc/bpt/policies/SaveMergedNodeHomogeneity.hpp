@@ -20,6 +20,7 @@
 #include <tsc/bpt/PruneCriteria.h>
 #include <iostream>
 #include <fstream>
+#include <string>
 
 namespace tscbpt
 {
@@ -38,11 +39,13 @@ public:
 
 	static const char* const HomogFileName;
 
+	SaveMergedNodeHomogeneity() : homogFileName(HomogFileName) {}
+
 	template <class NodeSet, class DissimilaritySet>
 	void prepareBPTConstruction(NodeSet, DissimilaritySet) {}
 
 	void startBPTConstruction() {
-		homogOut.open(HomogFileName, ios::out | ios::trunc);
+		homogOut.open(homogFileName.c_str(), ios::out | ios::trunc);
 		Check.errorAssert(!(homogOut.fail()));
 	}
 
@@ -59,8 +62,13 @@ public:
 		homogOut.close();
 	}
 
+	void setOutputDir(const string& dir) {
+		homogFileName = dir + "/" + HomogFileName;
+	}
+
 private:
 	ofstream homogOut;
+	string homogFileName;
 	static const CheckingPol			Check;
 	typedef RelativeMSEHomogeneityOperator<homogType>			HomogOp;
 	HomogOp homogeneity;
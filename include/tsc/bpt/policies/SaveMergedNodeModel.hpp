@@ -70,6 +70,10 @@ public:
 		delete(saver);
 	}
 
+	void setOutputDir(const string& dir){
+		basedir = dir + "/" + DEFAULT_OUTPUT_SUBFOLDER;
+	}
+
 
 private:
 	data_saver* saver;
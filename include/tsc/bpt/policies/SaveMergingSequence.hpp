@@ -19,6 +19,7 @@
 #include <tsc/policies/CheckingPolicy.hpp>
 #include <iostream>
 #include <fstream>
+#include <string>
 #include <stdint.h>
 
 namespace tscbpt
@@ -41,7 +42,7 @@ public:
 	SaveMergingSequence() : msFileName(DefaultMSFileName) {}
 
 	void startBPTConstruction(){
-		msOut.open(msFileName, ios::out | ios::trunc);
+		msOut.open(msFileName.c_str(), ios::out | ios::trunc);
 		Check.errorAssert(!(msOut.fail()));
 	}
 
@@ -56,17 +57,21 @@ public:
 		msOut.close();
 	}
 
-	char *getMsFileName() const{
-		return msFileName;
+	const char *getMsFileName() const{
+		return msFileName.c_str();
 	}
 
 	void setMsFileName(const char *msFileName){
 		this->msFileName = msFileName;
 	}
 
+	void setOutputDir(const string& dir){
+		msFileName = dir + "/" + DefaultMSFileName;
+	}
+
 private:
 	ofstream msOut;
-	const char* msFileName;
+	string msFileName;
 	static const CheckingPol			Check;
 
 protected:
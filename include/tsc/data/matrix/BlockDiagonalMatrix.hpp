@@ -19,6 +19,7 @@
 #include "Matrix.hpp"
 #include "HermitianMatrix.hpp"
 #include "GetMinDimSize.hpp"
+#include "NormTraits.hpp"
 #include <tsc/util/Algorithms.h>
 #include <tsc/util/types/WrapperOf.hpp>
 
@@ -111,11 +112,111 @@ public:
 		}
 	}
 
+	// Free the storage of the blocks (the matrix becomes empty)
+	void release() {
+		vector<matrix_type>().swap(_matrices);
+	}
+
 private:
 	vector<matrix_type>		_matrices;
 };
 
 
+/**
+ * Block diagonal matrix with a fixed number of blocks (NumBlocks), stored
+ * inline. With fixed size blocks (e.g. HermitianMatrixFixed) the whole
+ * matrix is a single fixed size object without heap allocations, trivially
+ * copyable, so that it may be stored by value in contiguous arrays, copied
+ * with memcpy() or mapped from a file.
+ * It is default constructed to zero.
+ */
+template<
+	typename Field,
+	size_t SubMatrixSize,
+	size_t NumBlocks,
+	typename SubMatrixType = HermitianMatrixFixed<SubMatrixSize, Field>
+	>
+class BlockDiagonalMatrixFixed:
+	public Matrix_Base<BlockDiagonalMatrixFixed<Field, SubMatrixSize, NumBlocks, SubMatrixType>, Field>
+{
+public:
+	typedef Field							FieldType;
+	typedef FieldType						elem_type;
+	typedef BlockDiagonalMatrixFixed<Field, SubMatrixSize, NumBlocks, SubMatrixType>	this_type;
+	typedef SubMatrixType					matrix_type;
+
+	static const size_t subMatrixSize = SubMatrixSize;
+	static const size_t numBlocks = NumBlocks;
+
+	BlockDiagonalMatrixFixed() {
+		*this = elem_type();
+	}
+
+	BlockDiagonalMatrixFixed(size_t rows, size_t cols) {
+		assert(rows == cols);
+		assert(rows == NumBlocks * subMatrixSize);
+		*this = elem_type();
+	}
+
+	size_t getSize() const {
+		return NumBlocks * subMatrixSize;
+	}
+
+	size_t getNumSubMatrices() const {
+		return NumBlocks;
+	}
+
+	size_t getRows() const {
+		return getSize();
+	}
+
+	size_t getCols() const {
+		return getSize();
+	}
+
+	elem_type operator()(size_t row, size_t col) const {
+		return (row / subMatrixSize != col / subMatrixSize)? elem_type() : _matrices[row/subMatrixSize](row%subMatrixSize, col%subMatrixSize);
+	}
+
+	elem_type& operator()(size_t row, size_t col) {
+		assert(row / subMatrixSize == col / subMatrixSize /* Ensures getting R/W access to an element within the diagonal block */);
+		return _matrices[row/subMatrixSize](row%subMatrixSize, col%subMatrixSize);
+	}
+
+	const matrix_type& getSubMatrix(size_t index) const {
+		assert(index < NumBlocks);
+		return _matrices[index];
+	}
+
+	matrix_type& getSubMatrix(size_t index) {
+		assert(index < NumBlocks);
+		return _matrices[index];
+	}
+
+	template <typename func>
+	void for_each_elem(func _functor) {
+		for(size_t i = 0; i < NumBlocks; ++i){
+			_matrices[i].for_each_elem(_functor);
+		}
+	}
+
+	template <typename func>
+	void for_each_elem(func _functor, const this_type& b) {
+		for(size_t i = 0; i < NumBlocks; ++i){
+			_matrices[i].for_each_elem(_functor, b._matrices[i]);
+		}
+	}
+
+	// Nothing to free (for compatibility with BlockDiagonalMatrix)
+	void release() {}
+
+	using Matrix_Base<this_type, Field>::operator=;
+
+private:
+	matrix_type				_matrices[NumBlocks];
+};
+
+
 /**
  * Define shape as square for all BlockDiagonalMatrix<Field, SubMatrixSize, SubMatrixType> classes
  */
@@ -135,6 +236,25 @@ struct HasHermitianShape<BlockDiagonalMatrix<Field, SubMatrixSize, SubMatrixType
 	static const bool value = HasHermitianShape<SubMatrixType>::value;
 };
 
+/**
+ * Define shape as square for all BlockDiagonalMatrixFixed<Field, SubMatrixSize, NumBlocks, SubMatrixType> classes
+ */
+template <typename Field, size_t SubMatrixSize, size_t NumBlocks, typename SubMatrixType>
+struct HasSquareShape<BlockDiagonalMatrixFixed<Field, SubMatrixSize, NumBlocks, SubMatrixType> >
+{
+	static const bool value = true;
+};
+
+/**
+ * Define shape as hermitian for all BlockDiagonalMatrixFixed<Field, SubMatrixSize, NumBlocks, SubMatrixType> classes
+ * formed by Hermitian blocks
+ */
+template <typename Field, size_t SubMatrixSize, size_t NumBlocks, typename SubMatrixType>
+struct HasHermitianShape<BlockDiagonalMatrixFixed<Field, SubMatrixSize, NumBlocks, SubMatrixType> >
+{
+	static const bool value = HasHermitianShape<SubMatrixType>::value;
+};
+
 /**
  * Generic functor to get the minimum size of all the dimensions of an array.
  * IMPLEMENTATION for BlockDiagonalMatrix
@@ -147,6 +267,72 @@ public unary_function<BlockDiagonalMatrix<Field, SubMatrixSize, SubMatrixType> ,
 	}
 };
 
+/**
+ * Generic functor to get the minimum size of all the dimensions of an array.
+ * IMPLEMENTATION for BlockDiagonalMatrixFixed
+ */
+template <typename Field, size_t SubMatrixSize, size_t NumBlocks, typename SubMatrixType>
+struct GetMinDimSize<BlockDiagonalMatrixFixed<Field, SubMatrixSize, NumBlocks, SubMatrixType> >:
+public unary_function<BlockDiagonalMatrixFixed<Field, SubMatrixSize, NumBlocks, SubMatrixType> ,size_t> {
+	inline size_t operator()(const BlockDiagonalMatrixFixed<Field, SubMatrixSize, NumBlocks, SubMatrixType>& m) const {
+		return m.getSize();
+	}
+};
+
+
+/**
+ * Fused kernels, applied block by block (see the ones of the blocks type):
+ * weighted_mean() computes res = (a * wa + b * wb) / (wa + wb), and res may
+ * be any of the operands.
+ */
+template<typename Field, size_t SubMatrixSize, typename SubMatrixType, typename Weight>
+void weighted_mean(BlockDiagonalMatrix<Field, SubMatrixSize, SubMatrixType>& res, const BlockDiagonalMatrix<Field, SubMatrixSize, SubMatrixType>& a, Weight wa,
+		const BlockDiagonalMatrix<Field, SubMatrixSize, SubMatrixType>& b, Weight wb){
+	assert(a.getNumSubMatrices() == b.getNumSubMatrices() && res.getNumSubMatrices() == a.getNumSubMatrices());
+	for(size_t i = 0; i < a.getNumSubMatrices(); ++i)
+		weighted_mean(res.getSubMatrix(i), a.getSubMatrix(i), wa, b.getSubMatrix(i), wb);
+}
+
+template<typename Field, size_t SubMatrixSize, typename SubMatrixType>
+typename NormTraits<Field>::type norm2(const BlockDiagonalMatrix<Field, SubMatrixSize, SubMatrixType>& a){
+	typename NormTraits<Field>::type res = typename NormTraits<Field>::type();
+	for(size_t i = 0; i < a.getNumSubMatrices(); ++i)
+		res += norm2(a.getSubMatrix(i));
+	return res;
+}
+
+template<typename Field, size_t SubMatrixSize, typename SubMatrixType>
+typename NormTraits<Field>::type dist2(const BlockDiagonalMatrix<Field, SubMatrixSize, SubMatrixType>& a, const BlockDiagonalMatrix<Field, SubMatrixSize, SubMatrixType>& b){
+	assert(a.getNumSubMatrices() == b.getNumSubMatrices());
+	typename NormTraits<Field>::type res = typename NormTraits<Field>::type();
+	for(size_t i = 0; i < a.getNumSubMatrices(); ++i)
+		res += dist2(a.getSubMatrix(i), b.getSubMatrix(i));
+	return res;
+}
+
+template<typename Field, size_t SubMatrixSize, size_t NumBlocks, typename SubMatrixType, typename Weight>
+void weighted_mean(BlockDiagonalMatrixFixed<Field, SubMatrixSize, NumBlocks, SubMatrixType>& res, const BlockDiagonalMatrixFixed<Field, SubMatrixSize, NumBlocks, SubMatrixType>& a, Weight wa,
+		const BlockDiagonalMatrixFixed<Field, SubMatrixSize, NumBlocks, SubMatrixType>& b, Weight wb){
+	for(size_t i = 0; i < NumBlocks; ++i)
+		weighted_mean(res.getSubMatrix(i), a.getSubMatrix(i), wa, b.getSubMatrix(i), wb);
+}
+
+template<typename Field, size_t SubMatrixSize, size_t NumBlocks, typename SubMatrixType>
+typename NormTraits<Field>::type norm2(const BlockDiagonalMatrixFixed<Field, SubMatrixSize, NumBlocks, SubMatrixType>& a){
+	typename NormTraits<Field>::type res = typename NormTraits<Field>::type();
+	for(size_t i = 0; i < NumBlocks; ++i)
+		res += norm2(a.getSubMatrix(i));
+	return res;
+}
+
+template<typename Field, size_t SubMatrixSize, size_t NumBlocks, typename SubMatrixType>
+typename NormTraits<Field>::type dist2(const BlockDiagonalMatrixFixed<Field, SubMatrixSize, NumBlocks, SubMatrixType>& a, const BlockDiagonalMatrixFixed<Field, SubMatrixSize, NumBlocks, SubMatrixType>& b){
+	typename NormTraits<Field>::type res = typename NormTraits<Field>::type();
+	for(size_t i = 0; i < NumBlocks; ++i)
+		res += dist2(a.getSubMatrix(i), b.getSubMatrix(i));
+	return res;
+}
+
 
 // log_det() function implementation
 template<typename Field,size_t SubMatrixSize,typename SubMatrixType>
@@ -157,6 +343,15 @@ Field log_det(const BlockDiagonalMatrix<Field, SubMatrixSize, SubMatrixType>& m)
 	return res;
 }
 
+// log_det() function implementation
+template<typename Field, size_t SubMatrixSize, size_t NumBlocks, typename SubMatrixType>
+Field log_det(const BlockDiagonalMatrixFixed<Field, SubMatrixSize, NumBlocks, SubMatrixType>& m){
+	Field res = Field();
+	for(size_t i = 0; i < NumBlocks; ++i)
+		res += log_det(m.getSubMatrix(i));
+	return res;
+}
+
 
 }
 
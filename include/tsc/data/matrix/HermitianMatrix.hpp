@@ -266,20 +266,89 @@ public:
 		return _data[row * getSize() - (row * row - row) / 2 + (col - row)];
 	}
 
+	/**
+	 * Packed storage: the upper triangular matrix, row by row (n_elems
+	 * elements, starting with the diagonal element of each row)
+	 */
+	const elem_type* memptr() const {
+		return _data;
+	}
+
+	elem_type* memptr() {
+		return _data;
+	}
 
-//	using matrix_base::for_each_elem;
+	// Element wise operations in a single loop over the packed storage
+	template <typename func>
+	void for_each_elem(func _functor) {
+		for (size_t i = 0; i < n_elems; ++i) {
+			_functor(_data[i]);
+		}
+	}
 
-//	template <typename func>
-//	void for_each_elem(func _functor) {
-//		for (size_t i = 0; i < n_elems; ++i) {
-//			_functor(_data[i]);
-//		}
-//	}
+	template <typename func>
+	void for_each_elem(func _functor, const this_type& b) {
+		for (size_t i = 0; i < n_elems; ++i) {
+			_functor(_data[i], b._data[i]);
+		}
+	}
 
 private:
 	elem_type _data[n_elems];
 };
 
+/**
+ * Fused kernels of the fixed size complex hermitian matrix, as single loops
+ * over the packed storage of the operands (real and imaginary parts as a
+ * plain array of 2 * n_elems values), with no temporaries.
+ *
+ * The operations and the summation order of the reductions are the same as
+ * with the generic matrix operators, so the results only differ in the last
+ * bit when the compiler contracts products and sums into FMA instructions.
+ */
+template <size_t Size, typename T>
+void weighted_mean(HermitianMatrixFixed<Size, complex<T> >& res, const HermitianMatrixFixed<Size, complex<T> >& a, T wa,
+		const HermitianMatrixFixed<Size, complex<T> >& b, T wb){
+	const size_t n = 2 * HermitianMatrixFixed<Size, complex<T> >::n_elems;
+	const T* pa = reinterpret_cast<const T*>(a.memptr());
+	const T* pb = reinterpret_cast<const T*>(b.memptr());
+	T* pr = reinterpret_cast<T*>(res.memptr());
+	const T w = wa + wb;
+	for (size_t k = 0; k < n; ++k) {
+		pr[k] = (pa[k] * wa + pb[k] * wb) / w;
+	}
+}
+
+template <size_t Size, typename T>
+T norm2(const HermitianMatrixFixed<Size, complex<T> >& a){
+	const T* pa = reinterpret_cast<const T*>(a.memptr());
+	T tmp = T();
+	for (size_t i = 0; i < Size; ++i) {
+		tmp += pa[0] * pa[0] + pa[1] * pa[1];
+		pa += 2;
+		for (size_t j = i + 1; j < Size; ++j, pa += 2) {
+			tmp += 2 * (pa[0] * pa[0] + pa[1] * pa[1]);
+		}
+	}
+	return tmp;
+}
+
+template <size_t Size, typename T>
+T dist2(const HermitianMatrixFixed<Size, complex<T> >& a, const HermitianMatrixFixed<Size, complex<T> >& b){
+	const T* pa = reinterpret_cast<const T*>(a.memptr());
+	const T* pb = reinterpret_cast<const T*>(b.memptr());
+	T tmp = T();
+	for (size_t i = 0; i < Size; ++i) {
+		tmp += (pa[0] - pb[0]) * (pa[0] - pb[0]) + (pa[1] - pb[1]) * (pa[1] - pb[1]);
+		pa += 2;
+		pb += 2;
+		for (size_t j = i + 1; j < Size; ++j, pa += 2, pb += 2) {
+			tmp += 2 * ((pa[0] - pb[0]) * (pa[0] - pb[0]) + (pa[1] - pb[1]) * (pa[1] - pb[1]));
+		}
+	}
+	return tmp;
+}
+
 /**
  * Define shape as square for all HermitianMatrix<Field> classes
  */
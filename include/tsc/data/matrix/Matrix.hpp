@@ -130,13 +130,13 @@ struct Matrix_Base{
 		if (shape::isHermitian) {
 			for (size_t i = 0; i < getRows(); ++i) {
 				for (size_t j = i; j < getCols(); ++j) {
-					_functor((static_cast<MatrixImpl*> (this))->operator()(i, j), (static_cast<MatrixImpl> (b))(i, j));
+					_functor((static_cast<MatrixImpl*> (this))->operator()(i, j), b(i, j));
 				}
 			}
 		} else {
 			for (size_t i = 0; i < getRows(); ++i) {
 				for (size_t j = 0; j < getCols(); ++j) {
-					_functor((static_cast<MatrixImpl*> (this))->operator()(i, j), (static_cast<MatrixImpl> (b))(i, j));
+					_functor((static_cast<MatrixImpl*> (this))->operator()(i, j), b(i, j));
 				}
 			}
 		}
@@ -283,6 +283,20 @@ public:
 	}
 };
 
+/**
+ * Weighted mean of two matrices: res = (a * wa + b * wb) / (wa + wb)
+ * (e.g. the mean covariance of two merged regions of wa and wb pixels).
+ * res may be any of the operands.
+ *
+ * Generic implementation, through the matrix operators. Matrices with packed
+ * storage overload it with a single loop without temporaries.
+ */
+template<class Derived, class Field, typename Weight>
+void weighted_mean(Matrix_Base<Derived, Field>& res, const Matrix_Base<Derived, Field>& a, Weight wa,
+		const Matrix_Base<Derived, Field>& b, Weight wb){
+	static_cast<Derived&>(res) = (static_cast<const Derived&>(a) * Field(wa) + static_cast<const Derived&>(b) * Field(wb)) / Field(wa + wb);
+}
+
 }// End tscbpt namespace
 
 #endif /* MATRIX_HPP_ */
@@ -0,0 +1,83 @@
+/*
+ * BPTTreeFileFormat.hpp
+ *
+ * Copyright (c) 2015 Alberto Alonso Gonzalez
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ *  Created on: 19/10/2026
+ *      Author: Alberto Alonso-Gonzalez
+ */
+
+#ifndef BPTTREEFILEFORMAT_HPP_
+#define BPTTREEFILEFORMAT_HPP_
+
+#include <cstddef>
+#include <stdint.h>
+
+namespace tscbpt
+{
+
+/**
+ * Common definitions of the persisted BPT file format (.tree files), written
+ * by BPTTreeFileWriter and memory mapped by MappedBPTTree.
+ *
+ * The nodes are stored by index: the leaves first, the index of each leaf
+ * being its pixel position (row * cols + col), followed by the merged nodes
+ * in merging order (sons always before their father).
+ *
+ * File layout (native endianness, all the arrays are 8 byte aligned):
+ *   Header
+ *   uint32		left son[nodes], right son[nodes], father[nodes] (NO_NODE if none)
+ *   uint32		node id[nodes] (BPT node id, as written in RegId.bin)
+ *   double		total sum of squares[nodes]
+ *   double		norm2 of the model[nodes]
+ *   uint64		subnodes[nodes]
+ *   float		planes[nodes][planes] (only with FLAG_MODELS, see PolSARProPlaneLayout)
+ */
+namespace tree_file
+{
+
+static const char		MAGIC[8]		= {'T', 'S', 'C', 'B', 'P', 'T', '0', '1'};
+static const uint32_t	FLAG_MODELS		= 1;
+static const uint32_t	NO_NODE			= 0xFFFFFFFF;
+
+struct Header
+{
+	char		magic[8];
+	uint32_t	flags;
+	uint32_t	planes;			// Number of model planes per node (0 without FLAG_MODELS)
+	uint64_t	rows;
+	uint64_t	cols;
+	uint64_t	nodes;
+	uint64_t	root;
+	uint32_t	matrixSize;
+	uint32_t	subMatrixSize;
+	char		prefix[8];		// Output prefix of the model planes ("C", "T")
+};
+
+// Size of each section for the given header
+inline uint64_t topologySize(const Header& h){
+	return 4 * 4 * h.nodes;
+}
+
+inline uint64_t homogeneitySize(const Header& h){
+	return 3 * 8 * h.nodes;
+}
+
+inline uint64_t modelsSize(const Header& h){
+	return (h.flags & FLAG_MODELS) ? 4 * h.nodes * h.planes : 0;
+}
+
+inline uint64_t fileSize(const Header& h){
+	return sizeof(Header) + topologySize(h) + homogeneitySize(h) + modelsSize(h);
+}
+
+}
+
+}
+
+#endif /* BPTTREEFILEFORMAT_HPP_ */
@@ -0,0 +1,194 @@
+/*
+ * BPTTreeFileWriter.hpp
+ *
+ * Copyright (c) 2015 Alberto Alonso Gonzalez
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ *  Created on: 19/10/2026
+ *      Author: Alberto Alonso-Gonzalez
+ */
+
+#ifndef BPTTREEFILEWRITER_HPP_
+#define BPTTREEFILEWRITER_HPP_
+
+#include <cstddef>
+#include <cstring>
+#include <stdint.h>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "BPTTreeFileFormat.hpp"
+#include "PolSARProPlaneBuffer.hpp"
+#include "../policies/CheckingPolicy.hpp"
+
+namespace tscbpt
+{
+
+using namespace std;
+
+/**
+ * Writer of the persisted BPT file format (see BPTTreeFileFormat.hpp), to
+ * prune the tree again later (TEBPT-prune) without the input data.
+ *
+ * It stores the topology, the node ids and the homogeneity of each node
+ * (total sum of squares, norm2 and subnodes, enough for the homogeneity prune
+ * criteria) and, optionally, the node models as PolSARPro planes. The region
+ * model must provide getTotalSumOfSquares() (AddHomogeneity) and the leaves
+ * their pixel position (getDim(0) column, getDim(1) row).
+ */
+template<
+	class 		CheckingPolicy		= FullCheckingPolicy
+	>
+class BPTTreeFileWriter
+{
+public:
+	typedef CheckingPolicy			CheckPol;
+
+	static const size_t		DEFAULT_BUFFER_MB	= 32;
+
+	/**
+	 * @param prefix output prefix of the model planes ("C", "T")
+	 * @param models also store the models of all the nodes
+	 */
+	BPTTreeFileWriter(size_t rows, size_t cols, size_t subMatrixSize, const string& prefix, bool models = true) :
+		_rows(rows), _cols(cols), _subMatrixSize(subMatrixSize), _prefix(prefix), _models(models) {}
+
+	template<typename NodePointer>
+	void writeToFile(const string& file, NodePointer root){
+		using namespace tree_file;
+		const size_t nLeaves = _rows * _cols;
+
+		// Merged nodes sorted by id (merging order), after the leaves
+		vector<NodePointer> merged;
+		vector<NodePointer> remaining(1, root);
+		size_t leaves = 0;
+		while(!remaining.empty()){
+			NodePointer np = remaining.back();
+			remaining.pop_back();
+			if(np->isLeaf()){
+				++leaves;
+			}else{
+				merged.push_back(np);
+				remaining.push_back(np->getLeftSoon());
+				remaining.push_back(np->getRightSoon());
+			}
+		}
+		if(leaves != nLeaves) __throw_invalid_argument(__N("ERROR: The number of BPT leaves differs from rows x cols"));
+		sort(merged.begin(), merged.end(), id_less<NodePointer>());
+
+		const PolSARProPlaneLayout layout(root->getModel().getMatrixSize(), _subMatrixSize);
+		Header h;
+		memset(&h, 0, sizeof(h));
+		memcpy(h.magic, MAGIC, sizeof(MAGIC));
+		h.flags = _models ? FLAG_MODELS : 0;
+		h.planes = _models ? layout.getNPlanes() : 0;
+		h.rows = _rows;
+		h.cols = _cols;
+		h.nodes = nLeaves + merged.size();
+		h.root = index(root, merged);
+		h.matrixSize = layout.getMatrixSize();
+		h.subMatrixSize = _subMatrixSize;
+		strncpy(h.prefix, _prefix.c_str(), sizeof(h.prefix) - 1);
+
+		// Nodes by index (the leaves through their fathers, or the root)
+		vector<NodePointer> nodes(h.nodes, NodePointer());
+		for(size_t m = 0; m < merged.size(); ++m){
+			nodes[nLeaves + m] = merged[m];
+			if(merged[m]->getLeftSoon()->isLeaf()) nodes[index(merged[m]->getLeftSoon(), merged)] = merged[m]->getLeftSoon();
+			if(merged[m]->getRightSoon()->isLeaf()) nodes[index(merged[m]->getRightSoon(), merged)] = merged[m]->getRightSoon();
+		}
+		if(root->isLeaf()) nodes[h.root] = root;
+		for(size_t i = 0; i < nLeaves; ++i){
+			if(!nodes[i]) __throw_invalid_argument(__N("ERROR: Repeated BPT leaf position"));
+		}
+
+		vector<uint32_t> left(h.nodes, NO_NODE), right(h.nodes, NO_NODE), father(h.nodes, NO_NODE), ids(h.nodes);
+		vector<double> tss(h.nodes), norm(h.nodes);
+		vector<uint64_t> subnodes(h.nodes);
+		const int n = static_cast<int>(h.nodes);
+		#pragma omp parallel for schedule(static)
+		for(int i = 0; i < n; ++i){
+			ids[i] = nodes[i]->getId();
+			tss[i] = nodes[i]->getModel().getTotalSumOfSquares();
+			norm[i] = norm2(nodes[i]->getModel());
+			subnodes[i] = nodes[i]->getModel().getSubnodes();
+		}
+		for(size_t m = 0; m < merged.size(); ++m){
+			const uint32_t i = nLeaves + m;
+			left[i] = index(merged[m]->getLeftSoon(), merged);
+			right[i] = index(merged[m]->getRightSoon(), merged);
+			father[left[i]] = father[right[i]] = i;
+		}
+
+		ofstream os(file.c_str(), ios::out | ios::trunc | ios::binary);
+		check.ioStateOK(os);
+		os.write(reinterpret_cast<const char*>(&h), sizeof(h));
+		write(os, left);
+		write(os, right);
+		write(os, father);
+		write(os, ids);
+		write(os, tss);
+		write(os, norm);
+		write(os, subnodes);
+		check.ioStateOK(os);
+
+		if(_models){
+			// Models in chunks of nodes, extracted in parallel
+			const size_t chunk = max(static_cast<size_t>(1), (static_cast<size_t>(DEFAULT_BUFFER_MB) << 20) / (h.planes * sizeof(float)));
+			vector<float> planes(chunk * h.planes);
+			for(size_t first = 0; first < h.nodes; first += chunk){
+				const int count = static_cast<int>(min(chunk, static_cast<size_t>(h.nodes - first)));
+				#pragma omp parallel for schedule(static)
+				for(int i = 0; i < count; ++i){
+					layout.extract(nodes[first + i], &(planes[i * h.planes]));
+				}
+				os.write(reinterpret_cast<const char*>(&(planes[0])), count * h.planes * sizeof(float));
+				check.ioStateOK(os);
+			}
+		}
+		os.close();
+	}
+
+private:
+	size_t		_rows, _cols, _subMatrixSize;
+	string		_prefix;
+	bool		_models;
+
+	template<typename NodePointer>
+	struct id_less{
+		bool operator()(const NodePointer& a, const NodePointer& b) const {
+			return a->getId() < b->getId();
+		}
+	};
+
+	// Index of the node: pixel position of the leaves, merging order of the rest
+	template<typename NodePointer>
+	uint32_t index(NodePointer np, const vector<NodePointer>& merged) const {
+		if(np->isLeaf()){
+			const size_t row = np->getModel().getDim(1), col = np->getModel().getDim(0);
+			if(row >= _rows || col >= _cols) __throw_out_of_range(__N("ERROR: BPT leaf position out of the image"));
+			return row * _cols + col;
+		}
+		return _rows * _cols + (lower_bound(merged.begin(), merged.end(), np, id_less<NodePointer>()) - merged.begin());
+	}
+
+	template<typename T>
+	static void write(ofstream& os, const vector<T>& data){
+		if(!data.empty()) os.write(reinterpret_cast<const char*>(&(data[0])), data.size() * sizeof(T));
+	}
+
+protected:
+	static const CheckPol		check;
+};
+
+template <class CheckingPolicy>
+const typename BPTTreeFileWriter<CheckingPolicy>::CheckPol BPTTreeFileWriter<CheckingPolicy>::check;
+
+}
+
+#endif /* BPTTREEFILEWRITER_HPP_ */
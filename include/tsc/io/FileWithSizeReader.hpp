@@ -133,6 +133,31 @@ public:
 		return iterator();
 	}
 
+	// Read the block of the given rows and columns range into out (height x width
+	// values, row major), seeking to each row of the block so that only the block
+	// data is read. Returns false if the data could not be read.
+	bool readBlock(size_t startRow, size_t startCol, size_t height, size_t width, DataValue* out) {
+		if(startRow + height > _rows || startCol + width > _cols){
+			__throw_invalid_argument(__N("The requested block exceeds the file size"));
+		}
+		if(!_instream.is_open()) _instream.open(_filename.c_str(), ios::binary);
+		_instream.clear();
+		const size_t rowsPerRead = (width == _cols) ? height : 1;
+		for(size_t r = 0; r < height && _instream.good(); r += rowsPerRead){
+			_instream.seekg(static_cast<streamoff>(_offset*sizeof(file_size_type) + ((startRow + r)*_cols + startCol)*sizeof(DataValue)), ios::beg);
+			_instream.read(reinterpret_cast<char*>(out + r*width), rowsPerRead*width*sizeof(DataValue));
+		}
+		if(!_instream.good()) return false;
+		if(_swap_endian){
+			for(size_t i = 0; i < height*width; ++i) out[i] = swap_endian(out[i]);
+		}
+		return true;
+	}
+
+	void close() {
+		if(_instream.is_open()) _instream.close();
+	}
+
 	string getFilename() const
 	{
 		return _filename;
@@ -147,6 +172,17 @@ public:
 	{
 		return _cols;
 	}
+
+	// Size in bytes of the header preceding the data
+	size_t getHeaderSize() const
+	{
+		return _offset*sizeof(file_size_type);
+	}
+
+	bool getSwapEndian() const
+	{
+		return _swap_endian;
+	}
 };
 
 }
@@ -0,0 +1,282 @@
+/*
+ * MappedBPTTree.hpp
+ *
+ * Copyright (c) 2015 Alberto Alonso Gonzalez
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ *  Created on: 19/10/2026
+ *      Author: Alberto Alonso-Gonzalez
+ */
+
+#ifndef MAPPEDBPTTREE_HPP_
+#define MAPPEDBPTTREE_HPP_
+
+#include <cstddef>
+#include <cstring>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <deque>
+#include <stdexcept>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "BPTTreeFileFormat.hpp"
+
+namespace tscbpt
+{
+
+using namespace std;
+
+/**
+ * Read only view of a persisted BPT file (see BPTTreeFileFormat.hpp), memory
+ * mapped so that only the accessed pages are read from disk.
+ *
+ * The nodes are accessed through NodePointer handles, which provide the
+ * subset of the BPTNode interface employed by the pruning process
+ * (isLeaf(), getLeftSoon(), getRightSoon(), getFather(), getId() and a
+ * getModel() with getTotalSumOfSquares(), getSubnodes() and norm2()), so that
+ * the homogeneity prune criteria (e.g. RelErrorHomogeneityPruneCriterion)
+ * can be employed without changes.
+ */
+class MappedBPTTree
+{
+public:
+	// Homogeneity of a node, with the interface of the region models
+	class HomogeneityModel
+	{
+	public:
+		HomogeneityModel(double tss, double norm, size_t subnodes) : _tss(tss), _norm(norm), _subnodes(subnodes){}
+
+		double getTotalSumOfSquares() const {
+			return _tss;
+		}
+
+		size_t getSubnodes() const {
+			return _subnodes;
+		}
+
+		double getNorm2() const {
+			return _norm;
+		}
+
+	private:
+		double	_tss, _norm;
+		size_t	_subnodes;
+	};
+
+	// Handle to a node of the tree (a null handle has no tree)
+	class NodePointer
+	{
+	public:
+		NodePointer() : _tree(NULL), _index(tree_file::NO_NODE){}
+		NodePointer(const MappedBPTTree* tree, uint32_t index) :
+			_tree(index == tree_file::NO_NODE ? NULL : tree), _index(index){}
+
+		const NodePointer* operator->() const {
+			return this;
+		}
+
+		operator const void*() const {
+			return _tree;
+		}
+
+		bool operator==(const NodePointer& b) const {
+			return _index == b._index && _tree == b._tree;
+		}
+
+		bool operator!=(const NodePointer& b) const {
+			return !(*this == b);
+		}
+
+		bool operator<(const NodePointer& b) const {
+			return _index < b._index;
+		}
+
+		uint32_t getIndex() const {
+			return _index;
+		}
+
+		uint32_t getId() const {
+			return _tree->_ids[_index];
+		}
+
+		bool isLeaf() const {
+			return _tree->_left[_index] == tree_file::NO_NODE;
+		}
+
+		NodePointer getLeftSoon() const {
+			return NodePointer(_tree, _tree->_left[_index]);
+		}
+
+		NodePointer getRightSoon() const {
+			return NodePointer(_tree, _tree->_right[_index]);
+		}
+
+		NodePointer getFather() const {
+			return NodePointer(_tree, _tree->_father[_index]);
+		}
+
+		HomogeneityModel getModel() const {
+			return HomogeneityModel(_tree->_tss[_index], _tree->_norm[_index], _tree->_subnodes[_index]);
+		}
+
+		// Model planes of the node (see PolSARProPlaneLayout), only if hasModels()
+		const float* getPlanes() const {
+			return _tree->_planes + static_cast<size_t>(_index) * _tree->_header->planes;
+		}
+
+	private:
+		const MappedBPTTree*	_tree;
+		uint32_t				_index;
+	};
+
+	MappedBPTTree(const string& file) : _data(NULL), _size(0){
+		using namespace tree_file;
+		const int fd = open(file.c_str(), O_RDONLY);
+		if(fd < 0) __throw_ios_failure(__N("ERROR: BPT tree file cannot be opened"));
+		struct stat fstat_;
+		if(fstat(fd, &fstat_) != 0 || static_cast<size_t>(fstat_.st_size) < sizeof(Header)){
+			::close(fd);
+			__throw_runtime_error(__N("ERROR: Not a BPT tree file"));
+		}
+		_size = fstat_.st_size;
+		void* data = mmap(NULL, _size, PROT_READ, MAP_SHARED, fd, 0);
+		::close(fd);
+		if(data == MAP_FAILED) __throw_ios_failure(__N("ERROR: BPT tree file cannot be mapped"));
+		_data = static_cast<const char*>(data);
+
+		_header = reinterpret_cast<const Header*>(_data);
+		if(memcmp(_header->magic, MAGIC, sizeof(MAGIC)) != 0 || fileSize(*_header) != _size){
+			close();
+			__throw_runtime_error(__N("ERROR: Not a BPT tree file, or corrupted"));
+		}
+		const char* p = _data + sizeof(Header);
+		_left = reinterpret_cast<const uint32_t*>(p);
+		_right = _left + _header->nodes;
+		_father = _right + _header->nodes;
+		_ids = _father + _header->nodes;
+		p += topologySize(*_header);
+		_tss = reinterpret_cast<const double*>(p);
+		_norm = _tss + _header->nodes;
+		_subnodes = reinterpret_cast<const uint64_t*>(_norm + _header->nodes);
+		p += homogeneitySize(*_header);
+		_planes = hasModels() ? reinterpret_cast<const float*>(p) : NULL;
+	}
+
+	~MappedBPTTree(){
+		close();
+	}
+
+	size_t getRows() const {
+		return _header->rows;
+	}
+
+	size_t getCols() const {
+		return _header->cols;
+	}
+
+	size_t getNNodes() const {
+		return _header->nodes;
+	}
+
+	size_t getMatrixSize() const {
+		return _header->matrixSize;
+	}
+
+	size_t getSubMatrixSize() const {
+		return _header->subMatrixSize;
+	}
+
+	string getPrefix() const {
+		return string(_header->prefix, strnlen(_header->prefix, sizeof(_header->prefix)));
+	}
+
+	bool hasModels() const {
+		return (_header->flags & tree_file::FLAG_MODELS) != 0;
+	}
+
+	size_t getNPlanes() const {
+		return _header->planes;
+	}
+
+	NodePointer getRoot() const {
+		return NodePointer(this, _header->root);
+	}
+
+	// Leaf of the given pixel
+	NodePointer getLeaf(size_t row, size_t col) const {
+		return NodePointer(this, row * _header->cols + col);
+	}
+
+	// Same as BPTFrame::prune
+	template<class NodeSet, class PruneCriteria>
+	NodeSet& prune(NodeSet& out, PruneCriteria criterion) const {
+		std::deque<NodePointer> remaining;
+		remaining.push_back(getRoot());
+		while (remaining.size() > 0) {
+			NodePointer np = remaining.front();
+			remaining.pop_front();
+			if (criterion(np) || np->isLeaf()) {
+				out.insert(np);
+			} else {
+				remaining.push_back(np->getLeftSoon());
+				remaining.push_back(np->getRightSoon());
+			}
+		}
+		return out;
+	}
+
+	// Region (node of the set) of each pixel, row major
+	template<class NodeSet>
+	vector<NodePointer> getRegionImage(const NodeSet& regions) const {
+		vector<NodePointer> image(_header->rows * _header->cols);
+		vector<uint32_t> remaining;
+		for(typename NodeSet::const_iterator it = regions.begin(); it != regions.end(); ++it){
+			remaining.push_back(it->getIndex());
+			while(!remaining.empty()){
+				const uint32_t i = remaining.back();
+				remaining.pop_back();
+				if(_left[i] == tree_file::NO_NODE){
+					image[i] = *it;
+				}else{
+					remaining.push_back(_left[i]);
+					remaining.push_back(_right[i]);
+				}
+			}
+		}
+		return image;
+	}
+
+private:
+	// Non copyable (owns the mapping)
+	MappedBPTTree(const MappedBPTTree&);
+	MappedBPTTree& operator=(const MappedBPTTree&);
+
+	void close(){
+		if(_data != NULL) munmap(const_cast<char*>(_data), _size);
+		_data = NULL;
+	}
+
+	const char*					_data;
+	size_t						_size;
+	const tree_file::Header*	_header;
+	const uint32_t				*_left, *_right, *_father, *_ids;
+	const double				*_tss, *_norm;
+	const uint64_t				*_subnodes;
+	const float					*_planes;
+};
+
+inline double norm2(const MappedBPTTree::HomogeneityModel& model){
+	return model.getNorm2();
+}
+
+}
+
+#endif /* MAPPEDBPTTREE_HPP_ */
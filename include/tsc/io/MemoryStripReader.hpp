@@ -0,0 +1,88 @@
+/*
+ * MemoryStripReader.hpp
+ *
+ * Copyright (c) 2015 Alberto Alonso Gonzalez
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ *  Created on: 19/10/2026
+ *      Author: Alberto Alonso-Gonzalez
+ */
+
+#ifndef MEMORYSTRIPREADER_HPP_
+#define MEMORYSTRIPREADER_HPP_
+
+#include <stddef.h>
+#include <vector>
+#include <stdexcept>
+
+
+namespace tscbpt {
+
+using namespace std;
+
+/**
+ * Strip reader (with the bulk interface of MultiFileBlockReader) over
+ * planar data already in memory: the pixel (row, col) of the channel
+ * (file) f at data[f * planeSize + row * cols + col].
+ *
+ * The whole buffer is given as a single strip, without copying it, so that
+ * the leaves of a BPT are computed directly from the caller's buffer (see
+ * DenseWRAGGenerator). The buffer must outlive the reader.
+ */
+template<typename DataType>
+class MemoryStripReader {
+public:
+	typedef vector<DataType>						value_type;
+
+	// planeSize 0 stands for contiguous planes (rows * cols)
+	MemoryStripReader(const DataType* data, size_t rows, size_t cols, size_t nfiles, size_t planeSize = 0) :
+		_data(data), _rows(rows), _cols(cols), _nfiles(nfiles), _planeSize(planeSize > 0 ? planeSize : rows * cols) {
+		if(data == NULL || rows == 0 || cols == 0 || nfiles == 0 || _planeSize < rows * cols){
+			__throw_invalid_argument(__N("The data of the MemoryStripReader is empty or its planes overlap"));
+		}
+	}
+
+	size_t getRows() const{
+		return _rows;
+	}
+
+	size_t getCols() const{
+		return _cols;
+	}
+
+	size_t getNFiles() const{
+		return _nfiles;
+	}
+
+	size_t getStripRows() const{
+		return _rows;
+	}
+
+	size_t getNStrips() const{
+		return 1;
+	}
+
+	size_t getStripHeight(size_t) const{
+		return _rows;
+	}
+
+	size_t getPlaneSize() const{
+		return _planeSize;
+	}
+
+	const DataType* getStrip(size_t) const{
+		return _data;
+	}
+
+private:
+	const DataType*		_data;
+	size_t				_rows, _cols, _nfiles, _planeSize;
+};
+
+} // namespace tscbpt
+
+#endif /* MEMORYSTRIPREADER_HPP_ */
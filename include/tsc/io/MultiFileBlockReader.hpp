@@ -0,0 +1,365 @@
+/*
+ * MultiFileBlockReader.hpp
+ *
+ * Copyright (c) 2015 Alberto Alonso Gonzalez
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ *  Created on: 19/10/2026
+ *      Author: Alberto Alonso-Gonzalez
+ */
+
+#ifndef MULTIFILEBLOCKREADER_HPP_
+#define MULTIFILEBLOCKREADER_HPP_
+
+#include <stddef.h>
+#include <pthread.h>
+#include <vector>
+#include <iterator>
+#include <algorithm>
+#include "MultiFileWithSizeReader.hpp"
+#include "../log/Timer.hpp"
+
+
+namespace tscbpt {
+
+using namespace std;
+
+/**
+ * Prefetching reader for a set of files described by a MultiFileWithSizeReader.
+ *
+ * The data is read in strips of rows (of approximately stripMB
+ * megabytes for all the files together) by a background thread, which reads
+ * all the files concurrently (OpenMP) into a second buffer while the
+ * consumer iterates over the current one (double buffering). Only the data
+ * within the given window is read from disk (see FileWithSizeReader::readBlock).
+ *
+ * The iterator has the same interface as MultiFileWithSizeReader::iterator,
+ * with getRow() and getCol() relative to the window. As with the other
+ * readers, only one pass can be active at a time.
+ */
+template<typename DataType>
+class MultiFileBlockReader {
+public:
+	typedef MultiFileWithSizeReader<DataType>		SourceReader;
+	typedef vector<DataType>						value_type;
+
+	static const size_t	DEFAULT_STRIP_MB		= 64;
+
+	MultiFileBlockReader(const SourceReader& files, size_t stripMB = DEFAULT_STRIP_MB) {
+		init(files, 0, 0, files.getRows(), files.getCols(), stripMB);
+	}
+
+	MultiFileBlockReader(const SourceReader& files, size_t startRow, size_t startCol, size_t height, size_t width,
+			size_t stripMB = DEFAULT_STRIP_MB) {
+		init(files, startRow, startCol, height, width, stripMB);
+	}
+
+	~MultiFileBlockReader(){
+		finishPass();
+		pthread_cond_destroy(&_cond);
+		pthread_mutex_destroy(&_mutex);
+	}
+
+	struct iterator : public std::iterator<input_iterator_tag, vector<DataType> >{
+		typedef vector<DataType>									value_type;
+		typedef iterator& 											iterator_ref;
+		typedef const iterator& 									iterator_ref_const;
+
+	private:
+		MultiFileBlockReader*		_powner;
+		value_type					_current;
+		size_t						_pos;
+
+		iterator(MultiFileBlockReader* powner, size_t pos) :
+			_powner(powner), _current(powner->getNFiles()), _pos(pos){
+			if(_pos < _powner->_size) _powner->fetch(_pos, _current);
+		}
+
+		friend class MultiFileBlockReader<DataType>;
+
+	public:
+		iterator_ref operator++(){
+			if(++_pos < _powner->_size) _powner->fetch(_pos, _current);
+			return *this;
+		}
+
+		size_t getRow() const {
+			return _pos / _powner->_width;
+		}
+
+		size_t getCol() const {
+			return _pos % _powner->_width;
+		}
+
+		bool operator==(iterator_ref_const b) const{
+			return _pos == b._pos;
+		}
+
+		bool operator!=(iterator_ref_const b) const {
+			return _pos != b._pos;
+		}
+
+		value_type& operator* () {
+			return _current;
+		}
+		const value_type& operator* () const {
+			return _current;
+		}
+	};
+
+	iterator begin(){
+		startPass();
+		return iterator(this, 0);
+	}
+
+	iterator end(){
+		return iterator(this, _size);
+	}
+
+	size_t getRows() const{
+		return _height;
+	}
+
+	size_t getCols() const{
+		return _width;
+	}
+
+	size_t getNFiles() const{
+		return _files.size();
+	}
+
+	size_t getStripRows() const{
+		return _stripRows;
+	}
+
+	// Number of strips of the window (the last one may have less than getStripRows() rows)
+	size_t getNStrips() const{
+		return _nStrips;
+	}
+
+	// Rows of the given strip
+	size_t getStripHeight(size_t strip) const{
+		return min(_stripRows, _height - strip * _stripRows);
+	}
+
+	// Distance (in elements) between the data of two consecutive files within a strip
+	size_t getPlaneSize() const{
+		return _planeSize;
+	}
+
+	/**
+	 * Bulk access to the data, as an alternative to the iterators: returns
+	 * the strip with the data of all the files, being the pixel (row, col)
+	 * of the file f (row relative to the strip) at
+	 * [f * getPlaneSize() + row * getCols() + col]. It is valid until the
+	 * next call. Requesting the strips in order keeps the prefetching of
+	 * the next one in the background.
+	 */
+	const DataType* getStrip(size_t strip){
+		if(strip != _frontStrip){
+			if(!_running) startPass();
+			acquire(strip);
+		}
+		return &(_buffers[_front][0]);
+	}
+
+	// Bytes read from disk since construction
+	size_t getBytesRead() const{
+		return _bytesRead;
+	}
+
+	// Wall time (seconds) spent by the background thread reading
+	double getReadTime() const{
+		return _readTime;
+	}
+
+	// Read throughput of the background thread, in bytes per second
+	double getReadThroughput() const{
+		return (_readTime > 0) ? _bytesRead / _readTime : 0;
+	}
+
+	// Wall time (seconds) the consumer has been waiting for data
+	double getStallTime() const{
+		return _stallTime;
+	}
+
+	// Free the strip buffers once the data has been read (they are allocated again by the next pass)
+	void release(){
+		finishPass();
+		_frontStrip = _nStrips;
+		vector<DataType>().swap(_buffers[0]);
+		vector<DataType>().swap(_buffers[1]);
+	}
+
+private:
+	// Non copyable (owns the background thread)
+	MultiFileBlockReader(const MultiFileBlockReader&);
+	MultiFileBlockReader& operator=(const MultiFileBlockReader&);
+
+	typedef FileWithSizeReader<DataType>			File;
+
+	vector<File>			_files;
+	size_t					_startRow, _startCol, _height, _width, _size;
+	size_t					_stripRows, _nStrips, _planeSize;
+
+	vector<DataType>		_buffers[2];
+	size_t					_front, _frontStrip;
+
+	pthread_t				_thread;
+	pthread_mutex_t			_mutex;
+	pthread_cond_t			_cond;
+	bool					_running, _stop, _pending, _ready, _failed;
+	size_t					_pendingStrip;
+
+	size_t					_bytesRead;
+	double					_readTime, _stallTime;
+
+	void init(const SourceReader& files, size_t startRow, size_t startCol, size_t height, size_t width, size_t stripMB){
+		if(height == 0 || width == 0 || startRow + height > files.getRows() || startCol + width > files.getCols()){
+			__throw_invalid_argument(__N("The requested window is empty or exceeds the files size"));
+		}
+		for(size_t i = 0; i < files.getNFiles(); ++i){
+			_files.push_back(files.getFile(i));
+		}
+		_startRow = startRow;
+		_startCol = startCol;
+		_height = height;
+		_width = width;
+		_size = height * width;
+
+		const size_t rowBytes = _files.size() * width * sizeof(DataType);
+		_stripRows = min(height, max(static_cast<size_t>(1), (max(stripMB, static_cast<size_t>(1)) << 20) / rowBytes));
+		_nStrips = (height + _stripRows - 1) / _stripRows;
+		_planeSize = _stripRows * width;
+
+		_front = 0;
+		_frontStrip = _nStrips;
+		_running = _stop = _pending = _ready = _failed = false;
+		_pendingStrip = 0;
+		_bytesRead = 0;
+		_readTime = _stallTime = 0;
+		pthread_mutex_init(&_mutex, NULL);
+		pthread_cond_init(&_cond, NULL);
+	}
+
+	void fetch(size_t pos, value_type& out){
+		const size_t row = pos / _width;
+		const size_t strip = row / _stripRows;
+		if(strip != _frontStrip) acquire(strip);
+		const DataType* data = &(_buffers[_front][(row - strip * _stripRows) * _width + pos % _width]);
+		for(size_t f = 0; f < out.size(); ++f, data += _planeSize){
+			out[f] = *data;
+		}
+	}
+
+	// Make the given strip the front buffer, waiting for the background thread if needed
+	void acquire(size_t strip){
+		Timer stall;
+		pthread_mutex_lock(&_mutex);
+		if(!_pending || _pendingStrip != strip){
+			// Non sequential access: wait for the strip in flight and request the new one
+			while(_pending && !_ready) pthread_cond_wait(&_cond, &_mutex);
+			request(strip);
+		}
+		while(!_ready) pthread_cond_wait(&_cond, &_mutex);
+		_stallTime += stall.elapsed();
+		const bool failed = _failed;
+		_front = 1 - _front;
+		_frontStrip = strip;
+		_pending = _ready = false;
+		if(strip + 1 < _nStrips) request(strip + 1);
+		pthread_mutex_unlock(&_mutex);
+
+		if(failed){
+			finishPass();
+			__throw_ios_failure(__N("ERROR: MultiFileBlockReader could not read the input files"));
+		}
+		if(strip + 1 == _nStrips) finishPass();
+	}
+
+	// Called with the mutex locked
+	void request(size_t strip){
+		_pendingStrip = strip;
+		_pending = true;
+		_ready = false;
+		pthread_cond_broadcast(&_cond);
+	}
+
+	void startPass(){
+		finishPass();
+		// The first strip is read into _buffers[1], so that _buffers[0] is only needed with several strips
+		_buffers[0].resize((_nStrips > 1) ? _files.size() * _planeSize : 0);
+		_buffers[1].resize(_files.size() * _planeSize);
+		_front = 0;
+		_frontStrip = _nStrips;
+		_stop = _ready = _failed = false;
+		request(0);
+		if(pthread_create(&_thread, NULL, &MultiFileBlockReader::prefetchThread, this) != 0){
+			__throw_runtime_error(__N("MultiFileBlockReader could not create the prefetching thread"));
+		}
+		_running = true;
+	}
+
+	void finishPass(){
+		if(_running){
+			pthread_mutex_lock(&_mutex);
+			_stop = true;
+			pthread_cond_broadcast(&_cond);
+			pthread_mutex_unlock(&_mutex);
+			pthread_join(_thread, NULL);
+			_running = false;
+		}
+		_pending = false;
+		for(size_t i = 0; i < _files.size(); ++i) _files[i].close();
+	}
+
+	static void* prefetchThread(void* powner){
+		static_cast<MultiFileBlockReader*>(powner)->prefetchLoop();
+		return NULL;
+	}
+
+	void prefetchLoop(){
+		pthread_mutex_lock(&_mutex);
+		while(true){
+			while(!_stop && !(_pending && !_ready)) pthread_cond_wait(&_cond, &_mutex);
+			if(_stop) break;
+			const size_t strip = _pendingStrip;
+			vector<DataType>& buffer = _buffers[1 - _front];
+			pthread_mutex_unlock(&_mutex);
+
+			Timer timer;
+			const size_t bytes = readStrip(strip, buffer);
+			const double elapsed = timer.elapsed();
+
+			pthread_mutex_lock(&_mutex);
+			_failed = _failed || bytes == 0;
+			_bytesRead += bytes;
+			_readTime += elapsed;
+			_ready = true;
+			pthread_cond_broadcast(&_cond);
+		}
+		pthread_mutex_unlock(&_mutex);
+	}
+
+	// Read the given strip of all the files into buffer. Returns the bytes read or 0 on failure
+	size_t readStrip(size_t strip, vector<DataType>& buffer){
+		const size_t firstRow = strip * _stripRows;
+		const size_t nrows = min(_stripRows, _height - firstRow);
+		const int nfiles = static_cast<int>(_files.size());
+		int failures = 0;
+
+		#pragma omp parallel for schedule(dynamic, 1) reduction(+:failures)
+		for(int f = 0; f < nfiles; ++f){
+			if(!_files[f].readBlock(_startRow + firstRow, _startCol, nrows, _width, &(buffer[f * _planeSize]))) ++failures;
+		}
+		return (failures == 0) ? nfiles * nrows * _width * sizeof(DataType) : 0;
+	}
+};
+
+}
+
+#endif /* MULTIFILEBLOCKREADER_HPP_ */
@@ -112,6 +112,14 @@ public:
 		return _files.front().getCols();
 	}
 
+	size_t getNFiles() const{
+		return _files.size();
+	}
+
+	const FileWithSizeReader<DataType>& getFile(size_t i) const{
+		return _files[i];
+	}
+
 	struct iterator : public std::iterator<input_iterator_tag, vector<DataType> >{
 		typedef FileWithSizeReader<DataType>						File;
 		typedef typename File::iterator								FileIterator;
@@ -215,6 +223,91 @@ public:
 	iterator end(){
 		return iterator(this->_files, true);
 	}
+
+	// Iterator over a window of the files, which are read row by row seeking
+	// to the window columns. Rows and columns are relative to the window.
+	struct window_iterator : public std::iterator<input_iterator_tag, vector<DataType> >{
+		typedef FileWithSizeReader<DataType>						File;
+		typedef vector<File>										FileVector;
+		typedef vector<DataType>									DataTypeVector;
+
+		typedef DataType 											data_type;
+		typedef vector<DataType>									value_type;
+		typedef window_iterator& 									iterator_ref;
+		typedef const window_iterator& 								iterator_ref_const;
+
+	private:
+		FileVector*					_files;
+		DataTypeVector 				_current;
+		DataTypeVector 				_rowData;
+		size_t						_startRow, _startCol, _width, _pos, _size;
+
+		void load(){
+			const size_t col = _pos % _width;
+			if(col == 0){
+				for(size_t i = 0; i < _files->size(); ++i){
+					if(!(*_files)[i].readBlock(_startRow + _pos / _width, _startCol, 1, _width, &(_rowData[i * _width]))){
+						__throw_ios_failure(__N("ERROR: window_iterator could not read the input files"));
+					}
+				}
+			}
+			for(size_t i = 0; i < _current.size(); ++i){
+				_current[i] = _rowData[i * _width + col];
+			}
+		}
+
+		window_iterator(FileVector& readers, size_t startRow, size_t startCol, size_t height, size_t width, size_t pos) :
+			_files(&readers), _current(readers.size()), _startRow(startRow), _startCol(startCol), _width(width),
+			_pos(pos), _size(height * width){
+			if(_pos < _size){
+				_rowData.resize(readers.size() * width);
+				load();
+			}
+		}
+
+		friend class MultiFileWithSizeReader<DataType>;
+
+	public:
+
+		iterator_ref operator++(){
+			if(++_pos < _size) load();
+			return *this;
+		}
+
+		size_t getRow() const {
+			return _pos / _width;
+		}
+
+		size_t getCol() const {
+			return _pos  % _width;
+		}
+
+		bool operator==(iterator_ref_const b) const{
+			return _pos == b._pos;
+		}
+
+		bool operator!=(iterator_ref_const b) const {
+			return _pos != b._pos;
+		}
+
+		value_type& operator* () {
+			return _current;
+		}
+		const value_type& operator* () const {
+			return _current;
+		}
+	};
+
+	window_iterator begin(size_t startRow, size_t startCol, size_t height, size_t width){
+		if(startRow + height > getRows() || startCol + width > getCols()){
+			__throw_invalid_argument(__N("The requested window exceeds the files size"));
+		}
+		return window_iterator(this->_files, startRow, startCol, height, width, 0);
+	}
+
+	window_iterator end(size_t startRow, size_t startCol, size_t height, size_t width){
+		return window_iterator(this->_files, startRow, startCol, height, width, height * width);
+	}
 };
 
 }
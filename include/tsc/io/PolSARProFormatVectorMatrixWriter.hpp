@@ -19,6 +19,7 @@
 #include <fstream>
 #include <string>
 #include "../policies/CheckingPolicy.hpp"
+#include "PolSARProPlaneBuffer.hpp"
 #include <tsc/util/ToString.hpp>
 
 namespace tscbpt
@@ -57,48 +58,12 @@ public:
 	template<typename InputIteratorStart, typename InputIteratorEnd>
 	void writeDataToDir(std::string basedir, InputIteratorStart first, InputIteratorEnd last, std::string prefix = string("T")){
 		const size_t matrixSize = (*first)->getModel().getMatrixSize();
-		const size_t nFiles = SubMatrixSize * SubMatrixSize * (matrixSize/SubMatrixSize);
-		size_t index = 0;
-		ofstream fileOut[nFiles];
-		std::string file;
-		float value;
-
-		index = 0;
-		for(size_t i = 1; i <= matrixSize; ++i){
-			file = basedir + string("/") + prefix + to_string(i) + to_string(i) + string(".bin");
-			fileOut[index++].open(file.data(), ios::out | ios::trunc);
-			check.ioStateOK(fileOut[index-1]);
-			size_t matrix_index = (i-1) / SubMatrixSize;
-			for(size_t j = i+1; j <= (matrix_index + 1)*SubMatrixSize; ++j){
-				fileOut[index++].open((basedir + string("/") + prefix + to_string(i) + to_string(j) + string("_real.bin")).data());
-				check.ioStateOK(fileOut[index-1]);
-				fileOut[index++].open((basedir + string("/") + prefix + to_string(i) + to_string(j) + string("_imag.bin")).data());
-				check.ioStateOK(fileOut[index-1]);
-			}
-		}
+		PolSARProPlaneBuffer<CheckingPolicy> planes(matrixSize, SubMatrixSize, basedir, prefix);
 
 		for(; first != last; ++first){
-			index = 0;
-			for (size_t i = 1; i <= matrixSize; ++i) {
-				value = (*first)->getModel()(i-1,i-1).real();
-				fileOut[index++].write(reinterpret_cast<char*>(&value), sizeof(value));
-				check.ioStateOK(fileOut[index - 1]);
-				size_t matrix_index = (i-1) / SubMatrixSize;
-				for (size_t j = i + 1; j <= (matrix_index + 1)*SubMatrixSize; ++j) {
-					complex<double> elem = (*first)->getModel()(i-1,j-1);
-					value = elem.real();
-					fileOut[index++].write(reinterpret_cast<char*>(&value), sizeof(value));
-					check.ioStateOK(fileOut[index - 1]);
-					value = elem.imag();
-					fileOut[index++].write(reinterpret_cast<char*>(&value), sizeof(value));
-					check.ioStateOK(fileOut[index - 1]);
-				}
-			}
-		}
-
-		for (size_t i = 0; i < nFiles; ++i) {
-			fileOut[i].close();
+			planes.push(*first);
 		}
+		planes.close();
 	}
 
 protected:
@@ -0,0 +1,252 @@
+/*
+ * PolSARProPlaneBuffer.hpp
+ *
+ * Copyright (c) 2015 Alberto Alonso Gonzalez
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ *  Created on: 19/10/2026
+ *      Author: Alberto Alonso-Gonzalez
+ */
+
+#ifndef POLSARPROPLANEBUFFER_HPP_
+#define POLSARPROPLANEBUFFER_HPP_
+
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <complex>
+#include <algorithm>
+#include "../policies/CheckingPolicy.hpp"
+#include <tsc/util/ToString.hpp>
+
+namespace tscbpt
+{
+
+using namespace std;
+
+/**
+ * Layout of the PolSARPro format planes (one file per matrix element plane)
+ * of a block diagonal matrix of SubMatrixSize blocks: the diagonal elements
+ * (real) and the real and imaginary parts of the upper block elements.
+ */
+class PolSARProPlaneLayout
+{
+public:
+	PolSARProPlaneLayout(size_t matrix_size, size_t sub_matrix_size) : msize(matrix_size), subMatrix_size(sub_matrix_size){}
+
+	size_t getMatrixSize() const {
+		return msize;
+	}
+
+	size_t getSubMatrixSize() const {
+		return subMatrix_size;
+	}
+
+	// Names of the planes (e.g. "C11", "C12_real", "C12_imag"), in plane order
+	vector<string> getPlaneNames(const string& prefix) const {
+		vector<string> names;
+		for (size_t i = 1; i <= msize; ++i) {
+			names.push_back(prefix + to_string(i) + to_string(i));
+			size_t matrix_index = (i - 1) / subMatrix_size;
+			for (size_t j = i + 1; j <= (matrix_index + 1) * subMatrix_size; ++j) {
+				names.push_back(prefix + to_string(i) + to_string(j) + string("_real"));
+				names.push_back(prefix + to_string(i) + to_string(j) + string("_imag"));
+			}
+		}
+		return names;
+	}
+
+	// Names of the plane files, in plane order
+	vector<string> getFileNames(const string& basedir, const string& prefix) const {
+		vector<string> names = getPlaneNames(prefix);
+		for (size_t f = 0; f < names.size(); ++f) {
+			names[f] = basedir + string("/") + names[f] + string(".bin");
+		}
+		return names;
+	}
+
+	size_t getNPlanes() const {
+		size_t n = 0;
+		for (size_t i = 1; i <= msize; ++i) {
+			n += 1 + 2 * ((((i - 1) / subMatrix_size) + 1) * subMatrix_size - i);
+		}
+		return n;
+	}
+
+	// Get the values of the model of the given element (pointer to node) for each
+	// of the planes (getNPlanes() values). Returns the number of values
+	template<typename Elem>
+	size_t extract(const Elem& el, float* out) const {
+		size_t index = 0;
+		for (size_t i = 1; i <= msize; ++i) {
+			out[index++] = el->getModel()(i - 1, i - 1).real();
+			size_t matrix_index = (i - 1) / subMatrix_size;
+			for (size_t j = i + 1; j <= (matrix_index + 1) * subMatrix_size; ++j) {
+				complex<double> elem = el->getModel()(i - 1, j - 1);
+				out[index++] = elem.real();
+				out[index++] = elem.imag();
+			}
+		}
+		return index;
+	}
+
+private:
+	size_t msize;
+	size_t subMatrix_size;
+};
+
+/**
+ * Set of PolSARPro format files (one per matrix element plane) for the
+ * elements of a block diagonal matrix of SubMatrixSize blocks.
+ *
+ * The element values are gathered into per-file float buffers, which are
+ * written with a single write call per file when full. The files are written
+ * concurrently (OpenMP) and the stream states are checked after each flush.
+ * On a writing error the buffered values are discarded, and the destructor
+ * closes the files ignoring any error (see close() to check them).
+ */
+template<
+	class CheckingPolicy	= FullCheckingPolicy
+	>
+class PolSARProPlaneBuffer
+{
+public:
+	typedef CheckingPolicy			CheckPol;
+
+	static const size_t		DEFAULT_BUFFER_MB	= 32;
+
+	// maxElems (if not 0) bounds the buffers to the number of elements to be written
+	PolSARProPlaneBuffer(size_t matrix_size, size_t sub_matrix_size, string basedir, string prefix,
+			size_t bufferMB = DEFAULT_BUFFER_MB, size_t maxElems = 0) : layout(matrix_size, sub_matrix_size), nElems(0){
+		const vector<string> names = layout.getFileNames(basedir, prefix);
+		try{
+			for (size_t f = 0; f < names.size(); ++f) {
+				openFile(names[f]);
+			}
+		}catch(...){
+			// Close the files already opened
+			release();
+			throw;
+		}
+		capacity = bufferCapacity(fileOut.size(), bufferMB, maxElems);
+		for (size_t f = 0; f < buffers.size(); ++f) buffers[f].resize(capacity);
+		values.resize(fileOut.size());
+	}
+
+	~PolSARProPlaneBuffer(){
+		try{
+			close();
+		}catch(...){
+			// The files have been released by close()
+		}
+	}
+
+	size_t getNFiles() const {
+		return fileOut.size();
+	}
+
+	// Elements buffered per file, for the given number of files, buffer size and bound
+	static size_t bufferCapacity(size_t nFiles, size_t bufferMB = DEFAULT_BUFFER_MB, size_t maxElems = 0){
+		size_t elems = max(static_cast<size_t>(1), (max(bufferMB, static_cast<size_t>(1)) << 20) / (nFiles * sizeof(float)));
+		if(maxElems > 0) elems = min(elems, maxElems);
+		return elems;
+	}
+
+	const PolSARProPlaneLayout& getLayout() const {
+		return layout;
+	}
+
+	// Get the values of the model of the given element (pointer to node) for each
+	// of the planes (getNFiles() values). Returns the number of values
+	template<typename Elem>
+	size_t extract(const Elem& el, float* out) const {
+		return layout.extract(el, out);
+	}
+
+	// Append the given plane values (as obtained by extract()). Returns the bytes appended
+	size_t push_values(const float* in){
+		if(nElems == capacity) flush();
+		for (size_t f = 0; f < buffers.size(); ++f) {
+			buffers[f][nElems] = in[f];
+		}
+		++nElems;
+		return buffers.size() * sizeof(float);
+	}
+
+	// Append the model of the given element (pointer to node) to the planes. Returns the bytes appended
+	template<typename Elem>
+	size_t push(const Elem& el){
+		extract(el, &(values[0]));
+		return push_values(&(values[0]));
+	}
+
+	// Write the buffered values of all the planes
+	void flush(){
+		if(nElems == 0) return;
+		const int nFiles = static_cast<int>(fileOut.size());
+		#pragma omp parallel for schedule(dynamic, 1)
+		for (int f = 0; f < nFiles; ++f) {
+			fileOut[f]->write(reinterpret_cast<const char*>(&(buffers[f][0])), nElems * sizeof(float));
+		}
+		// The values are not written again if the check fails
+		nElems = 0;
+		for (size_t f = 0; f < fileOut.size(); ++f) check.ioStateOK(*(fileOut[f]));
+	}
+
+	// Flush the buffers and close all the files (released even if the flush fails)
+	void close(){
+		if(fileOut.empty()) return;
+		try{
+			flush();
+		}catch(...){
+			release();
+			throw;
+		}
+		for (size_t f = 0; f < fileOut.size(); ++f) {
+			fileOut[f]->close();
+		}
+		release();
+	}
+
+private:
+	// Non copyable (owns the streams)
+	PolSARProPlaneBuffer(const PolSARProPlaneBuffer&);
+	PolSARProPlaneBuffer& operator=(const PolSARProPlaneBuffer&);
+
+	// Delete the streams (closing the files) and the buffers, without checking their state
+	void release(){
+		for (size_t f = 0; f < fileOut.size(); ++f) {
+			delete fileOut[f];
+		}
+		fileOut.clear();
+		buffers.clear();
+		nElems = 0;
+	}
+
+	void openFile(const string& file){
+		fileOut.push_back(new ofstream(file.data(), ios::out | ios::trunc));
+		buffers.push_back(vector<float>());
+		check.ioStateOK(*(fileOut.back()));
+	}
+
+	PolSARProPlaneLayout layout;
+	size_t capacity, nElems;
+	vector<ofstream*> fileOut;
+	vector<vector<float> > buffers;
+	vector<float> values;
+
+protected:
+	static const CheckPol		check;
+};
+
+template <class CheckingPolicy>
+const typename PolSARProPlaneBuffer<CheckingPolicy>::CheckPol PolSARProPlaneBuffer<CheckingPolicy>::check;
+
+}
+
+#endif /* POLSARPROPLANEBUFFER_HPP_ */
@@ -0,0 +1,205 @@
+/*
+ * RegionFeatureTableWriter.hpp
+ *
+ * Copyright (c) 2015 Alberto Alonso Gonzalez
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ *  Created on: 19/10/2026
+ *      Author: Alberto Alonso-Gonzalez
+ */
+
+#ifndef REGIONFEATURETABLEWRITER_HPP_
+#define REGIONFEATURETABLEWRITER_HPP_
+
+#include <cstddef>
+#include <cstring>
+#include <stdint.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "PolSARProPlaneBuffer.hpp"
+#include "../bpt/NodeShapeTable.hpp"
+#include "../policies/CheckingPolicy.hpp"
+
+namespace tscbpt
+{
+
+using namespace std;
+
+/**
+ * Writer of a columnar table of per-region features (e.g. of the pruned set),
+ * for classifiers working at region level.
+ *
+ * The table is written into two files: base + ".bin" with the values of each
+ * column for all the regions, one column after the other (native endianness,
+ * each column starting at a multiple of 8 bytes), and base + ".json" with the
+ * schema (name, type and byte offset of each column).
+ *
+ * The default columns are computed in one parallel pass over the regions from
+ * their models and the NodeShapeTable of the tree: id (uint32), area (uint64),
+ * centroid_row, centroid_col (float64), bbox_min_row, bbox_min_col,
+ * bbox_max_row, bbox_max_col (uint32), perimeter (uint64), tss (float64) and
+ * the mean covariance as float32 PolSARPro planes (e.g. "C11", "C12_real",
+ * "C12_imag", see PolSARProPlaneLayout). Other float64 columns may be added as
+ * functors over the region node pointers (e.g. temporal stability).
+ *
+ * The region model must provide getTotalSumOfSquares() (AddHomogeneity) and
+ * its position (getDim(0) column, getDim(1) row, mean of the pixels).
+ */
+template<
+	typename	TNodePointer,
+	class 		CheckingPolicy		= FullCheckingPolicy
+	>
+class RegionFeatureTableWriter
+{
+public:
+	typedef TNodePointer			NodePointer;
+	typedef CheckingPolicy			CheckPol;
+
+	/**
+	 * @param prefix name prefix of the covariance planes ("C", "T")
+	 */
+	RegionFeatureTableWriter(size_t subMatrixSize, const string& prefix) : _subMatrixSize(subMatrixSize), _prefix(prefix){}
+
+	template<class NodeSet>
+	void setRegions(const NodeSet& regions, const NodeShapeTable& shapes){
+		_regions.assign(regions.begin(), regions.end());
+		_columns.clear();
+		if(_regions.empty()) return;
+
+		const PolSARProPlaneLayout layout(_regions.front()->getModel().getMatrixSize(), _subMatrixSize);
+		const vector<string> planes = layout.getPlaneNames(_prefix);
+		newColumn<uint32_t>("id", "uint32");
+		newColumn<uint64_t>("area", "uint64");
+		newColumn<double>("centroid_row", "float64");
+		newColumn<double>("centroid_col", "float64");
+		newColumn<uint32_t>("bbox_min_row", "uint32");
+		newColumn<uint32_t>("bbox_min_col", "uint32");
+		newColumn<uint32_t>("bbox_max_row", "uint32");
+		newColumn<uint32_t>("bbox_max_col", "uint32");
+		newColumn<uint64_t>("perimeter", "uint64");
+		newColumn<double>("tss", "float64");
+		for(size_t f = 0; f < planes.size(); ++f) newColumn<float>(planes[f], "float32");
+
+		const int n = static_cast<int>(_regions.size());
+		#pragma omp parallel
+		{
+			vector<float> values(planes.size());
+			#pragma omp for schedule(static)
+			for(int i = 0; i < n; ++i){
+				const NodePointer& np = _regions[i];
+				const NodeShapeTable::Shape& s = shapes[np->getId()];
+				column<uint32_t>(0)[i] = static_cast<uint32_t>(np->getId());
+				column<uint64_t>(1)[i] = np->getModel().getSubnodes();
+				column<double>(2)[i] = np->getModel().getDim(1);
+				column<double>(3)[i] = np->getModel().getDim(0);
+				column<uint32_t>(4)[i] = s.minRow;
+				column<uint32_t>(5)[i] = s.minCol;
+				column<uint32_t>(6)[i] = s.maxRow;
+				column<uint32_t>(7)[i] = s.maxCol;
+				column<uint64_t>(8)[i] = s.perimeter;
+				column<double>(9)[i] = np->getModel().getTotalSumOfSquares();
+				layout.extract(np, &(values[0]));
+				for(size_t f = 0; f < values.size(); ++f) column<float>(10 + f)[i] = values[f];
+			}
+		}
+	}
+
+	// Add a per-region float64 column, computed with f for each region
+	template<class Functor>
+	void addColumn(const string& name, Functor f){
+		newColumn<double>(name, "float64");
+		for(size_t i = 0; i < _regions.size(); ++i) column<double>(_columns.size() - 1)[i] = static_cast<double>(f(_regions[i]));
+	}
+
+	size_t getNRegions() const {
+		return _regions.size();
+	}
+
+	size_t getNColumns() const {
+		return _columns.size();
+	}
+
+	// Write the table into base.bin and its schema into base.json
+	void writeToFiles(const string& base, size_t rows, size_t cols) const {
+		const string dataFile = base + ".bin";
+		ofstream os(dataFile.c_str(), ios::out | ios::trunc | ios::binary);
+		check.ioStateOK(os);
+		ostringstream schema;
+		schema << "{\n";
+		schema << "  \"format\": \"tscbpt-region-features\",\n";
+		schema << "  \"version\": 1,\n";
+		schema << "  \"byte_order\": \"" << (littleEndian() ? "little" : "big") << "\",\n";
+		schema << "  \"data\": \"" << dataFile.substr(dataFile.find_last_of('/') + 1) << "\",\n";
+		schema << "  \"image_rows\": " << rows << ",\n";
+		schema << "  \"image_cols\": " << cols << ",\n";
+		schema << "  \"regions\": " << _regions.size() << ",\n";
+		schema << "  \"columns\": [";
+		uint64_t offset = 0;
+		static const char padding[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+		for(size_t c = 0; c < _columns.size(); ++c){
+			const Column& col = _columns[c];
+			schema << (c ? ",\n" : "\n") << "    {\"name\": \"" << col.name << "\", \"type\": \"" << col.type
+					<< "\", \"offset\": " << offset << "}";
+			if(!col.data.empty()) os.write(&(col.data[0]), col.data.size());
+			offset += col.data.size();
+			const size_t pad = (8 - offset % 8) % 8;
+			os.write(padding, pad);
+			offset += pad;
+		}
+		schema << "\n  ]\n}\n";
+		check.ioStateOK(os);
+		os.close();
+
+		ofstream js((base + ".json").c_str(), ios::out | ios::trunc);
+		check.ioStateOK(js);
+		js << schema.str();
+		check.ioStateOK(js);
+		js.close();
+	}
+
+private:
+	struct Column
+	{
+		string			name, type;
+		vector<char>	data;
+	};
+
+	template<typename T>
+	void newColumn(const string& name, const char* type){
+		_columns.push_back(Column());
+		_columns.back().name = name;
+		_columns.back().type = type;
+		_columns.back().data.resize(_regions.size() * sizeof(T));
+	}
+
+	template<typename T>
+	T* column(size_t c){
+		return reinterpret_cast<T*>(&(_columns[c].data[0]));
+	}
+
+	static bool littleEndian(){
+		const uint16_t one = 1;
+		return *reinterpret_cast<const char*>(&one) == 1;
+	}
+
+	size_t					_subMatrixSize;
+	string					_prefix;
+	vector<NodePointer>		_regions;
+	vector<Column>			_columns;
+
+protected:
+	static const CheckPol		check;
+};
+
+template <typename TNodePointer, class CheckingPolicy>
+const typename RegionFeatureTableWriter<TNodePointer, CheckingPolicy>::CheckPol RegionFeatureTableWriter<TNodePointer, CheckingPolicy>::check;
+
+}
+
+#endif /* REGIONFEATURETABLEWRITER_HPP_ */
@@ -0,0 +1,193 @@
+/*
+ * RegionLabelMapFormat.hpp
+ *
+ * Copyright (c) 2015 Alberto Alonso Gonzalez
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ *  Created on: 19/10/2026
+ *      Author: Alberto Alonso-Gonzalez
+ */
+
+#ifndef REGIONLABELMAPFORMAT_HPP_
+#define REGIONLABELMAPFORMAT_HPP_
+
+#include <cstddef>
+#include <cstring>
+#include <stdint.h>
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#ifdef TSCBPT_USE_LZ4
+#include <lz4.h>
+#endif
+
+namespace tscbpt
+{
+
+/**
+ * Common definitions of the compact region label map format (.lbl files),
+ * written by RegionLabelMapWriter and read by RegionLabelMapReader.
+ *
+ * File layout (native endianness):
+ *   char[8]	magic ("TSCLBL01")
+ *   uint32		flags (FLAG_LZ4 if the blocks may be LZ4 compressed)
+ *   uint64		payload size (bytes)
+ *   uint32		number of blocks
+ *   blocks:	uint32 raw size, uint32 stored size, stored data
+ *              (stored size == raw size means an uncompressed block)
+ *
+ * Payload layout (varint: LEB128 unsigned, zigzag for signed values):
+ *   varint		rows, cols, number of regions, number of columns
+ *   columns:	varint name length, name chars
+ *   uint32		region ids[number of regions]
+ *   double		values[number of columns][number of regions]
+ *   rows:		varint number of runs, runs: varint zigzag(region index delta
+ *              with the previous run), varint run length
+ */
+namespace label_map
+{
+
+static const char		MAGIC[8]		= {'T', 'S', 'C', 'L', 'B', 'L', '0', '1'};
+static const uint32_t	FLAG_LZ4		= 1;
+static const size_t		BLOCK_SIZE		= 1 << 22;
+
+inline void putVarint(std::vector<char>& out, uint64_t value){
+	while(value >= 0x80){
+		out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+		value >>= 7;
+	}
+	out.push_back(static_cast<char>(value));
+}
+
+inline uint64_t getVarint(const char*& p, const char* end){
+	uint64_t value = 0;
+	for(unsigned shift = 0; p < end && shift < 64; shift += 7){
+		const unsigned char byte = static_cast<unsigned char>(*p++);
+		value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+		if(!(byte & 0x80)) return value;
+	}
+	std::__throw_runtime_error("ERROR: Corrupted region label map (varint)");
+	return value;
+}
+
+inline uint64_t zigzag(int64_t value){
+	return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+inline int64_t unzigzag(uint64_t value){
+	return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+template<typename T>
+inline void putRaw(std::vector<char>& out, const T* values, size_t n){
+	const char* p = reinterpret_cast<const char*>(values);
+	out.insert(out.end(), p, p + n * sizeof(T));
+}
+
+template<typename T>
+inline void getRaw(const char*& p, const char* end, T* values, size_t n){
+	if(static_cast<size_t>(end - p) < n * sizeof(T))
+		std::__throw_runtime_error("ERROR: Corrupted region label map (truncated data)");
+	memcpy(values, p, n * sizeof(T));
+	p += n * sizeof(T);
+}
+
+/**
+ * Write the header and the payload split into blocks, LZ4 compressed in
+ * parallel if requested (and available at compile time)
+ */
+inline void writeBlocks(std::ostream& os, const std::vector<char>& payload, bool compress){
+#ifndef TSCBPT_USE_LZ4
+	compress = false;
+#endif
+	const uint32_t flags = compress ? FLAG_LZ4 : 0;
+	const uint64_t size = payload.size();
+	const int nblocks = static_cast<int>((payload.size() + BLOCK_SIZE - 1) / BLOCK_SIZE);
+	const uint32_t nb = nblocks;
+	std::vector<std::vector<char> > stored(nblocks);
+
+	#pragma omp parallel for schedule(dynamic, 1)
+	for(int b = 0; b < nblocks; ++b){
+		const char* raw = &(payload[b * BLOCK_SIZE]);
+		const size_t rawLen = std::min(BLOCK_SIZE, payload.size() - b * BLOCK_SIZE);
+#ifdef TSCBPT_USE_LZ4
+		if(compress){
+			stored[b].resize(LZ4_compressBound(static_cast<int>(rawLen)));
+			const int len = LZ4_compress_default(raw, &(stored[b][0]), static_cast<int>(rawLen), static_cast<int>(stored[b].size()));
+			if(len > 0 && static_cast<size_t>(len) < rawLen){
+				stored[b].resize(len);
+				continue;
+			}
+		}
+#endif
+		stored[b].assign(raw, raw + rawLen);
+	}
+
+	os.write(MAGIC, sizeof(MAGIC));
+	os.write(reinterpret_cast<const char*>(&flags), sizeof(flags));
+	os.write(reinterpret_cast<const char*>(&size), sizeof(size));
+	os.write(reinterpret_cast<const char*>(&nb), sizeof(nb));
+	for(int b = 0; b < nblocks; ++b){
+		const uint32_t rawLen = std::min(BLOCK_SIZE, payload.size() - b * BLOCK_SIZE);
+		const uint32_t storedLen = stored[b].size();
+		os.write(reinterpret_cast<const char*>(&rawLen), sizeof(rawLen));
+		os.write(reinterpret_cast<const char*>(&storedLen), sizeof(storedLen));
+		os.write(&(stored[b][0]), storedLen);
+	}
+}
+
+/**
+ * Read the header and all the blocks into payload
+ */
+inline void readBlocks(std::istream& is, std::vector<char>& payload){
+	char magic[sizeof(MAGIC)];
+	uint32_t flags = 0, nblocks = 0;
+	uint64_t size = 0;
+	is.read(magic, sizeof(magic));
+	is.read(reinterpret_cast<char*>(&flags), sizeof(flags));
+	is.read(reinterpret_cast<char*>(&size), sizeof(size));
+	is.read(reinterpret_cast<char*>(&nblocks), sizeof(nblocks));
+	if(!is.good() || memcmp(magic, MAGIC, sizeof(MAGIC)) != 0)
+		std::__throw_runtime_error("ERROR: Not a region label map file");
+#ifndef TSCBPT_USE_LZ4
+	if(flags & FLAG_LZ4)
+		std::__throw_runtime_error("ERROR: LZ4 compressed region label map, but LZ4 support is not compiled in (TSCBPT_USE_LZ4)");
+#endif
+
+	payload.resize(size);
+	std::vector<char> stored;
+	size_t offset = 0;
+	for(uint32_t b = 0; b < nblocks; ++b){
+		uint32_t rawLen = 0, storedLen = 0;
+		is.read(reinterpret_cast<char*>(&rawLen), sizeof(rawLen));
+		is.read(reinterpret_cast<char*>(&storedLen), sizeof(storedLen));
+		if(!is.good() || offset + rawLen > size)
+			std::__throw_runtime_error("ERROR: Corrupted region label map (block header)");
+		if(storedLen == rawLen){
+			is.read(&(payload[offset]), rawLen);
+		}else{
+			stored.resize(storedLen);
+			is.read(&(stored[0]), storedLen);
+#ifdef TSCBPT_USE_LZ4
+			if(LZ4_decompress_safe(&(stored[0]), &(payload[offset]), static_cast<int>(storedLen), static_cast<int>(rawLen)) != static_cast<int>(rawLen))
+#endif
+				std::__throw_runtime_error("ERROR: Corrupted region label map (compressed block)");
+		}
+		if(!is.good())
+			std::__throw_runtime_error("ERROR: Corrupted region label map (truncated block)");
+		offset += rawLen;
+	}
+	if(offset != size)
+		std::__throw_runtime_error("ERROR: Corrupted region label map (payload size)");
+}
+
+}
+
+}
+
+#endif /* REGIONLABELMAPFORMAT_HPP_ */
@@ -0,0 +1,125 @@
+/*
+ * RegionLabelMapReader.hpp
+ *
+ * Copyright (c) 2015 Alberto Alonso Gonzalez
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ *  Created on: 19/10/2026
+ *      Author: Alberto Alonso-Gonzalez
+ */
+
+#ifndef REGIONLABELMAPREADER_HPP_
+#define REGIONLABELMAPREADER_HPP_
+
+#include <cstddef>
+#include <stdint.h>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "RegionLabelMapFormat.hpp"
+
+namespace tscbpt
+{
+
+using namespace std;
+
+/**
+ * Reader of the compact region label map format written by
+ * RegionLabelMapWriter. The raster is decoded into the region index
+ * (position in the region table) of each pixel.
+ */
+class RegionLabelMapReader
+{
+public:
+	RegionLabelMapReader(const string& file){
+		using namespace label_map;
+		ifstream is(file.c_str(), ios::in | ios::binary);
+		if(is.fail()) __throw_ios_failure(__N("ERROR: Region label map file cannot be opened"));
+		vector<char> payload;
+		readBlocks(is, payload);
+		is.close();
+
+		const char* p = payload.empty() ? NULL : &(payload[0]);
+		const char* end = p + payload.size();
+		_rows = getVarint(p, end);
+		_cols = getVarint(p, end);
+		const size_t nregions = getVarint(p, end);
+		_names.resize(getVarint(p, end));
+		for(size_t c = 0; c < _names.size(); ++c){
+			const size_t len = getVarint(p, end);
+			_names[c].resize(len);
+			if(len > 0) getRaw(p, end, &(_names[c][0]), len);
+		}
+		_ids.resize(nregions);
+		if(nregions > 0) getRaw(p, end, &(_ids[0]), nregions);
+		_values.resize(_names.size(), vector<double>(nregions));
+		for(size_t c = 0; c < _values.size(); ++c){
+			if(nregions > 0) getRaw(p, end, &(_values[c][0]), nregions);
+		}
+
+		_labels.resize(_rows * _cols);
+		int64_t index = 0;
+		for(size_t r = 0, pos = 0; r < _rows; ++r){
+			const size_t nruns = getVarint(p, end);
+			for(size_t i = 0; i < nruns; ++i){
+				index += unzigzag(getVarint(p, end));
+				const size_t length = getVarint(p, end);
+				if(index < 0 || static_cast<size_t>(index) >= nregions || pos + length > (r + 1) * _cols)
+					__throw_runtime_error(__N("ERROR: Corrupted region label map (runs)"));
+				std::fill(_labels.begin() + pos, _labels.begin() + pos + length, static_cast<uint32_t>(index));
+				pos += length;
+			}
+			if(pos != (r + 1) * _cols) __throw_runtime_error(__N("ERROR: Corrupted region label map (row length)"));
+		}
+	}
+
+	size_t getRows() const {
+		return _rows;
+	}
+
+	size_t getCols() const {
+		return _cols;
+	}
+
+	size_t getNRegions() const {
+		return _ids.size();
+	}
+
+	size_t getNColumns() const {
+		return _names.size();
+	}
+
+	// Id (BPT node id) of each region
+	const vector<uint32_t>& getIds() const {
+		return _ids;
+	}
+
+	const string& getColumnName(size_t c) const {
+		return _names[c];
+	}
+
+	// Value of the given column for each region
+	const vector<double>& getColumn(size_t c) const {
+		return _values[c];
+	}
+
+	// Region index of each pixel (row major)
+	const vector<uint32_t>& getLabels() const {
+		return _labels;
+	}
+
+private:
+	size_t						_rows, _cols;
+	vector<string>				_names;
+	vector<uint32_t>			_ids;
+	vector<vector<double> >		_values;
+	vector<uint32_t>			_labels;
+};
+
+}
+
+#endif /* REGIONLABELMAPREADER_HPP_ */
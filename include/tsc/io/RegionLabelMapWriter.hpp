@@ -0,0 +1,143 @@
+/*
+ * RegionLabelMapWriter.hpp
+ *
+ * Copyright (c) 2015 Alberto Alonso Gonzalez
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ *  Created on: 19/10/2026
+ *      Author: Alberto Alonso-Gonzalez
+ */
+
+#ifndef REGIONLABELMAPWRITER_HPP_
+#define REGIONLABELMAPWRITER_HPP_
+
+#include <cstddef>
+#include <stdint.h>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <map>
+#include "RegionLabelMapFormat.hpp"
+#include "../policies/CheckingPolicy.hpp"
+
+namespace tscbpt
+{
+
+using namespace std;
+
+/**
+ * Writer of the compact region label map format (see RegionLabelMapFormat.hpp).
+ *
+ * Instead of one value per pixel for the region id and for each per-region
+ * scalar, it stores a table with the id and the scalar values (columns) of
+ * each region, plus a row run-length encoded raster of region indexes.
+ *
+ * Usage: set the regions (e.g. the pruned set), add the scalar columns as
+ * functors over the region node pointers, and write the file from the label
+ * raster (node pointer of each pixel, row major, e.g. a BPTDataSource).
+ */
+template<
+	typename	TNodePointer,
+	class 		CheckingPolicy		= FullCheckingPolicy
+	>
+class RegionLabelMapWriter
+{
+public:
+	typedef TNodePointer			NodePointer;
+	typedef CheckingPolicy			CheckPol;
+
+	RegionLabelMapWriter(size_t rows, size_t cols, bool compress = false) : _rows(rows), _cols(cols), _compress(compress){}
+
+	template<class NodeSet>
+	void setRegions(const NodeSet& regions){
+		_regions.assign(regions.begin(), regions.end());
+		_index.clear();
+		for(size_t i = 0; i < _regions.size(); ++i) _index[_regions[i]] = i;
+		_names.clear();
+		_values.clear();
+	}
+
+	// Add a per-region scalar column, computed with f for each region
+	template<class Functor>
+	void addColumn(const string& name, Functor f){
+		_names.push_back(name);
+		_values.push_back(vector<double>(_regions.size()));
+		for(size_t i = 0; i < _regions.size(); ++i) _values.back()[i] = static_cast<double>(f(_regions[i]));
+	}
+
+	size_t getNRegions() const {
+		return _regions.size();
+	}
+
+	// Write the file, taking the region of each pixel from [first, last)
+	template<typename InputIteratorStart, typename InputIteratorEnd>
+	void writeToFile(const string& file, InputIteratorStart first, InputIteratorEnd last){
+		using namespace label_map;
+		vector<char> payload;
+		putVarint(payload, _rows);
+		putVarint(payload, _cols);
+		putVarint(payload, _regions.size());
+		putVarint(payload, _names.size());
+		for(size_t c = 0; c < _names.size(); ++c){
+			putVarint(payload, _names[c].size());
+			payload.insert(payload.end(), _names[c].begin(), _names[c].end());
+		}
+		vector<uint32_t> ids(_regions.size());
+		for(size_t i = 0; i < _regions.size(); ++i) ids[i] = static_cast<uint32_t>(_regions[i]->getId());
+		if(!ids.empty()) putRaw(payload, &(ids[0]), ids.size());
+		for(size_t c = 0; c < _values.size(); ++c){
+			if(!_values[c].empty()) putRaw(payload, &(_values[c][0]), _values[c].size());
+		}
+
+		// Row run-length encoded raster of region indexes
+		vector<uint64_t> runs;
+		NodePointer current = NodePointer();
+		int64_t index = 0, previous = 0;
+		for(size_t r = 0; r < _rows; ++r){
+			runs.clear();
+			for(size_t c = 0; c < _cols; ++c, ++first){
+				if(!(first != last)) __throw_length_error(__N("ERROR: Region label raster smaller than rows x cols"));
+				if(c == 0 || *first != current){
+					current = *first;
+					typename map<NodePointer, size_t>::const_iterator it = _index.find(current);
+					if(it == _index.end()) __throw_invalid_argument(__N("ERROR: Pixel region not found in the region table"));
+					index = it->second;
+					runs.push_back(zigzag(index - previous));
+					runs.push_back(0);
+					previous = index;
+				}
+				++runs.back();
+			}
+			putVarint(payload, runs.size() / 2);
+			for(size_t i = 0; i < runs.size(); ++i) putVarint(payload, runs[i]);
+		}
+
+		ofstream os(file.c_str(), ios::out | ios::trunc | ios::binary);
+		check.ioStateOK(os);
+		writeBlocks(os, payload, _compress);
+		check.ioStateOK(os);
+		os.close();
+	}
+
+private:
+	size_t						_rows, _cols;
+	bool						_compress;
+	vector<NodePointer>			_regions;
+	map<NodePointer, size_t>	_index;
+	vector<string>				_names;
+	vector<vector<double> >		_values;
+
+protected:
+	static const CheckPol		check;
+};
+
+template <typename TNodePointer, class CheckingPolicy>
+const typename RegionLabelMapWriter<TNodePointer, CheckingPolicy>::CheckPol RegionLabelMapWriter<TNodePointer, CheckingPolicy>::check;
+
+}
+
+#endif /* REGIONLABELMAPWRITER_HPP_ */
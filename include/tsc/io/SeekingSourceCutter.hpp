@@ -0,0 +1,70 @@
+/*
+ * SeekingSourceCutter.hpp
+ *
+ * Copyright (c) 2015 Alberto Alonso Gonzalez
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ *  Created on: 19/10/2026
+ *      Author: Alberto Alonso-Gonzalez
+ */
+
+#ifndef SEEKINGSOURCECUTTER_HPP_
+#define SEEKINGSOURCECUTTER_HPP_
+
+#include <stddef.h>
+
+namespace tscbpt
+{
+
+/**
+ * Source cutter that asks the underlying source to read only the crop window,
+ * instead of iterating through the whole source and discarding the pixels
+ * outside it (as SourceCutter does).
+ *
+ * TSource must provide a window_iterator type and the begin(startRow, startCol,
+ * height, width) and end(startRow, startCol, height, width) methods, as
+ * MultiFileWithSizeReader does. Place it directly over the reader, below any
+ * SourceWrapper.
+ */
+template <class TSource>
+class SeekingSourceCutter
+{
+
+public:
+
+	typedef TSource 								SourceType;
+	typedef typename SourceType::window_iterator	iterator;
+
+	SeekingSourceCutter(SourceType& asource, size_t startRow, size_t startCol, size_t height, size_t width) :
+		_xs(startCol), _ys(startRow), _height(height), _width(width), _source(asource){}
+
+	size_t getRows() const {
+		return _height;
+	}
+
+	size_t getCols() const {
+		return _width;
+	}
+
+	iterator begin() {
+		return _source.begin(_ys, _xs, _height, _width);
+	}
+
+	iterator end() {
+		return _source.end(_ys, _xs, _height, _width);
+	}
+
+private:
+	size_t _xs,_ys;
+	size_t _height,_width;
+	SourceType& _source;
+
+};
+
+}
+
+#endif /* SEEKINGSOURCECUTTER_HPP_ */
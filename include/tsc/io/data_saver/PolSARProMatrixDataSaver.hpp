@@ -17,6 +17,7 @@
 
 #include "DataSaver.hpp"
 #include "../../policies/CheckingPolicy.hpp"
+#include "../PolSARProPlaneBuffer.hpp"
 #include <tsc/util/ToString.hpp>
 #include <cstddef>
 #include <iostream>
@@ -40,11 +41,7 @@ public:
 	typedef CheckingPolicy			CheckPol;
 	typedef PolSARProMatrixDataSaver<CheckingPolicy>	this_type;
 
-	PolSARProMatrixDataSaver(size_t matrix_size, size_t sub_matrix_size, string basedir, string prefix = string("C")): msize(matrix_size), subMatrix_size(sub_matrix_size){
-		const size_t nFiles = subMatrix_size * subMatrix_size * (msize / subMatrix_size);
-		fileOut = new ofstream[nFiles];
-		string file;
-		size_t index = 0;
+	PolSARProMatrixDataSaver(size_t matrix_size, size_t sub_matrix_size, string basedir, string prefix = string("C")){
 		{	// Creating the directory path basedir
 			struct stat fstat;
 			if (stat(basedir.c_str(), &fstat) != 0){
@@ -52,58 +49,24 @@ public:
 				assert(mkdir(basedir.c_str(), S_IRWXU)==0);
 			}
 		}
-		for (size_t i = 1; i <= msize; ++i) {
-			file = basedir + string("/") + prefix + to_string(i) + to_string(i)	+ string(".bin");
-			fileOut[index++].open(file.data(), ios::out | ios::trunc);
-			check.ioStateOK(fileOut[index-1]);
-			size_t matrix_index = (i - 1) / subMatrix_size;
-			for (size_t j = i + 1; j <= (matrix_index + 1) * subMatrix_size;
-					++j) {
-				fileOut[index++].open((basedir + string("/") + prefix + to_string(i) + to_string(j) + string("_real.bin")).data(), ios::out | ios::trunc);
-				check.ioStateOK(fileOut[index-1]);
-				fileOut[index++].open((basedir + string("/") + prefix + to_string(i) + to_string(j) + string("_imag.bin")).data(), ios::out | ios::trunc);
-				check.ioStateOK(fileOut[index-1]);
-			}
-		}
+		planes = new PolSARProPlaneBuffer<CheckingPolicy>(matrix_size, sub_matrix_size, basedir, prefix);
 	}
 
 	template<typename Elem>
 	size_t save_elem(Elem el){
-		size_t index = 0;
-		float value;
-		for (size_t i = 1; i <= msize; ++i) {
-			value = el->getModel()(i - 1, i - 1).real();
-			fileOut[index++].write(reinterpret_cast<char*>(&value), sizeof(value));
-			check.ioStateOK(fileOut[index - 1]);
-			size_t matrix_index = (i - 1) / subMatrix_size;
-			for (size_t j = i + 1; j <= (matrix_index + 1) * subMatrix_size; ++j) {
-				complex<double> elem = el->getModel()(i - 1, j - 1);
-				value = elem.real();
-				fileOut[index++].write(reinterpret_cast<char*>(&value), sizeof(value));
-				check.ioStateOK(fileOut[index - 1]);
-				value = elem.imag();
-				fileOut[index++].write(reinterpret_cast<char*>(&value), sizeof(value));
-				check.ioStateOK(fileOut[index - 1]);
-			}
-		}
-		return index * sizeof(value);
+		return planes->push(el);
 	}
 
 	void finalize(){
-		const size_t nFiles = subMatrix_size * subMatrix_size * (msize/subMatrix_size);
-		for (size_t i = 0; i < nFiles; ++i) {
-			fileOut[i].close();
-		}
+		planes->close();
 	}
 
 	~PolSARProMatrixDataSaver(){
-		if(fileOut) delete[] fileOut;
+		if(planes) delete planes;
 	}
 
 private:
-	size_t msize;
-	ofstream* fileOut;
-	size_t subMatrix_size;
+	PolSARProPlaneBuffer<CheckingPolicy>* planes;
 
 protected:
 	static const CheckPol		check;
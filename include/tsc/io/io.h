@@ -19,17 +19,26 @@
 #include "FileWithSizeReader.hpp"
 #include "WrapperIterator.hpp"
 #include "MultiFileWithSizeReader.hpp"
+#include "MultiFileBlockReader.hpp"
+#include "MemoryStripReader.hpp"
 #include "FileHMatrixReader.hpp"
 #include "BinaryFileIterator.hpp"
 #include "PolSARProFormatMatrixWriter.hpp"
 #include "PolSARProFormatVectorMatrixWriter.hpp"
+#include "PolSARProPlaneBuffer.hpp"
 #include "SourceWrapper.hpp"
 #include "MatrixImageReader.hpp"
 #include "SourceComposer.hpp"
 #include "PixelIteratorWrapper.hpp"
 #include "SourceCutter.hpp"
+#include "SeekingSourceCutter.hpp"
 
 #include "VectorDataWriter.hpp"
+#include "RegionLabelMapWriter.hpp"
+#include "RegionLabelMapReader.hpp"
+#include "RegionFeatureTableWriter.hpp"
+#include "BPTTreeFileWriter.hpp"
+#include "MappedBPTTree.hpp"
 
 #include "data_saver/PolSARProMatrixDataSaver.hpp"
 
@@ -0,0 +1,233 @@
+/*
+ * StageProfiler.hpp
+ *
+ * Copyright (c) 2015 Alberto Alonso Gonzalez
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ *  Created on: 19/10/2026
+ *      Author: Alberto Alonso-Gonzalez
+ */
+
+#ifndef STAGEPROFILER_HPP_
+#define STAGEPROFILER_HPP_
+
+#include <cstddef>
+#include <ctime>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <utility>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <tsc/util/MemoryUsage.hpp>
+
+namespace tscbpt
+{
+
+using namespace std;
+
+/**
+ * Instrumentation of the processing stages of a run: wall clock (monotonic)
+ * and CPU time (user + system of all the threads) of each stage, with the
+ * peak resident set size at its end, plus named counters (e.g. bytes
+ * written) and information values. The whole run is reported as JSON with
+ * writeReport(), including the peak and final resident set sizes.
+ *
+ * Stages are timed with scoped timers (StageProfiler::Scope); a stage timed
+ * several times (e.g. once per prune) accumulates its times and calls.
+ */
+class StageProfiler
+{
+public:
+	// Scoped timer of a stage, accumulated into the profiler when stopped or
+	// on destruction
+	class Scope
+	{
+	public:
+		Scope(StageProfiler& profiler, const string& stage) :
+			_profiler(profiler), _stage(stage), _wall(wallTime()), _cpu(cpuTime()), _elapsed(-1){}
+
+		~Scope(){
+			stop();
+		}
+
+		// Stop the timer (only the first call is accumulated). Returns the wall clock seconds of the stage
+		double stop(){
+			if(_elapsed < 0){
+				_elapsed = wallTime() - _wall;
+				_profiler.addStage(_stage, _elapsed, cpuTime() - _cpu);
+			}
+			return _elapsed;
+		}
+
+	private:
+		Scope(const Scope&);
+		Scope& operator=(const Scope&);
+
+		StageProfiler&	_profiler;
+		string			_stage;
+		double			_wall, _cpu, _elapsed;
+	};
+
+	StageProfiler() : _wall(wallTime()), _cpu(cpuTime()){}
+
+	// Monotonic wall clock time, in seconds
+	static double wallTime(){
+		timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return ts.tv_sec + ts.tv_nsec * 1e-9;
+	}
+
+	// CPU time of the process (user + system, all threads), in seconds
+	static double cpuTime(){
+		rusage usage;
+		getrusage(RUSAGE_SELF, &usage);
+		return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e-6;
+	}
+
+	// Peak resident set size of the process, in KB
+	static long peakRSS(){
+		rusage usage;
+		getrusage(RUSAGE_SELF, &usage);
+		return usage.ru_maxrss;
+	}
+
+	void addStage(const string& stage, double wall, double cpu){
+		Stage& s = find(_stages, stage, Stage());
+		s.wall += wall;
+		s.cpu += cpu;
+		++s.calls;
+		s.peakRSS = peakRSS();
+	}
+
+	void setCounter(const string& name, uint64_t value){
+		find(_counters, name, static_cast<uint64_t>(0)) = value;
+	}
+
+	void addCounter(const string& name, uint64_t value){
+		find(_counters, name, static_cast<uint64_t>(0)) += value;
+	}
+
+	uint64_t getCounter(const string& name) const {
+		for(size_t i = 0; i < _counters.size(); ++i){
+			if(_counters[i].first == name) return _counters[i].second;
+		}
+		return 0;
+	}
+
+	void setInfo(const string& name, const string& value){
+		find(_info, name, string()) = value;
+	}
+
+	// Write the JSON report of the run (up to now)
+	void writeReport(ostream& os) const {
+		os << setprecision(9);
+		os << "{\n  \"info\": {";
+		for(size_t i = 0; i < _info.size(); ++i){
+			os << (i ? ",\n" : "\n") << "    \"" << escape(_info[i].first) << "\": \"" << escape(_info[i].second) << "\"";
+		}
+		os << "\n  },\n";
+		os << "  \"wall_seconds\": " << wallTime() - _wall << ",\n";
+		os << "  \"cpu_seconds\": " << cpuTime() - _cpu << ",\n";
+		os << "  \"peak_rss_kb\": " << peakRSS() << ",\n";
+		os << "  \"final_rss_kb\": " << MemoryUsage::currentRSS() << ",\n";
+		os << "  \"stages\": [";
+		for(size_t i = 0; i < _stages.size(); ++i){
+			const Stage& s = _stages[i].second;
+			os << (i ? ",\n" : "\n") << "    {\"name\": \"" << escape(_stages[i].first) << "\", \"calls\": " << s.calls
+					<< ", \"wall_seconds\": " << s.wall << ", \"cpu_seconds\": " << s.cpu << ", \"peak_rss_kb\": " << s.peakRSS << "}";
+		}
+		os << "\n  ],\n  \"counters\": {";
+		for(size_t i = 0; i < _counters.size(); ++i){
+			os << (i ? ",\n" : "\n") << "    \"" << escape(_counters[i].first) << "\": " << _counters[i].second;
+		}
+		os << "\n  }\n}\n";
+	}
+
+	// Write the JSON report into the given file. Returns false on failure
+	bool writeReport(const string& file) const {
+		ofstream os(file.c_str(), ios::out | ios::trunc);
+		if(!os.good()) return false;
+		writeReport(os);
+		return os.good();
+	}
+
+	// Size of the given file, in bytes (0 if it does not exist)
+	static uint64_t fileBytes(const string& file){
+		struct stat fstat_;
+		return stat(file.c_str(), &fstat_) == 0 ? fstat_.st_size : 0;
+	}
+
+	// Size of the regular files of the given directory (not recursive), in bytes
+	static uint64_t directoryBytes(const string& dir){
+		uint64_t bytes = 0;
+		DIR* d = opendir(dir.c_str());
+		if(d == NULL) return 0;
+		for(dirent* e = readdir(d); e != NULL; e = readdir(d)){
+			struct stat fstat_;
+			const string file = dir + "/" + e->d_name;
+			if(stat(file.c_str(), &fstat_) == 0 && S_ISREG(fstat_.st_mode)) bytes += fstat_.st_size;
+		}
+		closedir(d);
+		return bytes;
+	}
+
+private:
+	struct Stage
+	{
+		Stage() : wall(0), cpu(0), calls(0), peakRSS(0){}
+		double		wall, cpu;
+		size_t		calls;
+		long		peakRSS;
+	};
+
+	// Value of the given name, added (with the default value) if not found (insertion order is kept)
+	template<typename T>
+	static T& find(vector<pair<string, T> >& values, const string& name, const T& def){
+		for(size_t i = 0; i < values.size(); ++i){
+			if(values[i].first == name) return values[i].second;
+		}
+		values.push_back(make_pair(name, def));
+		return values.back().second;
+	}
+
+	// JSON string escaping of quotes, backslashes and control characters
+	static string escape(const string& text){
+		string escaped;
+		escaped.reserve(text.size());
+		for(size_t i = 0; i < text.size(); ++i){
+			const unsigned char c = static_cast<unsigned char>(text[i]);
+			if(c == '"' || c == '\\'){
+				escaped += '\\';
+				escaped += static_cast<char>(c);
+			}else if(c < 0x20){
+				static const char hex[] = "0123456789abcdef";
+				escaped += "\\u00";
+				escaped += hex[c >> 4];
+				escaped += hex[c & 0xf];
+			}else{
+				escaped += static_cast<char>(c);
+			}
+		}
+		return escaped;
+	}
+
+	double							_wall, _cpu;
+	vector<pair<string, Stage> >	_stages;
+	vector<pair<string, uint64_t> >	_counters;
+	vector<pair<string, string> >	_info;
+};
+
+}
+
+#endif /* STAGEPROFILER_HPP_ */
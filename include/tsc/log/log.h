@@ -18,5 +18,6 @@
 #include "Logger.hpp"
 #include "ProgressDisplay.hpp"
 #include "Timer.hpp"
+#include "StageProfiler.hpp"
 
 #endif /* LOG_H_ */
@@ -0,0 +1,120 @@
+/*
+ * FileSink.hpp
+ *
+ * Copyright (c) 2015 Alberto Alonso Gonzalez
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ *  Created on: 19/10/2026
+ *      Author: Alberto Alonso-Gonzalez
+ */
+
+#ifndef FILESINK_HPP_
+#define FILESINK_HPP_
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <stdexcept>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <tsc/bpt/BPTDataSource.hpp>
+#include <tsc/io/BPTTreeFileWriter.hpp>
+#include <tsc/io/PolSARProFormatVectorMatrixWriter.hpp>
+#include <tsc/util/ToString.hpp>
+#include "Pipeline.hpp"
+
+namespace tscbpt
+{
+
+namespace pipeline
+{
+
+/**
+ * Sink writing the results of a pipeline into the given output path, with
+ * the same files as TEBPT: BPT.tree (optional), RegId_NRegs_k.bin and k.bin,
+ * and for each prune, within Prune_<factor>/<folder> (e.g. C3), the sequence
+ * data of the region models (optional), RegId.bin, TStability_GEIGs_full.bin,
+ * TStability_DGs_full.bin and DP_GEIG_i_j.bin.
+ *
+ * The label maps and rasters are written directly from the result.
+ */
+template<class Config>
+class FileSink : public Sink<Config>
+{
+public:
+	typedef Sink<Config>								base_type;
+	typedef typename base_type::result_type				result_type;
+	typedef typename base_type::prune_type				prune_type;
+	typedef typename result_type::BPT					BPT;
+	typedef typename result_type::NodePointer			NodePointer;
+
+	FileSink(const string& outPath = ".", bool writeSequence = true, bool saveTree = false) :
+		_outPath(outPath), _writeSequence(writeSequence), _saveTree(saveTree){}
+
+	void tree(const result_type& result){
+		makeDir(_outPath);
+		if(_saveTree){
+			BPTTreeFileWriter<typename BPT::CheckingPol>		treeWriter(result.getRows(), result.getCols(), Config::subMatrix_size, Config::outputPrefix());
+			treeWriter.writeToFile(_outPath + "/BPT.tree", result.getRoot());
+		}
+		for(size_t k = 0; k < result.getNRegs().size(); ++k){
+			writeRaster(_outPath + "/RegId_NRegs_" + to_string(result.getNRegs()[k]) + ".bin", result.getNRegsLabels(k));
+		}
+		if(!result.getBilateralK().empty()) writeRaster(_outPath + "/k.bin", result.getBilateralK());
+	}
+
+	void prune(const result_type& result, const prune_type& prune){
+		string dir = _outPath + "/Prune_" + to_string(prune.factor);
+		makeDir(dir);
+		dir += to_string("/") + Config::outputFolder();
+		makeDir(dir);
+
+		if(_writeSequence){
+			BPTDataSource<NodePointer, 2>		source(prune.regions, result.getLeafOrder());
+			PolSARProFormatVectorMatrixWriter<Config::subMatrix_size, typename BPT::CheckingPol> writer;
+			writer.writeDataToDir(dir, source.begin(), source.end(), Config::outputPrefix());
+			writer.writeConfigFile(dir, result.getRows(), result.getCols());
+			writeRaster(dir + "/RegId.bin", prune.labels);
+		}
+		if(!prune.geig.empty()){
+			writeRaster(dir + "/TStability_GEIGs_full.bin", prune.geig);
+			writeRaster(dir + "/TStability_DGs_full.bin", prune.dg);
+		}
+		if(!prune.pairs.empty()){
+			const size_t covariances = result.getRoot()->getModel().getNumCovariances();
+			for(size_t i = 0, k = 0; i < covariances; ++i){
+				for(size_t j = i+1; j < covariances; ++j, ++k){
+					writeRaster(dir + "/DP_GEIG_" + to_string(i) + "_" + to_string(j) + ".bin", prune.pairs[k]);
+				}
+			}
+		}
+	}
+
+private:
+	template<typename T>
+	static void writeRaster(const string& file, const vector<T>& values){
+		ofstream stream(file.c_str(), ios::binary);
+		if(stream.fail()) __throw_ios_failure(__N("ERROR: FileSink cannot open an output file"));
+		if(!values.empty()) stream.write(reinterpret_cast<const char*>(&(values[0])), values.size() * sizeof(T));
+	}
+
+	static void makeDir(const string& dir){
+		struct stat fstat;
+		if(stat(dir.c_str(), &fstat) != 0 && mkdir(dir.c_str(), S_IRWXU) != 0){
+			__throw_runtime_error(__N("ERROR: FileSink cannot create an output directory"));
+		}
+	}
+
+	string			_outPath;
+	bool			_writeSequence, _saveTree;
+};
+
+} // namespace pipeline
+
+} // namespace tscbpt
+
+#endif /* FILESINK_HPP_ */
@@ -0,0 +1,392 @@
+/*
+ * Pipeline.hpp
+ *
+ * Copyright (c) 2015 Alberto Alonso Gonzalez
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ *  Created on: 19/10/2026
+ *      Author: Alberto Alonso-Gonzalez
+ */
+
+#ifndef PIPELINE_HPP_
+#define PIPELINE_HPP_
+
+#include <cstddef>
+#include <complex>
+#include <string>
+#include <vector>
+#include <deque>
+#include <functional>
+#include <stdexcept>
+#include <tsc/bpt/BPT.h>
+#include <tsc/bpt/NodeLeafOrder.hpp>
+#include <tsc/bpt/TemporalStabilityEngine.hpp>
+#include <tsc/io/MemoryStripReader.hpp>
+#include <tsc/image/image.h>
+#include <tsc/util/util.h>
+
+namespace tscbpt
+{
+
+/**
+ * In-memory TEBPT processing, to embed it into other applications: the
+ * input data is given as a buffer in memory and the BPT, the region id label
+ * maps and the temporal stability rasters of the prunes are returned in
+ * memory (see run()). Writing the usual TEBPT files is an optional sink
+ * (see FileSink).
+ *
+ * The processing is parameterized by a configuration like TEBPTConfig (in
+ * TEBPT_config.h), giving the BPT, the Dissimilarity, the PruneCriterion and
+ * the scattering vector operator (SOperator).
+ *
+ * Usage:
+ *
+ *   pipeline::Options options;
+ *   options.pruneFactors.push_back(-2);
+ *   pipeline::Result<ConfigC3> result;
+ *   pipeline::run(pipeline::InputSpan(data, rows, cols, 12), options, result);
+ *   const vector<uint32_t>& labels = result.getPrune(0).labels;
+ *
+ * It does not change the working directory nor use any other global state
+ * (the node IDs are allocated by each tree, see NodeIdContext), so that
+ * several pipelines may run concurrently in the threads of a process.
+ */
+namespace pipeline
+{
+
+using namespace std;
+
+/**
+ * Input data: planar complex samples of all the input channels, in the
+ * order of the TEBPT input files (e.g. HH, HV, VH, VV of each acquisition),
+ * the sample (row, col) of the channel c at data[c * planeSize + row * cols + col].
+ * The buffer is shared, not copied, and must outlive the call to run().
+ */
+struct InputSpan
+{
+	// planeSize 0 stands for contiguous planes (rows * cols)
+	InputSpan(const complex<float>* aData, size_t aRows, size_t aCols, size_t aChannels, size_t aPlaneSize = 0) :
+		data(aData), rows(aRows), cols(aCols), channels(aChannels), planeSize(aPlaneSize){}
+
+	const complex<float>*	data;
+	size_t					rows, cols, channels, planeSize;
+};
+
+// Initial speckle filter of the leaves
+enum Filter { NO_FILTER, BOXCAR_FILTER, BILATERAL_FILTER };
+
+// Options of the processing (with the same defaults as TEBPT)
+struct Options
+{
+	Options() : filter(BOXCAR_FILTER), filterRows(3), filterCols(3),
+		blf_sigma_s(2), blf_sigma_p(0.5), blf_sigma_t(-1), blf_iterations(3),
+		stability(true), pairs(false), keepPrunes(true), validate(false){}
+
+	// Prune factors of the range start:inc:end, with the same values as TEBPT
+	void setPruneRange(double start, double inc, double end){
+		pruneFactors.clear();
+		for(double pruneFactor = start; pruneFactor <= end; pruneFactor += inc){
+			pruneFactors.push_back(pruneFactor);
+		}
+	}
+
+	Filter			filter;
+	size_t			filterRows, filterCols;
+	// Bilateral filter parameters (sigma_t < 0 to compute it from the data)
+	double			blf_sigma_s, blf_sigma_p, blf_sigma_t;
+	size_t			blf_iterations;
+	// Prune factors (dB) of the prunes
+	vector<double>	pruneFactors;
+	// Number of regions of the additional NRegs label maps
+	vector<size_t>	nregs;
+	// Temporal stability rasters (GEIG, DG) and change rasters of all the acquisition pairs
+	bool			stability;
+	bool			pairs;
+	// Keep the prunes in the result (otherwise they are only given to the sink)
+	bool			keepPrunes;
+	// Validate the BPT once constructed (see BPTFrame::validate())
+	bool			validate;
+	// Directory of the merge trace of the construction, when compiled with
+	// TRACE_BPT_CONSTRUCTION (the working directory if empty)
+	string			traceDir;
+};
+
+template<class Config, class Dissimilarity> class Pipeline;
+
+/**
+ * Result of the processing: the BPT (owned by the result, freed on
+ * destruction), its node tables and the rasters of each prune, all of
+ * them of rows x cols values in row major order.
+ */
+template<class Config>
+class Result
+{
+public:
+	typedef typename Config::BPT								BPT;
+	typedef typename Config::PruneCriterion						PruneCriterion;
+	typedef typename BPT::NodePointer							NodePointer;
+	typedef typename BPT::NodeSet								NodeSet;
+	typedef typename BPT::NodeID								NodeID;
+	typedef typename PruneCriterion::HomogeneityTable			HomogeneityTable;
+	typedef TemporalStabilityEngine<NodePointer, double>		TSEngine;
+
+	struct Prune
+	{
+		Prune() : factor(0){}
+
+		double					factor;
+		// Regions of the prune
+		NodeSet					regions;
+		// Node id of the region of each pixel
+		vector<NodeID>			labels;
+		// Temporal stability of the region of each pixel (empty if not computed)
+		vector<double>			geig, dg;
+		// Change of the region of each pixel for each acquisition pair (i, j), i < j (see TemporalStabilityEngine::getPairIndex())
+		vector<vector<double> >	pairs;
+	};
+
+	Result() : _rows(0), _cols(0), _root(NULL), _ts(NULL), _pairs(false){}
+
+	~Result(){
+		release();
+	}
+
+	// Free the BPT and all the results
+	void release(){
+		delete _ts;
+		_ts = NULL;
+		_prunes.clear();
+		_nregs.clear();
+		_nregsCounts.clear();
+		if(_root){
+			BPT::Node::removeBPTNodes(_root);
+			_root = NULL;
+		}
+	}
+
+	size_t getRows() const {
+		return _rows;
+	}
+
+	size_t getCols() const {
+		return _cols;
+	}
+
+	NodePointer getRoot() const {
+		return _root;
+	}
+
+	// Homogeneity of each node (by id), as used by the prune criterion
+	const HomogeneityTable& getHomogeneity() const {
+		return _homog;
+	}
+
+	// Pixels of the leaves of each node (by id)
+	const NodeLeafOrder& getLeafOrder() const {
+		return _order;
+	}
+
+	size_t getNPrunes() const {
+		return _prunes.size();
+	}
+
+	const Prune& getPrune(size_t i) const {
+		return _prunes.at(i);
+	}
+
+	// Numbers of regions of the NRegs label maps (Options::nregs)
+	const vector<size_t>& getNRegs() const {
+		return _nregsCounts;
+	}
+
+	// Label map (node id of each pixel) of the prune into getNRegs()[i] regions
+	const vector<NodeID>& getNRegsLabels(size_t i) const {
+		return _nregs.at(i);
+	}
+
+	// k parameter of the last bilateral filter iteration (empty if not applied)
+	const vector<double>& getBilateralK() const {
+		return _k;
+	}
+
+	/**
+	 * Prune the BPT at the given factor, computing its rasters into out.
+	 * The temporal stability of the regions is cached between prunes.
+	 */
+	void prune(double factor, bool stability, Prune& out){
+		out.factor = factor;
+		out.regions.clear();
+		BPT::prune(_root, out.regions, PruneCriterion(factor, &_homog));
+
+		vector<NodePointer> regions(out.regions.begin(), out.regions.end());
+		const int n = static_cast<int>(regions.size());
+		out.labels.resize(_rows * _cols);
+		#pragma omp parallel for schedule(dynamic, 64)
+		for(int r = 0; r < n; ++r){
+			const NodeID id = static_cast<NodeID>(regions[r]->getId());
+			for(NodeLeafOrder::pixel_iterator p = _order.begin(id); p != _order.end(id); ++p) out.labels[*p] = id;
+		}
+
+		out.geig.clear();
+		out.dg.clear();
+		out.pairs.clear();
+		if(!stability || _ts == NULL) return;
+		_ts->evaluate(out.regions);
+		const size_t npairs = _pairs ? _ts->pairs().getNOutputs() : 0;
+		out.geig.resize(_rows * _cols);
+		out.dg.resize(_rows * _cols);
+		out.pairs.resize(npairs, vector<double>(_rows * _cols));
+		#pragma omp parallel for schedule(dynamic, 64)
+		for(int r = 0; r < n; ++r){
+			const typename TSEngine::Result& ts = _ts->getResult(regions[r]);
+			const NodeID id = static_cast<NodeID>(regions[r]->getId());
+			for(NodeLeafOrder::pixel_iterator p = _order.begin(id); p != _order.end(id); ++p){
+				out.geig[*p] = ts.geig;
+				out.dg[*p] = ts.dg;
+				for(size_t k = 0; k < npairs; ++k) out.pairs[k][*p] = ts.pairs[k];
+			}
+		}
+	}
+
+private:
+	// Non copyable (owns the BPT)
+	Result(const Result&);
+	Result& operator=(const Result&);
+
+	template<class, class> friend class Pipeline;
+
+	size_t					_rows, _cols;
+	NodePointer				_root;
+	HomogeneityTable		_homog;
+	NodeLeafOrder			_order;
+	TSEngine*				_ts;
+	bool					_pairs;
+	deque<Prune>			_prunes;
+	vector<size_t>			_nregsCounts;
+	vector<vector<NodeID> >	_nregs;
+	vector<double>			_k;
+};
+
+/**
+ * Receiver of the results of run(), as soon as they are computed: the BPT
+ * with its tables and NRegs label maps once constructed, and each prune.
+ */
+template<class Config>
+class Sink
+{
+public:
+	typedef Result<Config>						result_type;
+	typedef typename result_type::Prune			prune_type;
+
+	virtual ~Sink(){}
+
+	virtual void tree(const result_type&){}
+
+	virtual void prune(const result_type&, const prune_type&){}
+};
+
+/**
+ * Processing of the given configuration, with the given dissimilarity
+ * measure (by default that of the configuration)
+ */
+template<class Config, class Dissimilarity = typename Config::Dissimilarity>
+class Pipeline
+{
+public:
+	typedef typename Config::BPT								BPT;
+	typedef typename Config::SOperator							SOperator;
+	typedef Result<Config>										result_type;
+	typedef Sink<Config>										sink_type;
+	typedef typename BPT::Node									Node;
+	typedef typename BPT::NodePointer							NodePointer;
+	typedef typename Node::RegionModel::covariance_type			covariance_type;
+
+	/**
+	 * Construct the BPT of the input, with the given options, and prune it
+	 * into result (releasing its previous contents). The results are also
+	 * given to the sink, if any.
+	 */
+	static void run(const InputSpan& input, const Options& opt, result_type& result, sink_type* sink = NULL,
+			Dissimilarity diss = Dissimilarity()){
+		if(Config::num_covariances > 0 && input.channels != Config::num_covariances * Config::files_per_acquisition){
+			__throw_invalid_argument(__N("ERROR: The number of input channels does not correspond to the configuration"));
+		}
+		result.release();
+		const size_t rows = input.rows, cols = input.cols;
+		MemoryStripReader<complex<float> > reader(input.data, rows, cols, input.channels, input.planeSize);
+		result._rows = rows;
+		result._cols = cols;
+		result._k.clear();
+
+		{	// Leaves and BPT construction (the WRAG is freed once the tree is built)
+			DenseWRAGGenerator<Node> wrag(reader, SOperator());
+
+			if(opt.filter == BOXCAR_FILTER){
+				boxCarFilter2DFullInterp(wrag.getData().begin(), rows, cols, opt.filterRows, opt.filterCols);
+			}else if(opt.filter == BILATERAL_FILTER){
+				ImageData<double> 	k_img(rows, cols);
+				double sigma_t = opt.blf_sigma_t;
+				if(sigma_t < 0) sigma_t = compute_sigma_t(make_LinearAccessor(wrag.getData(), cols), rows, cols, CovarianceAccessor(), 10);
+				BLFDiagonalWishartDiss<covariance_type> 	bfdiss(sigma_t);
+				iterativeCrossBilateralDBF2Filter(
+						make_LinearAccessor(wrag.getData(), cols),	// in
+						make_LinearAccessor(wrag.getData(), cols),	// ref
+						make_LinearAccessor(wrag.getData(), cols),	// out
+						k_img,
+						bfdiss, rows, cols, opt.filterRows, opt.filterCols, opt.blf_sigma_s, opt.blf_sigma_p, opt.blf_iterations, CovarianceAccessor());
+				result._k.reserve(rows * cols);
+				for(ImageData<double>::iterator it = k_img.begin(); it != k_img.end(); ++it) result._k.push_back(*it);
+			}
+
+			wrag.template generateWRAG_2D_Connectivity8<Dissimilarity, typename BPT::Dissimilarity> (diss);
+			typename BPT::InMemoryConstructor constructor(wrag.begin(), wrag.end(), wrag.getIdContext());
+			if(!opt.traceDir.empty()) constructor.setOutputDir(opt.traceDir);
+			typename BPT::NodeSet consSet = constructor.template getBinaryPartitionForest<Dissimilarity, ModelMerge > (1, diss);
+			result._root = *(consSet.begin());
+		}
+
+		if(opt.validate && BPT::validate(result._root, rows * cols) > 0){
+			__throw_runtime_error(__N("ERROR: The BPT validation failed"));
+		}
+
+		// Node tables, computed once for all the prunes
+		result._homog.build(result._root);
+		result._order.build(result._root, rows, cols);
+		result._nregsCounts = opt.nregs;
+		if(!opt.nregs.empty()) BPT::NRegs_labels(result._root, opt.nregs, rows, cols, result._nregs);
+		result._pairs = opt.pairs;
+		const size_t covariances = result._root->getModel().getNumCovariances();
+		if(opt.stability && covariances > 1) result._ts = new typename result_type::TSEngine(covariances, opt.pairs);
+		if(sink) sink->tree(result);
+
+		for(size_t i = 0; i < opt.pruneFactors.size(); ++i){
+			result._prunes.push_back(typename result_type::Prune());
+			result.prune(opt.pruneFactors[i], opt.stability, result._prunes.back());
+			if(sink) sink->prune(result, result._prunes.back());
+			if(!opt.keepPrunes) result._prunes.pop_back();
+		}
+	}
+
+private:
+	struct CovarianceAccessor : public unary_function<NodePointer, covariance_type> {
+		covariance_type& operator()(NodePointer a) const {
+			return (a->getModel().getFullCovariance());
+		}
+	};
+};
+
+// Processing with the configuration of the result
+template<class Config>
+void run(const InputSpan& input, const Options& opt, Result<Config>& result, Sink<Config>* sink = NULL){
+	Pipeline<Config>::run(input, opt, result, sink);
+}
+
+} // namespace pipeline
+
+} // namespace tscbpt
+
+#endif /* PIPELINE_HPP_ */
@@ -0,0 +1,21 @@
+/*
+ * pipeline.h
+ *
+ * Copyright (c) 2015 Alberto Alonso Gonzalez
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ *  Created on: 19/10/2026
+ *      Author: Alberto Alonso-Gonzalez
+ */
+
+#ifndef PIPELINE_H_
+#define PIPELINE_H_
+
+#include "Pipeline.hpp"
+#include "FileSink.hpp"
+
+#endif /* PIPELINE_H_ */
@@ -50,6 +50,15 @@ public:
 	template <typename T>
 	inline bool fatalCheck(T ) const { return false; }
 
+	/**
+	 * Expensive tests (e.g. set lookups) must also be guarded by validating(),
+	 * so that their arguments are not even evaluated when it is false. E.g.:
+	 * if(CheckingPolicy.validating() && CheckingPolicy.errorCheck(set.find(x) != set.end())) { //Code... }
+	 * The complete validation is then left to a debug validation pass run on
+	 * demand (e.g. BPTFrame::validate()).
+	 */
+	inline bool validating() const { return false; }
+
 	//=================================== ASSERT ====================================
 	template <typename T> inline void infoAssert(T) const {}
 	template <typename T> inline void warnAssert(T) const {}
@@ -106,6 +115,8 @@ public:
 		return arg;
 	}
 
+	inline bool validating() const { return true; }
+
 	//=================================== ASSERT ====================================
 	template <typename T> inline void infoAssert(T arg) const {
 		assert(arg);
@@ -174,7 +185,30 @@ public:
 	}
 };
 
+/**
+ * Checking policy for production builds: only the O(1) checks are kept,
+ * i.e. the error and fatal tests and asserts, the size, pointer and IO state
+ * checks. The info and warning tests and the expensive (validating()) tests
+ * are removed.
+ */
+class ReleaseCheckingPolicy : public FullCheckingPolicy
+{
+public:
+	ReleaseCheckingPolicy(){}
 
+	//================================== TESTS ======================================
+	template <typename T>
+	inline bool infoCheck(T ) const { return false; }
+
+	template <typename T>
+	inline bool warnCheck(T ) const { return false; }
+
+	inline bool validating() const { return false; }
+
+	//=================================== ASSERT ====================================
+	template <typename T> inline void infoAssert(T) const {}
+	template <typename T> inline void warnAssert(T) const {}
+};
 
 }
 
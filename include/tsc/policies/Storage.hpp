@@ -64,67 +64,74 @@ struct NativeStorage: public PtrStoragePolicy<T>
 		}
 	};
 
-	static long balance;
+	static long balance;		// Number of existing objects
+	static long created;		// Number of objects created (total)
 
 	static StrongPointerType create() {
-		balance++;
+		countCreation();
 		return StrongPointerType(new T);
 	}
 
 	template <typename T1>
 	static StrongPointerType create(T1 t1) {
-		balance++;
+		countCreation();
 		return StrongPointerType(new T(t1));
 	}
 
 	template <typename T1, typename T2>
 	static StrongPointerType create(T1 t1, T2 t2) {
-		balance++;
+		countCreation();
 		return StrongPointerType(new T(t1, t2));
 	}
 
 	template <typename T1, typename T2, typename T3>
 	static StrongPointerType create(T1 t1, T2 t2, T3 t3) {
-		balance++;
+		countCreation();
 		return StrongPointerType(new T(t1, t2, t3));
 	}
 
 	template <typename T1, typename T2, typename T3, typename T4>
 	static StrongPointerType create(T1 t1, T2 t2, T3 t3, T4 t4) {
-		balance++;
+		countCreation();
 		return StrongPointerType(new T(t1, t2, t3, t4));
 	}
 
 	template <typename T1, typename T2, typename T3, typename T4, typename T5>
 	static StrongPointerType create(T1 t1, T2 t2, T3 t3, T4 t4, T5 t5) {
-		balance++;
+		countCreation();
 		return StrongPointerType(new T(t1, t2, t3, t4, t5));
 	}
 
 	template <typename T1, typename T2, typename T3, typename T4, typename T5, typename T6>
 	static StrongPointerType create(T1 t1, T2 t2, T3 t3, T4 t4, T5 t5, T6 t6) {
-		balance++;
+		countCreation();
 		return StrongPointerType(new T(t1, t2, t3, t4, t5, t6));
 	}
 
 	template <typename T1, typename T2, typename T3, typename T4, typename T5, typename T6, typename T7>
 	static StrongPointerType create(T1 t1, T2 t2, T3 t3, T4 t4, T5 t5, T6 t6, T7 t7) {
-		balance++;
+		countCreation();
 		return StrongPointerType(new T(t1, t2, t3, t4, t5, t6, t7));
 	}
 
 	template <typename T1, typename T2, typename T3, typename T4, typename T5, typename T6, typename T7, typename T8>
 	static StrongPointerType create(T1 t1, T2 t2, T3 t3, T4 t4, T5 t5, T6 t6, T7 t7, T8 t8) {
-		balance++;
+		countCreation();
 		return StrongPointerType(new T(t1, t2, t3, t4, t5, t6, t7, t8));
 	}
 
 	inline static void remove(StrongPointerType& p) {
-		balance--;
+		__sync_sub_and_fetch(&balance, 1);
 		RemovalPolicy::remove(p);
 	}
 
 protected:
+	// The counters are atomic, objects may be created by concurrent BPT constructions
+	inline static void countCreation() {
+		__sync_add_and_fetch(&balance, 1);
+		__sync_add_and_fetch(&created, 1);
+	}
+
 	~NativeStorage() {
 	}
 };
@@ -134,6 +141,12 @@ template <
 	class RemovalPolicy
 	>
 long NativeStorage<T, PtrStoragePolicy, RemovalPolicy>::balance = 0;
+template <
+	typename T,
+	template <class > class PtrStoragePolicy,
+	class RemovalPolicy
+	>
+long NativeStorage<T, PtrStoragePolicy, RemovalPolicy>::created = 0;
 
 
 template <typename T>
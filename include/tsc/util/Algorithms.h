@@ -17,6 +17,7 @@
 
 #include <cstddef>
 #include <complex>
+#include <algorithm>
 #include <functional>
 #include <vector>
 
@@ -163,6 +164,18 @@ struct NoOpScatteringVector{
 		T tmp = value;
 		return tmp;
 	}
+
+	static size_t outputChannels(size_t channels){
+		return channels;
+	}
+
+	// Planar version (see MonostaticScatteringVector::planar())
+	template<typename T>
+	static void planar(const T* in, size_t inPlaneSize, T* out, size_t outPlaneSize, size_t channels, size_t n){
+		for(size_t c = 0; c < channels; ++c){
+			std::copy(in + c * inPlaneSize, in + c * inPlaneSize + n, out + c * outPlaneSize);
+		}
+	}
 };
 
 // Assumes that input scattering vector is (HH, HV, VH, VV) (Alphabetically sorted)
@@ -184,6 +197,35 @@ struct MonostaticScatteringVector{
 		}
 		return tmp;
 	}
+
+	static size_t outputChannels(size_t channels){
+		return channels - channels / Channels;
+	}
+
+	/**
+	 * Planar version for bulk conversions, vectorizable along the pixels:
+	 * the channel c of the pixel p is at in[c * inPlaneSize + p] (p < n),
+	 * and the same for the outputChannels(channels) channels of out
+	 * (with outPlaneSize).
+	 */
+	template<typename T>
+	static void planar(const T* in, size_t inPlaneSize, T* out, size_t outPlaneSize, size_t channels, size_t n){
+		const typename T::value_type factor = sqrt(2) / 2;
+		for(size_t a = 0; a < channels / Channels; ++a){
+			const T* hh = in + a * Channels * inPlaneSize;
+			const T* hv = hh + inPlaneSize;
+			const T* vh = hv + inPlaneSize;
+			const T* vv = vh + inPlaneSize;
+			T* o0 = out + a * (Channels - 1) * outPlaneSize;
+			T* o1 = o0 + outPlaneSize;
+			T* o2 = o1 + outPlaneSize;
+			for(size_t p = 0; p < n; ++p){
+				o0[p] = hh[p];
+				o1[p] = (hv[p] + vh[p]) * factor;
+				o2[p] = vv[p];
+			}
+		}
+	}
 };
 
 // Assumes that input scattering vector is (HH, HV, VH, VV) (Alphabetically sorted)
@@ -204,6 +246,30 @@ struct MonostaticPauliScatteringVector{
 		}
 		return tmp;
 	}
+
+	static size_t outputChannels(size_t channels){
+		return channels - channels / Channels;
+	}
+
+	// Planar version (see MonostaticScatteringVector::planar())
+	template<typename T>
+	static void planar(const T* in, size_t inPlaneSize, T* out, size_t outPlaneSize, size_t channels, size_t n){
+		const typename T::value_type factor = (1.0 /sqrt(2.0));
+		for(size_t a = 0; a < channels / Channels; ++a){
+			const T* hh = in + a * Channels * inPlaneSize;
+			const T* hv = hh + inPlaneSize;
+			const T* vh = hv + inPlaneSize;
+			const T* vv = vh + inPlaneSize;
+			T* o0 = out + a * (Channels - 1) * outPlaneSize;
+			T* o1 = o0 + outPlaneSize;
+			T* o2 = o1 + outPlaneSize;
+			for(size_t p = 0; p < n; ++p){
+				o0[p] = (hh[p] + vv[p]) * factor;
+				o1[p] = (hh[p] - vv[p]) * factor;
+				o2[p] = (hv[p] + vh[p]) * factor;
+			}
+		}
+	}
 };
 
 
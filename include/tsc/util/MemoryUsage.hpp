@@ -0,0 +1,94 @@
+/*
+ * MemoryUsage.hpp
+ *
+ * Copyright (c) 2015 Alberto Alonso Gonzalez
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ *  Created on: 19/10/2026
+ *      Author: Alberto Alonso-Gonzalez
+ */
+
+#ifndef MEMORYUSAGE_HPP_
+#define MEMORYUSAGE_HPP_
+
+#include <cstddef>
+#include <cstdio>
+#include <unistd.h>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+namespace tscbpt
+{
+
+/**
+ * Memory usage of the process and of the heap allocator.
+ *
+ * Memory freed with delete/free is kept by the allocator for later
+ * allocations (e.g. the dissimilarities removed during the BPT
+ * construction), so that the resident set size never decreases. With glibc,
+ * trim() returns the free pages of the heap to the operating system. The
+ * heap statistics and trim() are not available (zero / no-op) with other
+ * C libraries.
+ */
+struct MemoryUsage
+{
+	// Current resident set size of the process, in KB (0 if unknown)
+	static long currentRSS(){
+		long pages = 0, resident = 0;
+		FILE* f = fopen("/proc/self/statm", "r");
+		if(f == NULL) return 0;
+		if(fscanf(f, "%ld %ld", &pages, &resident) != 2) resident = 0;
+		fclose(f);
+		return resident * (sysconf(_SC_PAGESIZE) / 1024);
+	}
+
+	// Bytes obtained by the heap allocator from the operating system
+	static size_t heapBytes(){
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+		const struct mallinfo2 info = mallinfo2();
+		return info.arena + info.hblkhd;
+#elif defined(__GLIBC__)
+		const struct mallinfo info = mallinfo();
+		return static_cast<unsigned int>(info.arena) + static_cast<unsigned int>(info.hblkhd);
+#else
+		return 0;
+#endif
+	}
+
+	// Bytes of the heap which are free (kept by the allocator for reuse)
+	static size_t heapFreeBytes(){
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+		const struct mallinfo2 info = mallinfo2();
+		return info.fordblks;
+#elif defined(__GLIBC__)
+		const struct mallinfo info = mallinfo();
+		return static_cast<unsigned int>(info.fordblks);
+#else
+		return 0;
+#endif
+	}
+
+	// Fraction of the heap which is free (fragmentation), in [0, 1]
+	static double heapFragmentation(){
+		const size_t total = heapBytes();
+		return (total > 0) ? static_cast<double>(heapFreeBytes()) / total : 0;
+	}
+
+	// Return the free memory of the heap to the operating system. Returns true if some memory was released
+	static bool trim(){
+#if defined(__GLIBC__)
+		return malloc_trim(0) != 0;
+#else
+		return false;
+#endif
+	}
+};
+
+}
+
+#endif /* MEMORYUSAGE_HPP_ */
@@ -0,0 +1,102 @@
+/*
+ * SPSCRingBuffer.hpp
+ *
+ * Copyright (c) 2015 Alberto Alonso Gonzalez
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ *  Created on: 19/10/2026
+ *      Author: Alberto Alonso-Gonzalez
+ */
+
+#ifndef SPSCRINGBUFFER_HPP_
+#define SPSCRINGBUFFER_HPP_
+
+#include <cstddef>
+#include <vector>
+
+namespace tscbpt
+{
+
+/**
+ * Lock-free single producer / single consumer ring buffer of fixed size
+ * records (recordSize values of type T each).
+ *
+ * The producer obtains a free record with reserve() (NULL if the buffer is
+ * full), fills it and publishes it with commit(). The consumer obtains the
+ * oldest published record with front() (NULL if the buffer is empty) and
+ * releases it with pop(). The capacity is rounded up to a power of two.
+ * Synchronization relies on the GCC __atomic builtins.
+ */
+template<typename T>
+class SPSCRingBuffer
+{
+public:
+	typedef T		value_type;
+
+	SPSCRingBuffer(size_t capacity, size_t recordSize) : _recordSize(recordSize), _head(0), _tail(0) {
+		_capacity = roundCapacity(capacity);
+		_mask = _capacity - 1;
+		_data.resize(_capacity * _recordSize);
+	}
+
+	// Producer side
+	T* reserve() {
+		const size_t head = __atomic_load_n(&_head, __ATOMIC_RELAXED);
+		if(head - __atomic_load_n(&_tail, __ATOMIC_ACQUIRE) == _capacity) return NULL;
+		return &(_data[(head & _mask) * _recordSize]);
+	}
+
+	void commit() {
+		__atomic_store_n(&_head, _head + 1, __ATOMIC_RELEASE);
+	}
+
+	// Consumer side
+	const T* front() const {
+		const size_t tail = __atomic_load_n(&_tail, __ATOMIC_RELAXED);
+		if(__atomic_load_n(&_head, __ATOMIC_ACQUIRE) == tail) return NULL;
+		return &(_data[(tail & _mask) * _recordSize]);
+	}
+
+	void pop() {
+		__atomic_store_n(&_tail, _tail + 1, __ATOMIC_RELEASE);
+	}
+
+	bool empty() const {
+		return __atomic_load_n(&_head, __ATOMIC_ACQUIRE) == __atomic_load_n(&_tail, __ATOMIC_ACQUIRE);
+	}
+
+	size_t capacity() const {
+		return _capacity;
+	}
+
+	size_t getRecordSize() const {
+		return _recordSize;
+	}
+
+	// Capacity (records) of a ring buffer constructed with the given one
+	static size_t roundCapacity(size_t capacity) {
+		size_t rounded = 1;
+		while(rounded < capacity) rounded <<= 1;
+		return rounded;
+	}
+
+private:
+	// Non copyable
+	SPSCRingBuffer(const SPSCRingBuffer&);
+	SPSCRingBuffer& operator=(const SPSCRingBuffer&);
+
+	std::vector<T>		_data;
+	size_t				_capacity, _mask, _recordSize;
+	// Written by the producer (_head) and the consumer (_tail) only
+	size_t				_head;
+	char				_padding[64];
+	size_t				_tail;
+};
+
+}
+
+#endif /* SPSCRINGBUFFER_HPP_ */
@@ -0,0 +1,106 @@
+/*
+ * FixedVector.hpp
+ *
+ * Copyright (c) 2015 Alberto Alonso Gonzalez
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ *  Created on: 19/10/2026
+ *      Author: Alberto Alonso-Gonzalez
+ */
+
+#ifndef FIXEDVECTOR_HPP_
+#define FIXEDVECTOR_HPP_
+
+#include <cstddef>
+#include <cassert>
+#include <stdexcept>
+
+namespace tscbpt
+{
+
+/**
+ * Vector of up to Capacity elements stored inline (no heap allocation),
+ * with the subset of the std::vector interface employed by the region
+ * models. For trivially copyable elements it is also trivially copyable,
+ * so that it may be copied with memcpy() or mapped from a file.
+ */
+template<typename T, size_t Capacity>
+class FixedVector
+{
+public:
+	typedef T				value_type;
+	typedef T*				iterator;
+	typedef const T*		const_iterator;
+	typedef T&				reference;
+	typedef const T&		const_reference;
+
+	static const size_t capacity = Capacity;
+
+	FixedVector() : _size(0) {}
+
+	size_t size() const {
+		return _size;
+	}
+
+	bool empty() const {
+		return _size == 0;
+	}
+
+	void clear() {
+		_size = 0;
+	}
+
+	void push_back(const T& value) {
+		assert(_size < Capacity);
+		_data[_size++] = value;
+	}
+
+	reference operator[](size_t n) {
+		return _data[n];
+	}
+
+	const_reference operator[](size_t n) const {
+		return _data[n];
+	}
+
+	reference at(size_t n) {
+		if(n >= _size) std::__throw_out_of_range(__N("FixedVector::at"));
+		return _data[n];
+	}
+
+	const_reference at(size_t n) const {
+		if(n >= _size) std::__throw_out_of_range(__N("FixedVector::at"));
+		return _data[n];
+	}
+
+	iterator begin() {
+		return _data;
+	}
+
+	const_iterator begin() const {
+		return _data;
+	}
+
+	iterator end() {
+		return _data + _size;
+	}
+
+	const_iterator end() const {
+		return _data + _size;
+	}
+
+private:
+	size_t		_size;
+	T			_data[Capacity];
+};
+
+template<typename T, size_t Capacity>
+const size_t FixedVector<T, Capacity>::capacity;
+
+}
+
+#endif /* FIXEDVECTOR_HPP_ */
@@ -0,0 +1,59 @@
+/*
+ * StridedArrayRef.hpp
+ *
+ * Copyright (c) 2015 Alberto Alonso Gonzalez
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ *  Created on: 19/10/2026
+ *      Author: Alberto Alonso-Gonzalez
+ */
+
+#ifndef STRIDEDARRAYREF_HPP_
+#define STRIDEDARRAYREF_HPP_
+
+#include <cstddef>
+
+namespace tscbpt
+{
+
+/**
+ * Read only, non owning reference to size elements separated by stride
+ * elements in memory (e.g. the channels of a pixel within planar data),
+ * with the subset of the std::vector interface needed to read them. It is
+ * cheap to copy, so it may be employed as the value of a Pixel.
+ */
+template<typename T>
+class StridedArrayRef
+{
+public:
+	typedef T				value_type;
+	typedef const T&		const_reference;
+
+	StridedArrayRef(const T* data, size_t size, size_t stride) :
+		_data(data), _size(size), _stride(stride) {}
+
+	size_t size() const {
+		return _size;
+	}
+
+	bool empty() const {
+		return _size == 0;
+	}
+
+	const_reference operator[](size_t n) const {
+		return _data[n * _stride];
+	}
+
+private:
+	const T*	_data;
+	size_t		_size;
+	size_t		_stride;
+};
+
+}
+
+#endif /* STRIDEDARRAYREF_HPP_ */
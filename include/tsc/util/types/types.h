@@ -18,5 +18,7 @@
 #include "NoOpConverter.hpp"
 #include "ContainerValueType.hpp"
 #include "TypeTraits.hpp"
+#include "FixedVector.hpp"
+#include "StridedArrayRef.hpp"
 
 #endif /* TYPES_H_ */
@@ -24,5 +24,7 @@
 #include "Algorithms.h"
 #include "ArmadilloWrapper.hpp"
 #include "ArrayAccessor.hpp"
+#include "SPSCRingBuffer.hpp"
+#include "MemoryUsage.hpp"
 
 #endif /* UTIL_H_ */
@@ -22,6 +22,7 @@
 #include "tsc/data/data.h"
 #include "tsc/policies/policies.h"
 #include "tsc/log/log.h"
+#include "tsc/pipeline/pipeline.h"
 
 
 #endif	/* _TSCBPT_H */
@@ -0,0 +1,308 @@
+/*
+ * TEBPT-batch.cpp
+ *
+ * Copyright (c) 2015 Alberto Alonso Gonzalez
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ *  Created on: 19/10/2026
+ *      Author: Alberto Alonso-Gonzalez
+ */
+
+// Processes a batch of scenes (one TEBPT command line per scene, given in a
+// manifest file) in a single process, overlapping the stages of consecutive
+// scenes: while the BPT of a scene is constructed, the next scene is read and
+// the previous one is pruned and written.
+
+// Include config.h first, for configuration of included files
+#include "TEBPT_config.h"
+// Processing stages of a scene
+#include "TEBPT_stages.h"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <set>
+#include <algorithm>
+#include <exception>
+#include <cstdlib>
+#include <cstring>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace std;
+using namespace tscbpt;
+
+void printUsage(){
+	cerr << "Usage:\n    TEBPT-batch [batch options] manifest" << endl;
+	cerr << "\nThe manifest gives a scene per line, with the TEBPT arguments of the scene:" << endl;
+	cerr << "    [options] pruning_factor(s) rows cols file1 [file2 ... fileN]" << endl;
+	cerr << "Empty lines and lines starting with '#' are ignored. The input files and the" << endl;
+	cerr << "output path (--out, created if needed) are relative to the working directory," << endl;
+	cerr << "and each scene must have its own output path." << endl;
+	cerr << "\nBatch options include:" << endl;
+	cerr << "  --memory-budget MB  Do not start reading a scene while the estimated memory of the scenes in flight would exceed MB megabytes (default: no limit)" << endl;
+	cerr << "  --threads n      Threads shared by the construction and writing stages (default: OpenMP maximum)" << endl;
+	cerr << "  --report file    Write the JSON report of the batch into file (default: TEBPT-batch_report.json)" << endl;
+	cerr << "\nTEBPT options include:" << endl;
+	printTEBPTOptions();
+}
+
+// A scene of the batch, processed by the stages of TEBPTSceneBase
+struct BatchScene
+{
+	// Pipeline states, in order
+	enum State { PENDING, READ, CONSTRUCTED, DONE };
+
+	BatchScene(size_t aLine, const TEBPTOptions& options) :
+		line(aLine), opt(options), scene(NULL), state(PENDING), failed(false), estimate(0){}
+
+	~BatchScene(){
+		delete scene;
+	}
+
+	size_t				line;
+	TEBPTOptions		opt;
+	StageProfiler		profiler;
+	TEBPTSceneBase*		scene;
+	State				state;
+	bool				failed;
+	string				error;
+	size_t				estimate;
+};
+
+// Read the scenes of the manifest. Returns false if the manifest cannot be read or understood
+bool readManifest(const string& file, vector<BatchScene*>& scenes){
+	ifstream manifest(file.c_str());
+	if(manifest.fail()){
+		cerr << "ERROR: the manifest file '" << file << "' cannot be opened!" << endl;
+		return false;
+	}
+	set<string> outPaths;
+	string text;
+	for(size_t line = 1; getline(manifest, text); ++line){
+		istringstream words(text);
+		vector<string> args;
+		for(string word; words >> word; ) args.push_back(word);
+		if(args.empty() || args[0][0] == '#') continue;
+
+		TEBPTOptions opt;
+		if(!parseTEBPTArguments(args, opt)){
+			cerr << "ERROR: cannot understand the scene at line " << line << " of the manifest" << endl;
+			return false;
+		}
+		if(!outPaths.insert(opt.outPath).second){
+			cerr << "ERROR: the scene at line " << line << " writes into the output path '" << opt.outPath << "' of a previous scene" << endl;
+			return false;
+		}
+		scenes.push_back(new BatchScene(line, opt));
+	}
+	return true;
+}
+
+// Create the output path and the processing of the scene, with its memory estimate
+void openScene(BatchScene& s){
+	struct stat fstat;
+	if (stat(s.opt.outPath.c_str(), &fstat) != 0 && mkdir(s.opt.outPath.c_str(), S_IRWXU) != 0){
+		__throw_runtime_error(__N("ERROR: The output path of the scene cannot be created"));
+	}
+	// Read all the input data in the read stage, overlapped with the previous scenes
+	s.opt.preload = true;
+	s.profiler.setInfo("program", "TEBPT-batch");
+	s.profiler.setInfo("matrix", s.opt.matrix);
+	s.profiler.setInfo("manifest_line", to_string(s.line));
+	// The times and memory of the stages come from getrusage() of the whole process
+	s.profiler.setInfo("resource_usage", "process: cpu_seconds and peak_rss_kb include the concurrent stages of other scenes");
+	s.scene = newTEBPTScene(s.opt, s.profiler);
+	if(s.scene == NULL) __throw_invalid_argument(__N("ERROR: Unknown matrix type"));
+	s.estimate = s.scene->estimatedMemory();
+}
+
+// Run the given stage of the scene (if any), catching its errors
+void runStage(BatchScene* s, BatchScene::State stage, int threads){
+	if(s == NULL) return;
+	#ifdef _OPENMP
+	omp_set_num_threads(threads);
+	#endif
+	try{
+		switch(stage){
+		case BatchScene::READ:			s->scene->read(); break;
+		case BatchScene::CONSTRUCTED:	s->scene->construct(); break;
+		case BatchScene::DONE:			s->scene->write(); break;
+		default: break;
+		}
+	}catch(std::exception& e){
+		s->failed = true;
+		s->error = e.what();
+	}catch(...){
+		s->failed = true;
+		s->error = "unknown error";
+	}
+}
+
+// Release the scene and write its report (into its output path, unless absolute)
+void finishScene(BatchScene& s){
+	if(s.scene){
+		s.scene->release();
+		delete s.scene;
+		s.scene = NULL;
+		// Return the memory of the BPT to the system, for the next scenes
+		MemoryUsage::trim();
+	}
+	s.state = BatchScene::DONE;
+	if(s.failed){
+		cerr << "ERROR: the scene at line " << s.line << " of the manifest failed: " << s.error << endl;
+		s.profiler.setInfo("error", s.error);
+	}
+	const string report = (!s.opt.report.empty() && s.opt.report[0] == '/') ? s.opt.report : s.opt.outputFile(s.opt.report);
+	if(!s.profiler.writeReport(report)) cerr << "ERROR: the report file '" << report << "' cannot be written!" << endl;
+	else cout << "\nScene at line " << s.line << " finished, report written into " << report << endl;
+}
+
+int main(int argc, char** argv) {
+	size_t budgetMB = 0;
+	int threads = 1;
+	#ifdef _OPENMP
+	threads = omp_get_max_threads();
+	#endif
+	string report = "TEBPT-batch_report.json";
+
+	int argi;
+	for(argi = 1; argi < argc && strncmp(argv[argi],"--",2) == 0; argi++){
+		if (strcmp(argv[argi], "--memory-budget") == 0 && argi+1 < argc) {
+			budgetMB = atol(argv[++argi]);
+		} else if (strcmp(argv[argi], "--threads") == 0 && argi+1 < argc) {
+			threads = max(1, atoi(argv[++argi]));
+		} else if (strcmp(argv[argi], "--report") == 0 && argi+1 < argc) {
+			report = argv[++argi];
+		} else {
+			cerr << "ERROR: Unknown parameter '" << argv[argi] << "'" << endl;
+			printUsage();
+			return EXIT_FAILURE;
+		}
+	}
+	if(argi + 1 != argc){
+		printUsage();
+		return EXIT_FAILURE;
+	}
+
+	vector<BatchScene*> scenes;
+	if(!readManifest(argv[argi], scenes)){
+		for(size_t i = 0; i < scenes.size(); ++i) delete scenes[i];
+		return EXIT_FAILURE;
+	}
+	cout << "Processing " << scenes.size() << " scenes with " << threads << " threads";
+	if(budgetMB > 0) cout << " and a memory budget of " << budgetMB << " MB";
+	cout << endl;
+
+	#ifdef _OPENMP
+	// The stages run in parallel sections, each one with its own team
+	omp_set_max_active_levels(2);
+	#endif
+
+	StageProfiler profiler;
+	profiler.setInfo("program", "TEBPT-batch");
+	profiler.setInfo("manifest", argv[argi]);
+	profiler.setInfo("threads", to_string(threads));
+	profiler.setCounter("scenes", scenes.size());
+	profiler.setCounter("memory_budget_mb", budgetMB);
+
+	// Pipeline: in each tick the next scene is read, the read one is
+	// constructed and the constructed one is written, concurrently
+	// NOTE: A single scene is constructed at a time, so that the node
+	// counters of its report (see TEBPTScene) are its own
+	size_t next = 0, finished = 0;
+	StageProfiler::Scope batchStage(profiler, "batch");
+	while(finished < scenes.size()){
+		BatchScene *reading = NULL, *constructing = NULL, *writing = NULL;
+		size_t inFlight = 0;
+		for(size_t i = 0; i < next; ++i){
+			BatchScene* s = scenes[i];
+			if(s->state == BatchScene::READ) constructing = s;
+			else if(s->state == BatchScene::CONSTRUCTED) writing = s;
+			if(s->state == BatchScene::READ || s->state == BatchScene::CONSTRUCTED) inFlight += s->estimate;
+		}
+
+		// Admit the next scene if it fits into the budget (always when nothing else is in flight)
+		while(reading == NULL && next < scenes.size()){
+			BatchScene* s = scenes[next];
+			try{
+				if(s->scene == NULL) openScene(*s);
+			}catch(std::exception& e){
+				s->failed = true;
+				s->error = e.what();
+				++next;
+				finishScene(*s);
+				++finished;
+				continue;
+			}
+			if(inFlight > 0 && budgetMB > 0 && inFlight + s->estimate > (budgetMB << 20)){
+				// Wait for the scenes in flight (no data is read until admitted)
+				profiler.addCounter("budget_waits", 1);
+				break;
+			}
+			cout << "\nReading the scene at line " << s->line << " (estimated memory " << (s->estimate >> 20) << " MB)" << endl;
+			reading = s;
+			++next;
+		}
+		if(reading == NULL && constructing == NULL && writing == NULL) continue;
+
+		// Split the threads between the CPU stages (reading only needs its prefetching thread)
+		const int cpuStages = (constructing ? 1 : 0) + (writing ? 1 : 0);
+		const int stageThreads = max(1, threads / max(1, cpuStages));
+		StageProfiler::Scope tickStage(profiler, "tick");
+		#pragma omp parallel sections num_threads(3)
+		{
+			#pragma omp section
+			runStage(reading, BatchScene::READ, 1);
+			#pragma omp section
+			runStage(constructing, BatchScene::CONSTRUCTED, stageThreads);
+			#pragma omp section
+			runStage(writing, BatchScene::DONE, stageThreads);
+		}
+		tickStage.stop();
+
+		// Advance the scenes, releasing the written (or failed) ones
+		if(writing){
+			finishScene(*writing);
+			++finished;
+		}
+		if(constructing){
+			constructing->state = BatchScene::CONSTRUCTED;
+			if(constructing->failed){
+				finishScene(*constructing);
+				++finished;
+			}
+		}
+		if(reading){
+			reading->state = BatchScene::READ;
+			if(reading->failed){
+				finishScene(*reading);
+				++finished;
+			}
+		}
+	}
+	batchStage.stop();
+
+	size_t failed = 0;
+	for(size_t i = 0; i < scenes.size(); ++i){
+		if(scenes[i]->failed) ++failed;
+		delete scenes[i];
+	}
+	profiler.setCounter("failed_scenes", failed);
+
+	cout << "\n" << scenes.size() - failed << " of " << scenes.size() << " scenes processed. Peak memory: "
+			<< StageProfiler::peakRSS() / 1024.0 << " MB, final memory: " << MemoryUsage::currentRSS() / 1024.0 << " MB" << endl;
+	if(!profiler.writeReport(report)) cerr << "ERROR: the report file '" << report << "' cannot be written!" << endl;
+	else cout << "\nBatch report written into " << report << endl;
+	return (failed > 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,87 @@
+/*
+ * TEBPT-expand.cpp
+ *
+ * Copyright (c) 2015 Alberto Alonso Gonzalez
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ *  Created on: 19/10/2026
+ *      Author: Alberto Alonso-Gonzalez
+ */
+
+// Expands a compact region label map (Regions.lbl, written by TEBPT --compact)
+// into the raw per pixel files written by TEBPT: RegId.bin (32 bit region id)
+// and one <column>.bin (double) for each per region column.
+
+#include <cstdlib>
+#include <cstring>
+#include <stdint.h>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <tsc/io/RegionLabelMapReader.hpp>
+
+using namespace std;
+using namespace tscbpt;
+
+void printUsage(){
+	cerr << "Usage:\n    TEBPT-expand [--list] file.lbl [outpath]" << endl;
+	cerr << "\nWrites RegId.bin and a <column>.bin file for each column into outpath (default: '.')" << endl;
+	cerr << "\nOptions include:" << endl;
+	cerr << "  --list           Only list the contents of the file" << endl;
+	cerr << endl;
+}
+
+template<typename T>
+bool writeExpanded(const string& file, const vector<uint32_t>& labels, const vector<T>& regionValues){
+	vector<T> data(labels.size());
+	for(size_t i = 0; i < labels.size(); ++i) data[i] = regionValues[labels[i]];
+	ofstream out(file.c_str(), ios::out | ios::trunc | ios::binary);
+	if(!data.empty()) out.write(reinterpret_cast<const char*>(&(data[0])), data.size() * sizeof(T));
+	out.close();
+	if(out.fail()){
+		cerr << "ERROR: the '" << file << "' file cannot be written!" << endl;
+		return false;
+	}
+	cout << "  " << file << endl;
+	return true;
+}
+
+int main(int argc, char** argv) {
+	int argi = 1;
+	bool list = false;
+	if(argi < argc && strcmp(argv[argi], "--list") == 0){
+		list = true;
+		++argi;
+	}
+	if(argi >= argc || argc - argi > 2){
+		printUsage();
+		return EXIT_FAILURE;
+	}
+	const string file = argv[argi++];
+	const string outPath = (argi < argc) ? argv[argi] : ".";
+
+	try{
+		RegionLabelMapReader labelMap(file);
+		cout << file << ": " << labelMap.getRows() << " x " << labelMap.getCols() << " pixels, "
+				<< labelMap.getNRegions() << " regions" << endl;
+		for(size_t c = 0; c < labelMap.getNColumns(); ++c){
+			cout << "  column " << labelMap.getColumnName(c) << endl;
+		}
+		if(list) return EXIT_SUCCESS;
+
+		cout << "Writing:" << endl;
+		bool ok = writeExpanded(outPath + "/RegId.bin", labelMap.getLabels(), labelMap.getIds());
+		for(size_t c = 0; c < labelMap.getNColumns(); ++c){
+			ok = writeExpanded(outPath + "/" + labelMap.getColumnName(c) + ".bin", labelMap.getLabels(), labelMap.getColumn(c)) && ok;
+		}
+		return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+	}catch(std::exception& e){
+		cerr << e.what() << endl;
+		return EXIT_FAILURE;
+	}
+}
@@ -0,0 +1,197 @@
+/*
+ * TEBPT-prune.cpp
+ *
+ * Copyright (c) 2015 Alberto Alonso Gonzalez
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ *  Created on: 19/10/2026
+ *      Author: Alberto Alonso-Gonzalez
+ */
+
+// Prunes a persisted BPT (BPT.tree, written by TEBPT --save-tree) at the given
+// pruning factors, without reading the input data or reconstructing the tree.
+// It writes the same region id and sequence data as TEBPT for each prune.
+
+#include <cstdlib>
+#include <cstring>
+#include <cassert>
+#include <ctime>
+#include <stdint.h>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <set>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <boost/algorithm/string.hpp>
+#include <tsc/io/MappedBPTTree.hpp>
+#include <tsc/io/PolSARProPlaneBuffer.hpp>
+#include <tsc/io/PolSARProFormatVectorMatrixWriter.hpp>
+#include <tsc/io/RegionLabelMapWriter.hpp>
+#include <tsc/bpt/PruneCriteria.h>
+#include <tsc/util/ToString.hpp>
+
+using namespace std;
+using namespace tscbpt;
+
+// NOTE: Must be the same prune criterion as in TEBPT_config.h (only the
+// homogeneity based criteria are supported by the persisted tree)
+typedef RelErrorHomogeneityPruneCriterion<> 	PruneCriterion;
+
+typedef MappedBPTTree::NodePointer				NodePointer;
+typedef set<NodePointer>						NodeSet;
+
+void printUsage(){
+	cerr << "Usage:\n    TEBPT-prune [options] pruning_factor(s) file.tree" << endl;
+	cerr << "\nOptions include:" << endl;
+	cerr << "  --out outpath    Change the output path to outpath (default: '.')" << endl;
+	cerr << "  --no-write       Do not write pruned images data (nor the compact Regions.lbl)" << endl;
+	cerr << "  --compact        Write region ids into a compact Regions.lbl file" << endl;
+	cerr << endl;
+}
+
+double diffclock(clock_t clock1, clock_t clock2) {
+	double diffticks = clock1 - clock2;
+	double diffms = (diffticks * 1000) / CLOCKS_PER_SEC;
+	return diffms;
+}
+
+int main(int argc, char** argv) {
+	// Maximum number of allowed prunes per execution
+	static const size_t MAX_PRUNES		= 100;
+
+	double startPF=0, endPF=0, incPF = 1;
+	clock_t start;
+	string outPath = ".";
+	bool write_prune = true;
+	bool compact_out = false;
+
+	int argi;
+	for(argi = 1; argi < argc && strncmp(argv[argi],"--",2) == 0; argi++){
+		if (strcmp(argv[argi], "--out") == 0 && argi+1 < argc) {
+			outPath = (argv[++argi]);
+		} else if (strcmp(argv[argi], "--no-write") == 0) {
+			write_prune = false;
+		} else if (strcmp(argv[argi], "--compact") == 0) {
+			compact_out = true;
+		}else{
+			cerr << "ERROR: Unknown parameter '" << argv[argi] << "'" << endl;
+			printUsage();
+			return EXIT_FAILURE;
+		}
+	}
+	if(argc - argi != 2){
+		printUsage();
+		return EXIT_FAILURE;
+	}
+
+	// Process the pruning factors interval
+	std::vector<std::string> strs;
+	boost::split(strs, argv[argi++], boost::is_any_of(":"));
+	if(strs.size()==1)
+		startPF = endPF = atof(strs.front().c_str());
+	else if(strs.size()==3){
+		startPF = atof(strs[0].c_str());
+		incPF = atof(strs[1].c_str());
+		endPF = atof(strs[2].c_str());
+		assert(startPF <= endPF);
+		assert(incPF > 0.0);
+		assert((endPF-startPF)/incPF < MAX_PRUNES);
+	}else{
+		cerr << "Unable to understand prune factor value or range." << endl;
+		cerr << "Use a fixed value ('-1.5') or a range ('-5:1:0')" << endl;
+		return EXIT_FAILURE;
+	}
+	const string treeFile = argv[argi];
+
+	try{
+		start = clock();
+		MappedBPTTree tree(treeFile);
+		const size_t rows = tree.getRows(), cols = tree.getCols();
+		cout << "Mapped BPT " << treeFile << ": " << rows << " x " << cols << " pixels, " << tree.getNNodes() << " nodes"
+				<< (tree.hasModels() ? ", with models" : "") << " (Elapsed " << diffclock(clock(), start) << " milliseconds)" << endl;
+		if(write_prune && !tree.hasModels()){
+			cerr << "WARNING: The tree file has no models, only the region ids will be written" << endl;
+		}
+
+		// Change working directory
+		if(chdir(outPath.c_str())) cerr << "ERROR: Cannot change current working directory to " << outPath << endl;
+		else cout << "Changed output directory to '" << outPath << "'" << endl;
+
+		NodeSet prunedSet;
+		for(double pruneFactor = startPF; pruneFactor <= endPF; pruneFactor += incPF){
+			cout << "\nPruning BPT at " << pruneFactor << " dB ... " << flush;
+			start = clock();
+			tree.prune(prunedSet, PruneCriterion(pruneFactor));
+			cout << "Done. (Elapsed " << diffclock(clock(), start) << " milliseconds)" << endl;
+			cout << "  Number of pruned regions: " << prunedSet.size() << endl;
+			cout << "  Average region size: " << static_cast<double>(rows) * cols / prunedSet.size() << endl;
+
+			const vector<NodePointer> regions = tree.getRegionImage(prunedSet);
+
+			string dir = string("./Prune_") + to_string(pruneFactor);
+			{	// Creating the directory path dir
+				struct stat fstat;
+				if (stat(dir.c_str(), &fstat) != 0){
+					cout << "\n  Creating dir " << dir.c_str() << endl;
+					assert(mkdir(dir.c_str(), S_IRWXU)==0);
+				}
+			}
+			dir += string("/") + tree.getPrefix() + to_string(tree.getSubMatrixSize());
+			{ // Creating the directory path dir
+				struct stat fstat;
+				if (stat(dir.c_str(), &fstat) != 0){
+					cout << "  Creating dir " << dir.c_str() << endl;
+					assert(mkdir(dir.c_str(), S_IRWXU)==0);
+				}
+			}
+
+			if(write_prune && tree.hasModels()){
+				cout << "Writing sequence data... " << flush;
+				start = clock();
+				PolSARProPlaneBuffer<> planes(tree.getMatrixSize(), tree.getSubMatrixSize(), dir, tree.getPrefix());
+				for(size_t p = 0; p < regions.size(); ++p){
+					planes.push_values(regions[p].getPlanes());
+				}
+				planes.close();
+				PolSARProFormatVectorMatrixWriter<> writer;
+				writer.writeConfigFile(dir, rows, cols);
+				cout << "Done. (Elapsed " << diffclock(clock(), start) << " milliseconds)" << endl;
+			}
+
+			if(write_prune && !compact_out){
+				cout << "Generating region ID data... " << flush;
+				start = clock();
+				vector<uint32_t> ids(regions.size());
+				for(size_t p = 0; p < regions.size(); ++p) ids[p] = regions[p].getId();
+				ofstream RIDFile ((dir + "/RegId.bin").c_str());
+				if(RIDFile.fail()) cerr<<"ERROR: region ID file cannot be opened!"<<endl;
+				if(!ids.empty()) RIDFile.write(reinterpret_cast<const char*>(&(ids[0])), ids.size() * sizeof(uint32_t));
+				RIDFile.close();
+				cout << "Done. (Elapsed " << diffclock(clock(), start) << " milliseconds)" << endl;
+			}
+
+			if(write_prune && compact_out){
+				cout << "Writing compact region data... " << flush;
+				start = clock();
+				RegionLabelMapWriter<NodePointer>	labelMap(rows, cols, true);
+				labelMap.setRegions(prunedSet);
+				labelMap.writeToFile(dir + "/Regions.lbl", regions.begin(), regions.end());
+				cout << "Done. (Elapsed " << diffclock(clock(), start) << " milliseconds)" << endl;
+			}
+
+			// Clear the pruned set
+			prunedSet.clear();
+		}
+	}catch(std::exception& e){
+		cerr << e.what() << endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,366 @@
+/*
+ * TEBPT-synth.cpp
+ *
+ * Copyright (c) 2015 Alberto Alonso Gonzalez
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ *  Created on: 19/10/2026
+ *      Author: Alberto Alonso-Gonzalez
+ */
+
+// Generates a synthetic PolSAR time series, to be processed by TEBPT: one
+// complex float file per acquisition and channel (with the rows and cols
+// header read by FileWithSizeReader) of piecewise constant regions, whose
+// pixels are complex Gaussian scattering vectors (Wishart distributed
+// covariance matrices) of the covariance matrix of the region at each date.
+// The data is fully determined by the seed and generated by row strips, so
+// that scenes of any size may be reproduced with constant memory.
+
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <stdint.h>
+#include <complex>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <sstream>
+
+using namespace std;
+
+void printUsage(){
+	cerr << "Usage:\n    TEBPT-synth [options] rows cols outpath" << endl;
+	cerr << "\nWrites the files d<date>_<channel>.bin into outpath, in the order expected by TEBPT" << endl;
+	cerr << "\nOptions include:" << endl;
+	cerr << "  --dates n        Number of acquisitions (default: 3)" << endl;
+	cerr << "  --channels n     Polarimetric channels: 4 (HH, HV, VH, VV), 2 (HH, HV) or 1 (HH) (default: 4)" << endl;
+	cerr << "  --region size    Mean side of the regions, in pixels (default: 32)" << endl;
+	cerr << "  --classes n      Number of different covariance matrices (default: 16)" << endl;
+	cerr << "  --looks L        Speckle looks of the pixels span (default: 1, single look complex)" << endl;
+	cerr << "  --change type    Temporal change of the regions: none, step, periodic or trend (default: step)" << endl;
+	cerr << "  --change-fraction p   Fraction of the regions changing (default: 0.1)" << endl;
+	cerr << "  --seed s         Seed of the random generator (default: 1)" << endl;
+	cerr << "  --no-header      Do not write the rows and cols header (then give rows and cols to TEBPT)" << endl;
+	cerr << "  --strip MB       Size of the row strips generated in memory (default: 64)" << endl;
+	cerr << endl;
+}
+
+// Temporal change patterns of the regions
+enum ChangePattern { NoChange, StepChange, PeriodicChange, TrendChange };
+
+struct SynthOptions{
+	SynthOptions(): rows(0), cols(0), dates(3), channels(4), regionSize(32), classes(16), looks(1),
+			change(StepChange), changeFraction(0.1), seed(1), header(true), stripMB(64){}
+	size_t			rows, cols, dates, channels, regionSize, classes, looks;
+	ChangePattern	change;
+	double			changeFraction;
+	uint64_t		seed;
+	bool			header;
+	size_t			stripMB;
+	string			outPath;
+};
+
+// Stateless hash (splitmix64 finalizer), for reproducible values of any region or pixel
+inline uint64_t mix(uint64_t x){
+	x += 0x9E3779B97F4A7C15ull;
+	x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+	x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+	return x ^ (x >> 31);
+}
+
+inline uint64_t mix(uint64_t a, uint64_t b, uint64_t c = 0){
+	return mix(mix(mix(a) ^ b) ^ c);
+}
+
+// Uniform value in [0, 1) from a hash
+inline double uniform(uint64_t h){
+	return (h >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Small random generator of the pixel values (xorshift64*), with Box-Muller normal values
+class PixelGenerator{
+public:
+	PixelGenerator(uint64_t seed): _state(seed | 1), _cached(false), _next(0){}
+
+	double uniformOpen(){
+		_state ^= _state >> 12;
+		_state ^= _state << 25;
+		_state ^= _state >> 27;
+		return ((_state * 0x2545F4914F6CDD1Dull) >> 11) * (1.0 / 9007199254740992.0) + (0.5 / 9007199254740992.0);
+	}
+
+	double normal(){
+		if(_cached){
+			_cached = false;
+			return _next;
+		}
+		const double r = sqrt(-2.0 * log(uniformOpen())), theta = 2.0 * M_PI * uniformOpen();
+		_next = r * sin(theta);
+		_cached = true;
+		return r * cos(theta);
+	}
+
+	// Circular complex Gaussian value of unit power
+	complex<double> complexNormal(){
+		const double re = normal();
+		return complex<double>(re, normal()) * M_SQRT1_2;
+	}
+
+private:
+	uint64_t	_state;
+	bool		_cached;
+	double		_next;
+};
+
+/**
+ * Piecewise constant scene: Voronoi regions of a jittered grid of seeds
+ * (one per cell of regionSize x regionSize pixels), each of them with a
+ * covariance class per date according to the change pattern.
+ */
+class SyntheticScene{
+public:
+	SyntheticScene(const SynthOptions& opt): _opt(opt), _dim(opt.channels == 4 ? 3 : opt.channels),
+			_cellRows((opt.rows + opt.regionSize - 1) / opt.regionSize), _cellCols((opt.cols + opt.regionSize - 1) / opt.regionSize){
+		// Cholesky factor (lower, row major) of the covariance matrix of each class
+		_chol.resize(opt.classes * _dim * _dim);
+		for(size_t c = 0; c < opt.classes; ++c){
+			PixelGenerator gen(mix(opt.seed, 0xC1A55ull, c));
+			const double power = pow(10.0, -2.0 + 3.0 * gen.uniformOpen());
+			vector<complex<double> > a(_dim * _dim), cov(_dim * _dim);
+			for(size_t i = 0; i < a.size(); ++i) a[i] = gen.complexNormal();
+			for(size_t i = 0; i < _dim; ++i){
+				for(size_t j = 0; j < _dim; ++j){
+					complex<double> v = (i == j) ? 0.1 : 0.0;
+					for(size_t k = 0; k < _dim; ++k) v += a[i * _dim + k] * conj(a[j * _dim + k]) / static_cast<double>(_dim);
+					cov[i * _dim + j] = power * v;
+				}
+			}
+			cholesky(cov, &(_chol[c * _dim * _dim]));
+		}
+	}
+
+	size_t getDim() const {
+		return _dim;
+	}
+
+	// Region of the given pixel (nearest seed of the neighboring cells)
+	uint64_t region(size_t row, size_t col) const {
+		const long cr = row / _opt.regionSize, cc = col / _opt.regionSize;
+		uint64_t best = 0;
+		double bestDist = -1;
+		for(long i = max(cr - 1, 0L); i <= min(cr + 1, static_cast<long>(_cellRows) - 1); ++i){
+			for(long j = max(cc - 1, 0L); j <= min(cc + 1, static_cast<long>(_cellCols) - 1); ++j){
+				const uint64_t id = i * _cellCols + j;
+				const uint64_t h = mix(_opt.seed, 0x5EEDull, id);
+				const double sr = (i + uniform(h)) * _opt.regionSize, sc = (j + uniform(mix(h))) * _opt.regionSize;
+				const double dist = (sr - row) * (sr - row) + (sc - col) * (sc - col);
+				if(bestDist < 0 || dist < bestDist){
+					bestDist = dist;
+					best = id;
+				}
+			}
+		}
+		return best;
+	}
+
+	// Class and power factor of the region at the given date
+	size_t regionClass(uint64_t region, size_t date, double& scale) const {
+		const size_t base = mix(_opt.seed, 0xBA5Eull, region) % _opt.classes;
+		const uint64_t h = mix(_opt.seed, 0xC4A6Eull, region);
+		scale = 1.0;
+		if(_opt.change == NoChange || uniform(h) >= _opt.changeFraction || _opt.dates < 2) return base;
+		const uint64_t h2 = mix(h);
+		const size_t other = (_opt.classes > 1) ? (base + 1 + h2 % (_opt.classes - 1)) % _opt.classes : base;
+		if(_opt.change == StepChange){
+			// Change into another class from a random date on
+			return (date >= 1 + mix(h2) % (_opt.dates - 1)) ? other : base;
+		}else if(_opt.change == PeriodicChange){
+			return (date % 2) ? other : base;
+		}
+		// Trend: +-6 dB linear power change along the series
+		const double gainDb = (h2 & 1) ? 6.0 : -6.0;
+		scale = pow(10.0, gainDb * date / (_opt.dates - 1) / 10.0);
+		return base;
+	}
+
+	// Scattering vector of a pixel of the given class: chol(C) * g, with the span of g following the speckle looks
+	void pixel(size_t cls, double scale, PixelGenerator& gen, complex<double>* k) const {
+		complex<double> g[3];
+		double norm = 0;
+		for(size_t i = 0; i < _dim; ++i){
+			g[i] = gen.complexNormal();
+			norm += norm_sq(g[i]);
+		}
+		if(_opt.looks > 1){
+			double span = norm;
+			for(size_t l = 1; l < _opt.looks; ++l){
+				for(size_t i = 0; i < _dim; ++i) span += norm_sq(gen.complexNormal());
+			}
+			scale *= span / _opt.looks / norm;
+		}
+		const complex<double>* L = &(_chol[cls * _dim * _dim]);
+		const double s = sqrt(scale);
+		for(size_t i = 0; i < _dim; ++i){
+			complex<double> v = 0;
+			for(size_t j = 0; j <= i; ++j) v += L[i * _dim + j] * g[j];
+			k[i] = s * v;
+		}
+	}
+
+private:
+	static double norm_sq(const complex<double>& v){
+		return v.real() * v.real() + v.imag() * v.imag();
+	}
+
+	void cholesky(const vector<complex<double> >& a, complex<double>* L) const {
+		for(size_t i = 0; i < _dim * _dim; ++i) L[i] = 0;
+		for(size_t j = 0; j < _dim; ++j){
+			double d = a[j * _dim + j].real();
+			for(size_t k = 0; k < j; ++k) d -= norm_sq(L[j * _dim + k]);
+			L[j * _dim + j] = sqrt(d);
+			for(size_t i = j + 1; i < _dim; ++i){
+				complex<double> v = a[i * _dim + j];
+				for(size_t k = 0; k < j; ++k) v -= L[i * _dim + k] * conj(L[j * _dim + k]);
+				L[i * _dim + j] = v / L[j * _dim + j].real();
+			}
+		}
+	}
+
+	const SynthOptions&			_opt;
+	const size_t				_dim, _cellRows, _cellCols;
+	vector<complex<double> >	_chol;
+};
+
+int main(int argc, char** argv) {
+	SynthOptions opt;
+	int argi;
+	for(argi = 1; argi < argc && strncmp(argv[argi],"--",2) == 0; argi++){
+		if(strcmp(argv[argi],"--dates")==0 && argi+1 < argc){
+			opt.dates = atol(argv[++argi]);
+		}else if(strcmp(argv[argi],"--channels")==0 && argi+1 < argc){
+			opt.channels = atol(argv[++argi]);
+		}else if(strcmp(argv[argi],"--region")==0 && argi+1 < argc){
+			opt.regionSize = atol(argv[++argi]);
+		}else if(strcmp(argv[argi],"--classes")==0 && argi+1 < argc){
+			opt.classes = atol(argv[++argi]);
+		}else if(strcmp(argv[argi],"--looks")==0 && argi+1 < argc){
+			opt.looks = atol(argv[++argi]);
+		}else if(strcmp(argv[argi],"--change")==0 && argi+1 < argc){
+			const string change = argv[++argi];
+			if(change == "none") opt.change = NoChange;
+			else if(change == "step") opt.change = StepChange;
+			else if(change == "periodic") opt.change = PeriodicChange;
+			else if(change == "trend") opt.change = TrendChange;
+			else{
+				cerr << "ERROR: Unknown change pattern '" << change << "'" << endl;
+				return EXIT_FAILURE;
+			}
+		}else if(strcmp(argv[argi],"--change-fraction")==0 && argi+1 < argc){
+			opt.changeFraction = atof(argv[++argi]);
+		}else if(strcmp(argv[argi],"--seed")==0 && argi+1 < argc){
+			opt.seed = strtoull(argv[++argi], NULL, 10);
+		}else if(strcmp(argv[argi],"--no-header")==0){
+			opt.header = false;
+		}else if(strcmp(argv[argi],"--strip")==0 && argi+1 < argc){
+			opt.stripMB = atol(argv[++argi]);
+		}else{
+			cerr << "ERROR: Unknown parameter '" << argv[argi] << "'" << endl;
+			printUsage();
+			return EXIT_FAILURE;
+		}
+	}
+	if(argc - argi != 3){
+		printUsage();
+		return EXIT_FAILURE;
+	}
+	opt.rows = atol(argv[argi++]);
+	opt.cols = atol(argv[argi++]);
+	opt.outPath = argv[argi++];
+	if(opt.rows == 0 || opt.cols == 0 || opt.dates == 0 || opt.regionSize == 0 || opt.classes == 0 || opt.looks == 0
+			|| (opt.channels != 1 && opt.channels != 2 && opt.channels != 4)){
+		cerr << "ERROR: Invalid scene parameters" << endl;
+		printUsage();
+		return EXIT_FAILURE;
+	}
+
+	const char* channelNames[] = {"HH", "HV", "VH", "VV"};
+	const size_t nfiles = opt.dates * opt.channels;
+	vector<string> fileNames;
+	vector<ofstream*> files;
+	for(size_t d = 0; d < opt.dates; ++d){
+		for(size_t ch = 0; ch < opt.channels; ++ch){
+			ostringstream name;
+			name << opt.outPath << "/d" << d << "_" << channelNames[ch] << ".bin";
+			fileNames.push_back(name.str());
+			files.push_back(new ofstream(name.str().c_str(), ios::out | ios::trunc | ios::binary));
+			if(!files.back()->good()){
+				cerr << "ERROR: Cannot create the file " << name.str() << endl;
+				return EXIT_FAILURE;
+			}
+			if(opt.header){
+				// FileWithSizeReader header: cols and rows (32 bit)
+				const int size[2] = {static_cast<int>(opt.cols), static_cast<int>(opt.rows)};
+				files.back()->write(reinterpret_cast<const char*>(size), sizeof(size));
+			}
+		}
+	}
+
+	const SyntheticScene scene(opt);
+	const size_t stripRows = max<size_t>(1, min(opt.rows, (opt.stripMB << 20) / (opt.cols * nfiles * sizeof(complex<float>))));
+	// Strips of all the files, one after the other
+	const size_t stripSize = stripRows * opt.cols;
+	vector<complex<float> > strips(nfiles * stripSize);
+	cout << "Generating " << opt.rows << "x" << opt.cols << " pixels, " << opt.dates << " dates and " << opt.channels
+			<< " channels into " << nfiles << " files (strips of " << stripRows << " rows)" << endl;
+
+	for(size_t startRow = 0; startRow < opt.rows; startRow += stripRows){
+		const int nrows = static_cast<int>(min(stripRows, opt.rows - startRow));
+		#pragma omp parallel for schedule(dynamic)
+		for(int r = 0; r < nrows; ++r){
+			const size_t row = startRow + r;
+			complex<double> k[3];
+			for(size_t col = 0; col < opt.cols; ++col){
+				const uint64_t region = scene.region(row, col);
+				const size_t offset = r * opt.cols + col;
+				for(size_t d = 0; d < opt.dates; ++d){
+					double scale;
+					const size_t cls = scene.regionClass(region, d, scale);
+					PixelGenerator gen(mix(opt.seed, d, row * opt.cols + col));
+					scene.pixel(cls, scale, gen, k);
+					complex<float>* out = &(strips[d * opt.channels * stripSize + offset]);
+					if(opt.channels == 4){
+						// Reciprocal medium: k = (HH, sqrt(2) HV, VV) and HV = VH
+						out[0] = complex<float>(k[0]);
+						out[stripSize] = out[2 * stripSize] = complex<float>(k[1] * M_SQRT1_2);
+						out[3 * stripSize] = complex<float>(k[2]);
+					}else{
+						for(size_t ch = 0; ch < opt.channels; ++ch) out[ch * stripSize] = complex<float>(k[ch]);
+					}
+				}
+			}
+		}
+		for(size_t f = 0; f < nfiles; ++f){
+			files[f]->write(reinterpret_cast<const char*>(&(strips[f * stripSize])), nrows * opt.cols * sizeof(complex<float>));
+		}
+	}
+
+	bool ok = true;
+	for(size_t f = 0; f < nfiles; ++f){
+		files[f]->close();
+		if(files[f]->fail()){
+			cerr << "ERROR: Cannot write the file " << fileNames[f] << endl;
+			ok = false;
+		}
+		delete files[f];
+	}
+	if(!ok) return EXIT_FAILURE;
+
+	// Files, in the order of the TEBPT command line
+	for(size_t f = 0; f < nfiles; ++f) cout << fileNames[f] << (f + 1 < nfiles ? " " : "\n");
+	return EXIT_SUCCESS;
+}
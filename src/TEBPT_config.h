@@ -19,69 +19,129 @@
 #include <tscbpt.h>
 
 
+using namespace tscbpt;
+
 /**
- * Default size of the submatrix size for the VectorMatrix models.
- * (may be passed as a compiler argument with -D flag)
- * For time series, the covariance matrices will be grouped into submatrices
- * of the size specified in SUBMATRIX_SIZE.
+ * Number of acquisitions of the processed time series, fixed at compile time
+ * with -DTEBPT_ACQUISITIONS=N. The region models are then fixed size objects
+ * without heap allocations (see VectorMatrixModel), and only series of N
+ * acquisitions are accepted. By default (0) it is given by the input files.
  */
-#ifndef SUBMATRIX_SIZE
-#define SUBMATRIX_SIZE 		3
+#ifndef TEBPT_ACQUISITIONS
+#define TEBPT_ACQUISITIONS		0
 #endif
 
-using namespace tscbpt;
-
 /**
- * Define the scattering vector operator (basis) and the corresponding output
- * folder.
+ * Checking policy of the processing (see CheckingPolicy.hpp). By default all
+ * the checks are performed (FullCheckingPolicy). Production builds may keep
+ * only the O(1) checks with -DTEBPT_RELEASE_CHECKS (ReleaseCheckingPolicy,
+ * the BPT may then be validated on demand with --validate) or remove all of
+ * them with -DTEBPT_NO_CHECKS (NullCheckingPolicy).
  */
-#if defined(NO_S_VECTOR_MOD)
-	typedef tscbpt::NoOpScatteringVector				SOperator;
-	#define OUTPUT_PREFIX								"C"
-#elif defined(PAULI_S_VECTOR)
-	typedef tscbpt::MonostaticPauliScatteringVector		SOperator;
-	#define	OUTPUT_PREFIX								"T"
+#if defined(TEBPT_NO_CHECKS)
+typedef NullCheckingPolicy			TEBPTCheckingPolicy;
+#elif defined(TEBPT_RELEASE_CHECKS)
+typedef ReleaseCheckingPolicy		TEBPTCheckingPolicy;
 #else
-	typedef tscbpt::MonostaticScatteringVector			SOperator;
-	#define OUTPUT_PREFIX								"C"
+typedef FullCheckingPolicy			TEBPTCheckingPolicy;
 #endif
 
-#define OUTPUT_FOLDER	(to_string(OUTPUT_PREFIX)+to_string(SUBMATRIX_SIZE))
-
 /**
- *  Define the region model employed for BPT processing
+ * Configuration of the TEBPT processing for each of the supported matrices
+ * (--matrix option): the size of the submatrices of the VectorMatrix models
+ * and the scattering vector operator (basis) with the corresponding output
+ * prefix. For time series, the covariance matrices are grouped into
+ * submatrices of size SubMatrixSize.
+ *
+ * All the configurations are instantiated into the same binary and selected
+ * at startup, each one with its own fixed size models and kernels.
  */
-// This is the main definition of the BPT Frame.
-// In general, use BPTFrame<Model>
-typedef BPTFrame<AddHomogeneity<VectorMatrixModel<complex<double>, size_t, float, SUBMATRIX_SIZE> > >		BPT;
-//  typedef BPTFrame<AddLogDetAverage<VectorMatrixModel<complex<double>, size_t, float, SUBMATRIX_SIZE> > >		BPT;
-//  typedef BPTFrame<AddHomogeneity<AddLogDetAverage<VectorMatrixModel<complex<double>, size_t, float, SUBMATRIX_SIZE> > > >		BPT;
-// Other examples:
-//typedef BPTFrame<AddHomogeneity<DynamicMatrixModel<> > >		BPT;
-//typedef BPTFrame<AddHomogeneity<VectorMatrixModel<> > >		BPT;
+template<size_t SubMatrixSize, class ScatteringVector, char Prefix>
+struct TEBPTConfig
+{
+	static const size_t		subMatrix_size	= SubMatrixSize;
+	// Input files of each acquisition: (HH, HV, VH, VV) for the 3x3 matrices
+	static const size_t		files_per_acquisition	= (SubMatrixSize == 3) ? 4 : SubMatrixSize;
+	static const size_t		num_covariances	= TEBPT_ACQUISITIONS;
 
+	// Scattering vector operator (basis)
+	typedef ScatteringVector	SOperator;
 
-/**
- *  Define the Dissimilarity measure employed for BPT construction
- */
-//typedef DiagonalRevisedWishartDissimilarityMeasure<BPT::NodePointer, BPT::DissimilarityValue> Dissimilarity;
-//typedef RevisedWishartDissimilarityMeasure<BPT::NodePointer, BPT::DissimilarityValue> Dissimilarity;
-//typedef DiagonalGeodesicDissimilarityMeasure<BPT::NodePointer, BPT::DissimilarityValue> Dissimilarity;
-//typedef GeodesicDissimilarityMeasure<BPT::NodePointer, BPT::DissimilarityValue> Dissimilarity;
-//typedef HomogDissimilarityMeasure<BPT::NodePointer, BPT::DissimilarityValue>					Dissimilarity;
-typedef GeodesicVectorMatrixDissimilarityMeasure<BPT::NodePointer, BPT::DissimilarityValue> Dissimilarity;
-//Mixed dissimilarity
-//typedef DiagonalGeodesicDissimilarityMeasure<BPT::NodePointer, BPT::DissimilarityValue> Diss1Measure;
-//typedef GeodesicVectorDissimilarityMeasure<BPT::NodePointer, BPT::DissimilarityValue> Diss2Measure;
-//typedef MixedDissimilarityMeasure<BPT::NodePointer, BPT::DissimilarityValue,Diss1Measure,Diss2Measure> Dissimilarity;
+	// Output prefix ("C", "T") and folder ("C3", "T3", ...)
+	static string outputPrefix(){
+		return string(1, Prefix);
+	}
+
+	static string outputFolder(){
+		return outputPrefix() + to_string(SubMatrixSize);
+	}
 
+	/**
+	 *  Define the region model employed for BPT processing
+	 */
+	// This is the main definition of the BPT Frame.
+	// In general, use BPTFrame<Model>
+	typedef BPTFrame<AddHomogeneity<VectorMatrixModel<complex<double>, size_t, float, SubMatrixSize, num_covariances> >,
+			double, uint32_t, DefaultNativeStoragePolicy, TEBPTCheckingPolicy>		BPT;
+	//  typedef BPTFrame<AddLogDetAverage<VectorMatrixModel<complex<double>, size_t, float, SubMatrixSize, num_covariances> > >		BPT;
+	//  typedef BPTFrame<AddHomogeneity<AddLogDetAverage<VectorMatrixModel<complex<double>, size_t, float, SubMatrixSize, num_covariances> > > >		BPT;
+	// Other examples:
+	//typedef BPTFrame<AddHomogeneity<DynamicMatrixModel<> > >		BPT;
+	//typedef BPTFrame<AddHomogeneity<VectorMatrixModel<> > >		BPT;
+
+	typedef typename BPT::NodePointer			NodePointer;
+	typedef typename BPT::DissimilarityValue	DissimilarityValue;
+
+	/**
+	 *  Define the Dissimilarity measure employed for BPT construction
+	 */
+	//typedef DiagonalRevisedWishartDissimilarityMeasure<NodePointer, DissimilarityValue> Dissimilarity;
+	//typedef RevisedWishartDissimilarityMeasure<NodePointer, DissimilarityValue> Dissimilarity;
+	//typedef DiagonalGeodesicDissimilarityMeasure<NodePointer, DissimilarityValue> Dissimilarity;
+	//typedef GeodesicDissimilarityMeasure<NodePointer, DissimilarityValue> Dissimilarity;
+	//typedef HomogDissimilarityMeasure<NodePointer, DissimilarityValue>					Dissimilarity;
+	typedef GeodesicVectorMatrixDissimilarityMeasure<NodePointer, DissimilarityValue> Dissimilarity;
+	//Mixed dissimilarity
+	//typedef DiagonalGeodesicDissimilarityMeasure<NodePointer, DissimilarityValue> Diss1Measure;
+	//typedef GeodesicVectorDissimilarityMeasure<NodePointer, DissimilarityValue> Diss2Measure;
+	//typedef MixedDissimilarityMeasure<NodePointer, DissimilarityValue,Diss1Measure,Diss2Measure> Dissimilarity;
+
+	/**
+	 * Define pruning criterion
+	 */
+	// BPT Pruning
+	typedef RelErrorHomogeneityPruneCriterion<> 	PruneCriterion;
+	//typedef LogDetPruneCriterion<> 				PruneCriterion;
+};
+
+// Fully polarimetric data, (HH, HV, VH, VV) files per acquisition
+typedef TEBPTConfig<3, MonostaticScatteringVector, 'C'>			ConfigC3;
+typedef TEBPTConfig<3, MonostaticPauliScatteringVector, 'T'>	ConfigT3;
+// Dual polarimetric data, 2 files per acquisition
+typedef TEBPTConfig<2, NoOpScatteringVector, 'C'>				ConfigC2;
+// Single polarimetric data, 1 file per acquisition
+typedef TEBPTConfig<1, NoOpScatteringVector, 'C'>				ConfigC1;
 
 /**
- * Define pruning criterion
+ * Default matrix processed when no --matrix option is given. It may be
+ * changed at compile time with the former configuration flags
+ * (-DSUBMATRIX_SIZE=N, -DNO_S_VECTOR_MOD, -DPAULI_S_VECTOR).
  */
-// BPT Pruning
-typedef RelErrorHomogeneityPruneCriterion<> 	PruneCriterion;
-//typedef LogDetPruneCriterion<> 				PruneCriterion;
+#ifndef SUBMATRIX_SIZE
+#define SUBMATRIX_SIZE 		3
+#endif
+
+#if defined(PAULI_S_VECTOR) && SUBMATRIX_SIZE == 3
+	#define DEFAULT_MATRIX		"T3"
+#elif defined(NO_S_VECTOR_MOD) && SUBMATRIX_SIZE == 2
+	#define DEFAULT_MATRIX		"C2"
+#elif defined(NO_S_VECTOR_MOD) && SUBMATRIX_SIZE == 1
+	#define DEFAULT_MATRIX		"C1"
+#elif !defined(NO_S_VECTOR_MOD) && !defined(PAULI_S_VECTOR) && SUBMATRIX_SIZE == 3
+	#define DEFAULT_MATRIX		"C3"
+#else
+	#error "Unsupported default TEBPT matrix configuration"
+#endif
 
 
 #endif /* TEBPT_CONFIG_H_ */
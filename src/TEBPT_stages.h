@@ -0,0 +1,844 @@
+/*
+ * TEBPT_stages.h
+ *
+ * Copyright (c) 2015 Alberto Alonso Gonzalez
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ *  Created on: 19/10/2026
+ *      Author: Alberto Alonso-Gonzalez
+ */
+
+#ifndef TEBPT_STAGES_H_
+#define TEBPT_STAGES_H_
+
+// Include config.h first, for configuration of included files
+#include "TEBPT_config.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <cassert>
+#include <cstdlib>
+#include <armadillo>
+#include <boost/algorithm/string.hpp>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+using namespace std;
+using namespace tscbpt;
+
+/**
+ * Processing stages of a TEBPT scene, shared by the TEBPT tool (one scene
+ * per run) and the TEBPT-batch driver (many scenes per run, pipelined).
+ *
+ * A scene is described by TEBPTOptions (as parsed from the TEBPT command
+ * line by parseTEBPTArguments()) and processed by a TEBPTScene, created
+ * with newTEBPTScene() for the configuration of its matrix, in three
+ * stages: read(), construct() and write(). All the outputs are written
+ * into TEBPTOptions::outPath, without changing the working directory.
+ */
+
+// Print the options of the TEBPT processing of a scene
+inline void printTEBPTOptions(){
+	cerr << "  --out outpath    Change the output path to outpath (default: '.')" << endl;
+	cerr << "  --matrix type    Matrix to process: C3, T3 (full pol.), C2 (dual pol.) or C1 (single pol.) (default: " << DEFAULT_MATRIX << ")" << endl;
+	cerr << "  --bpt file       Read the BPT merging sequence from the given file" << endl;
+	cerr << "  --nl rows cols   Apply an initial multilook filter of size rows x cols" << endl;
+	cerr << "  --bl rows cols   Apply an initial bilateral filter of size rows x cols" << endl;
+	cerr << "  --cut start_row start_col height width   Process only a cut of the input data" << endl;
+	cerr << "  --blf-sigma_s, --blf-sigma_p, --blf-sigma_t, --blf-iterations value" << endl;
+	cerr << "                   Change the corresponding bilateral filtering parameter" << endl;
+	cerr << "  --no-ts          Do not compute temporal stability measures" << endl;
+	cerr << "  --no-write       Do not write pruned images data (nor the compact Regions.lbl)" << endl;
+	cerr << "  --dist-all       Generate distance images between all pairs of acquisitions" << endl;
+	cerr << "  --swap-endian    Swap the endianness of the input files" << endl;
+	cerr << "  --io-strip MB    Size of the row strips prefetched from the input files (default: 64)" << endl;
+	cerr << "  --compact        Write region ids and temporal stability values into a compact Regions.lbl file" << endl;
+	cerr << "  --save-tree      Save the BPT into BPT.tree, to be pruned again with TEBPT-prune" << endl;
+	cerr << "  --nregs k1[,k2,...]  Write the region ids of the prunes into k regions (RegId_NRegs_k.bin)" << endl;
+	cerr << "  --features       Write a table of region features (Regions.features.bin and .json schema)" << endl;
+	cerr << "  --reclaim-memory MB  Return the memory freed during the BPT construction to the system when the process uses more than MB megabytes, and free the models not needed by the prunes" << endl;
+	cerr << "  --validate       Validate the constructed BPT (debug checks not performed during the construction)" << endl;
+	cerr << "  --report file    Write the JSON report of the run (stage times, peak memory, counters) into file (default: TEBPT_report.json)" << endl;
+	cerr << endl;
+}
+
+template<typename NodeID>
+struct printRegIdTo
+{
+	printRegIdTo(ofstream & astream) : stream(astream){}
+
+	template<typename T>
+	void operator()(const T np){
+		NodeID in = static_cast<int>(np->getId());
+		stream.write(reinterpret_cast<const char*> (&in), sizeof(in));
+	}
+private:
+	ofstream & stream;
+};
+
+template<class BPT>
+struct ModelAccessor : public unary_function< typename BPT::NodePointer, typename BPT::Node::RegionModel::covariance_type > {
+	typedef typename BPT::NodePointer 							NodePointer;
+	typedef typename BPT::Node::RegionModel::covariance_type		covariance_type;
+	covariance_type& operator()(NodePointer a) const {
+		return (a->getModel().getFullCovariance());
+	}
+};
+
+template<typename T>
+struct printValueTo
+{
+	printValueTo(ofstream & astream) : stream(astream){}
+
+	void operator()(const T& value) {
+		stream.write(reinterpret_cast<const char*> (&value), sizeof(T));
+	}
+private:
+	ofstream & stream;
+};
+
+
+// Command line options of the TEBPT processing
+struct TEBPTOptions
+{
+	TEBPTOptions() : matrix(DEFAULT_MATRIX), startPF(0), endPF(0), incPF(1), rows(0), cols(0), outPath("."),
+		nlr(3), nlc(3), crop_sr(1), crop_sc(1), crop_height(0), crop_with(0),
+		nl_filtering(true), bl_filtering(false), gen_dist_pairs(false), gen_ts(true), write_prune(true),
+		swap_endianness(false), io_strip_mb(MultiFileBlockReader<complex<float> >::DEFAULT_STRIP_MB),
+		compact_out(false), save_tree(false), gen_features(false), reclaim_memory(false), reclaim_mb(0), validate(false),
+		preload(false), report("TEBPT_report.json"),
+		blf_sigma_p(0.5), blf_sigma_s(2), blf_sigma_t(-1), blf_iterations(3){}
+
+	string matrix;
+	double startPF, endPF, incPF;
+	size_t rows, cols;
+	vector<string>	files;
+	string bptFile;
+	string outPath;
+	size_t nlr, nlc;
+	size_t crop_sr, crop_sc, crop_height, crop_with;
+	bool nl_filtering;
+	bool bl_filtering;
+	bool gen_dist_pairs;
+	bool gen_ts;
+	bool write_prune;
+	bool swap_endianness;
+	size_t io_strip_mb;
+	bool compact_out;
+	bool save_tree;
+	vector<size_t> nregs;
+	bool gen_features;
+	bool reclaim_memory;
+	size_t reclaim_mb;
+	bool validate;
+	bool preload;		// Read all the input data in the read() stage (instead of streaming it during construct())
+	string report;
+	double blf_sigma_p;
+	double blf_sigma_s;
+	double blf_sigma_t;
+	size_t blf_iterations;
+
+	// Path of the given output file (within outPath)
+	string outputFile(const string& name) const {
+		return outPath + "/" + name;
+	}
+};
+
+/**
+ * Parse the TEBPT arguments ([options] pruning_factor(s) rows cols file1
+ * [file2 ... fileN]) into opt. Returns false, with an error message, if
+ * they cannot be understood.
+ */
+inline bool parseTEBPTArguments(const vector<string>& args, TEBPTOptions& opt){
+	// Maximum number of allowed prunes per execution
+	static const size_t MAX_PRUNES		= 100;
+
+	size_t argi;
+	for(argi = 0; argi < args.size() && args[argi].compare(0, 2, "--") == 0; argi++){
+		const string& arg = args[argi];
+		const size_t left = args.size() - argi - 1;
+		if(arg == "--matrix" && left >= 1){
+			opt.matrix = args[++argi];
+		}else if(arg == "--bpt" && left >= 1){
+			opt.bptFile = args[++argi];
+		}else if(arg == "--nl" && left >= 2) {
+			opt.nl_filtering = true;
+			opt.bl_filtering = false;
+			opt.nlr = atol(args[++argi].c_str());
+			opt.nlc = atol(args[++argi].c_str());
+			assert(opt.nlr > 0 && opt.nlc > 0);
+		}else if(arg == "--bl" && left >= 2) {
+			opt.nl_filtering = false;
+			opt.bl_filtering = true;
+			opt.nlr = atol(args[++argi].c_str());
+			opt.nlc = atol(args[++argi].c_str());
+			assert(opt.nlr > 0 && opt.nlc > 0);
+		} else if (arg == "--cut" && left >= 4) {
+			opt.crop_sr = atol(args[++argi].c_str());
+			opt.crop_sc = atol(args[++argi].c_str());
+			opt.crop_height = atol(args[++argi].c_str());
+			opt.crop_with = atol(args[++argi].c_str());
+			assert(opt.crop_height > 0 && opt.crop_with > 0);
+		} else if(arg == "--blf-sigma_s" && left >= 1){
+			opt.blf_sigma_s = atof(args[++argi].c_str());
+		} else if(arg == "--blf-sigma_p" && left >= 1){
+			opt.blf_sigma_p = atof(args[++argi].c_str());
+		} else if(arg == "--blf-sigma_t" && left >= 1){
+			opt.blf_sigma_t = atof(args[++argi].c_str());
+		} else if(arg == "--blf-iterations" && left >= 1){
+			opt.blf_iterations = atol(args[++argi].c_str());
+		} else if (arg == "--out" && left >= 1) {
+			opt.outPath = args[++argi];
+		} else if (arg == "--dist-all") {
+			opt.gen_dist_pairs = true;
+		} else if (arg == "--no-ts") {
+			opt.gen_ts = false;
+		} else if (arg == "--no-write") {
+			opt.write_prune = false;
+		} else if (arg == "--swap-endian") {
+			opt.swap_endianness = true;
+		} else if (arg == "--io-strip" && left >= 1) {
+			opt.io_strip_mb = atol(args[++argi].c_str());
+			assert(opt.io_strip_mb > 0);
+		} else if (arg == "--compact") {
+			opt.compact_out = true;
+		} else if (arg == "--save-tree") {
+			opt.save_tree = true;
+		} else if (arg == "--nregs" && left >= 1) {
+			std::vector<std::string> ks;
+			boost::split(ks, args[++argi], boost::is_any_of(","));
+			for(size_t k = 0; k < ks.size(); ++k){
+				opt.nregs.push_back(atol(ks[k].c_str()));
+				assert(opt.nregs.back() > 0);
+			}
+		} else if (arg == "--features") {
+			opt.gen_features = true;
+		} else if (arg == "--reclaim-memory" && left >= 1) {
+			opt.reclaim_memory = true;
+			opt.reclaim_mb = atol(args[++argi].c_str());
+		} else if (arg == "--validate") {
+			opt.validate = true;
+		} else if (arg == "--report" && left >= 1) {
+			opt.report = args[++argi];
+		}else{
+			cerr << "ERROR: Unknown parameter '" << arg << "'" << endl;
+			return false;
+		}
+	}
+
+	// Pruning factor(s), rows, cols and at least one input file
+	if(args.size() < argi + 4){
+		cerr << "ERROR: Missing arguments (pruning factor(s), rows, cols and input files)" << endl;
+		return false;
+	}
+
+	// Process the pruning factors interval
+	std::vector<std::string> strs;
+	boost::split(strs, args[argi++], boost::is_any_of(":"));
+	if(strs.size()==1)
+		opt.startPF = opt.endPF = atof(strs.front().c_str());
+	else if(strs.size()==3){
+		opt.startPF = atof(strs[0].c_str());
+		opt.incPF = atof(strs[1].c_str());
+		opt.endPF = atof(strs[2].c_str());
+		assert(opt.startPF <= opt.endPF);
+		assert(opt.incPF > 0.0);
+		assert((opt.endPF-opt.startPF)/opt.incPF < MAX_PRUNES);
+	}else{
+		cerr << "Unable to understand prune factor value or range." << endl;
+		cerr << "Use a fixed value ('-1.5') or a range ('-5:1:0')" << endl;
+		return false;
+	}
+
+	// Read rows and cols
+	opt.rows = static_cast<size_t>(atol(args[argi++].c_str()));
+	opt.cols = static_cast<size_t>(atol(args[argi++].c_str()));
+
+	// Read all the remaining arguments as input files
+	opt.files.assign(args.begin() + argi, args.end());
+	return true;
+}
+
+/**
+ * Stages of the TEBPT processing of a scene (see TEBPTScene), independent
+ * of the configuration of its matrix.
+ */
+class TEBPTSceneBase
+{
+public:
+	virtual ~TEBPTSceneBase(){}
+
+	// Read the input data (only when TEBPTOptions::preload, otherwise it is read by construct())
+	virtual void read() = 0;
+
+	// Compute the leaves, filter them, generate the WRAG and construct (or reconstruct) the BPT
+	virtual void construct() = 0;
+
+	// Build the node tables, prune the BPT and write all the outputs
+	virtual void write() = 0;
+
+	// Free the BPT of the scene (not needed before exiting)
+	virtual void release() = 0;
+
+	// Estimated peak memory of the processing of the scene, in bytes
+	virtual size_t estimatedMemory() const = 0;
+
+	virtual size_t getRows() const = 0;
+	virtual size_t getCols() const = 0;
+};
+
+/**
+ * TEBPT processing of the given dataset with the given configuration
+ * (TEBPTConfig, in _config.h)
+ *
+ * The input files are checked on construction. The BPT nodes get the IDs
+ * of their own tree (from the NodeIdContext of the WRAG generator), so that
+ * the construct() stages of several scenes may run concurrently. However,
+ * the node and dissimilarity counters of the report are taken from the
+ * process wide storage counters, thus they include the nodes of the scenes
+ * constructed at the same time.
+ */
+template<class Config>
+class TEBPTScene : public TEBPTSceneBase
+{
+public:
+	typedef typename Config::BPT					BPT;
+	typedef typename Config::Dissimilarity			Dissimilarity;
+	typedef typename Config::PruneCriterion			PruneCriterion;
+
+	// Description (names, sizes and headers) of all the input files
+	typedef MultiFileWithSizeReader<complex<float> >		Matrix2DFiles;
+	// Prefetching reader to read a crop of all the files by strips
+	typedef MultiFileBlockReader<complex<float> >			Matrix2DReader;
+	// Basis change of the scattering vectors (in _config.h, for each configuration)
+	typedef typename Config::SOperator						SOperator;
+
+	typedef DenseWRAGGenerator<typename BPT::Node>			WRAG;
+
+	TEBPTScene(const TEBPTOptions& options, StageProfiler& aProfiler) :
+		opt(options), profiler(aProfiler), inputFiles(openFiles(opt)), fileReader(NULL), wrag(NULL), root(NULL){
+		// Construct the reader for a crop of the data...
+		// NOTE: Only the data within the crop is read from the files
+		if(!(opt.crop_height > 0 && opt.crop_with > 0)){
+			// ... or take as a crop the complete dataset if not specified
+			opt.crop_sr = opt.crop_sc = 0;
+			opt.crop_height = inputFiles.getRows();
+			opt.crop_with = inputFiles.getCols();
+		}
+		// When preloading, the whole crop is read as a single strip
+		const size_t stripMB = opt.preload ? (rawBytes() >> 20) + 1 : opt.io_strip_mb;
+		fileReader = new Matrix2DReader(inputFiles, opt.crop_sr, opt.crop_sc, opt.crop_height, opt.crop_with, stripMB);
+		rows = fileReader->getRows();
+		cols = fileReader->getCols();
+	}
+
+	~TEBPTScene(){
+		delete wrag;
+		delete fileReader;
+	}
+
+	size_t getRows() const {
+		return rows;
+	}
+
+	size_t getCols() const {
+		return cols;
+	}
+
+	/**
+	 * Estimated peak memory: the strips of the reader plus the nodes (leaves
+	 * and merged nodes, with their region models), the dissimilarities of the
+	 * WRAG (8-connectivity, in the sets of both nodes) and the node tables,
+	 * including the allocator overheads, plus the queue of the asynchronous
+	 * saving of the node models.
+	 */
+	size_t estimatedMemory() const {
+		const size_t pixels = opt.crop_height * opt.crop_with;
+		const size_t blocks = opt.files.size() / Config::files_per_acquisition;
+		// Covariances stored on the heap by the dynamic models (see VectorMatrixModel)
+		const size_t modelBytes = (Config::num_covariances > 0) ? 0 :
+				blocks * Config::subMatrix_size * Config::subMatrix_size * sizeof(complex<double>) + 64;
+		const size_t nodeBytes = sizeof(typename BPT::Node) + modelBytes + 16;
+		const size_t dissimilarityBytes = sizeof(typename BPT::Dissimilarity) + 16 + 3 * 48;
+		size_t bytes = rawBytes() * (opt.preload ? 1 : 2) + pixels * (2 * nodeBytes + 4 * dissimilarityBytes + 2 * 64);
+#if defined(ASYNC_SAVE_BPT_MODELS) && (defined(SAVE_BPT_MODELS) || defined(SAVE_BPT_MODELS_AND_HOMOGENEITY))
+		// Planes of the node models, the files written for each father node
+		const size_t planes = PolSARProPlaneLayout(blocks * Config::subMatrix_size, Config::subMatrix_size).getNPlanes();
+		bytes += BPT::SaveMNPol::allocatedBytes(pixels, planes);
+#endif
+		return bytes;
+	}
+
+	void read(){
+		if(!opt.preload) return;
+		StageProfiler::Scope readStage(profiler, "read");
+		fileReader->getStrip(0);
+		readStage.stop();
+	}
+
+	void construct(){
+		const size_t nodesCreated = BPT::NodeStoragePolicy::created;
+		const size_t dissimilaritiesCreated = BPT::DissimilarityStoragePolicy::created;
+
+		cout << "Dataset size [pixels]: " << rows << " x " << cols << endl;
+
+		// Define the dissimilarity measure employed --> in _config.h file
+		Dissimilarity		diss = Dissimilarity();
+
+		// Initialize the Weighted Region Adjacency Graph generator, computing the
+		// leaves in bulk from the strips of the reader with the basis change
+		StageProfiler::Scope readStage(profiler, "read");
+		wrag = new WRAG(*fileReader, SOperator());
+		fileReader->release();
+		readStage.stop();
+
+		profiler.setCounter("rows", rows);
+		profiler.setCounter("cols", cols);
+		profiler.setCounter("files", fileReader->getNFiles());
+		profiler.setCounter("bytes_read", fileReader->getBytesRead());
+
+		cout << "Read " << fileReader->getBytesRead() / (1024.0 * 1024.0) << " MB from " << fileReader->getNFiles() << " files at "
+				<< fileReader->getReadThroughput() / (1024.0 * 1024.0) << " MB/s (stalled " << fileReader->getStallTime() << " s)" << endl;
+
+		cout << "Model matrix size: " << wrag->getData()[0]->getModel().getMatrixSize() << " stored into matrix(ces) of size " << wrag->getData()[0]->getModel().getCovariance(0).getCols() << endl;
+
+		// Apply the initial filtering, either Multilook (Boxcar)...
+		// NOTE: To disable it a 1x1 multilook may be applied
+		// ======================================== Multilook filter =============================================
+		if(opt.nl_filtering){
+			cout << "\nPerforming Boxcar " << opt.nlr << "x" << opt.nlc << " spatial filtering... " << flush;
+			StageProfiler::Scope filterStage(profiler, "filter");
+			boxCarFilter2DFullInterp(wrag->getData().begin(), rows, cols, opt.nlr, opt.nlc);
+			cout << "Done. (Elapsed " << 1000 * filterStage.stop() << " milliseconds)" << endl;
+		}
+		// ====================================== End Multilook filter ===========================================
+
+
+		// ... or Distance Based Bilateral filter, as defined in:
+		// Alonso-González, A.; López-Martínez, C.; Salembier, P.; Deng, X.
+		// Bilateral Distance Based Filtering for Polarimetric SAR Data.
+		// Remote Sens. 2013, 5, 5620-5641.
+		// ======================================== Bilateral filter =============================================
+		if(opt.bl_filtering){
+			ImageData<double> 	k_img(rows, cols);
+
+			if(opt.blf_sigma_t < 0){
+				cout << "Calculating automatically the sigma_t parameter (10x10 blocks)..." << endl;
+				opt.blf_sigma_t = compute_sigma_t(make_LinearAccessor(wrag->getData(), cols), rows, cols, ModelAccessor<BPT>(), 10);
+			}
+
+			cout << "\nPerforming Bilateral " << opt.nlr << "x" << opt.nlc << " spatial filtering:\n  iterations:\t" << opt.blf_iterations <<
+					"\n  sigma_s:\t" << opt.blf_sigma_s << "\n  sigma_p:\t" << opt.blf_sigma_p << "\n  sigma_t:\t" << opt.blf_sigma_t << endl;
+
+			// Distance employed in the filter
+//			BLFGeodesicDissExp<typename BPT::RegionModel::covariance_type> 		bfdiss(blf_sigma_t);
+			BLFDiagonalWishartDiss<typename BPT::RegionModel::covariance_type> 	bfdiss(opt.blf_sigma_t);
+
+			{	// Scope to automatically delete the ProgressDisplay on exit
+			StageProfiler::Scope filterStage(profiler, "filter");
+			ProgressDisplay show_progress(1);
+			iterativeCrossBilateralDBF2Filter(
+					make_LinearAccessor(wrag->getData(), cols),	// in
+					make_LinearAccessor(wrag->getData(), cols),	// ref
+					make_LinearAccessor(wrag->getData(), cols),	// out
+					k_img,
+					bfdiss, rows, cols, opt.nlr, opt.nlc, opt.blf_sigma_s, opt.blf_sigma_p, opt.blf_iterations, ModelAccessor<BPT>());
+			}
+
+			// Saving k parameter
+			cout << "Saving the k parameter for the last iteration of bilateral filtering... " << flush;
+			StageProfiler::Scope kbinStage(profiler, "write");
+			ofstream k_stream(opt.outputFile("k.bin").c_str());
+			if (k_stream.fail()) cerr << "ERROR: the 'k.bin' file cannot be opened for writing!" << endl;
+			// Dissimilarity for temporal stability calculation
+			for_each(k_img.begin(), k_img.end(), printValueTo<double>(k_stream));
+			// Close file
+			k_stream.close();
+			profiler.addCounter("bytes_written", StageProfiler::fileBytes(opt.outputFile("k.bin")));
+			cout << "Done. (Elapsed " << 1000 * kbinStage.stop()	<< " milliseconds)" << endl;
+		}
+		// ====================================== End Bilateral filter ===========================================
+
+		// Construct the BPT
+		if(opt.bptFile.size() == 0){
+			// If the merging sequence has not been provided
+			// Generate WRAG and BPT
+			cout << "\nGenerating WRAG... " << flush;
+			StageProfiler::Scope wragStage(profiler, "wrag");
+			wrag->template generateWRAG_2D_Connectivity8<Dissimilarity, typename BPT::Dissimilarity> (diss);
+			cout << "Done. (Elapsed " << 1000 * wragStage.stop() << " milliseconds)" << endl;
+			cout << "  Number of Nodes existing: " << BPT::NodeStoragePolicy::balance << endl;
+			cout << "  Number of Dissimilarities existing: " << BPT::DissimilarityStoragePolicy::balance << endl;
+
+			cout << "\nGenerating the BPT representation..." << flush;
+			StageProfiler::Scope bptStage(profiler, "construction");
+			typename BPT::Constructor constructor(wrag->begin(), wrag->end(), wrag->getIdContext());
+			constructor.setOutputDir(opt.outPath);
+			if(opt.reclaim_memory) constructor.setHighWaterMark(opt.reclaim_mb);
+			typename BPT::NodeSet consSet = constructor.template getBinaryPartitionForest<
+					Dissimilarity, ModelMerge > (1, diss);
+			cout << "BPT created. (Elapsed " << 1000 * bptStage.stop() << " milliseconds)" << endl;
+			cout << "Number of Nodes existing: " << BPT::NodeStoragePolicy::balance << endl;
+			cout << "Number of Dissimilarities existing: " << BPT::DissimilarityStoragePolicy::balance << endl;
+			if(opt.reclaim_memory){
+				cout << "Memory returned to the system: " << constructor.getReclaimedKB() / 1024.0 << " MB (" << constructor.getTrims() << " trims)" << endl;
+				profiler.addCounter("memory_trims", constructor.getTrims());
+				profiler.addCounter("reclaimed_kb", constructor.getReclaimedKB());
+			}
+
+			root = *(consSet.begin());
+		}else{
+			// If the merging sequence has been provided
+			// ReGenerate BPT (much faster, no dissimilarity computation)
+			ifstream msFile(opt.bptFile.c_str());
+			cout << "\nRegenerating the BPT representation..." << flush;
+			StageProfiler::Scope bptStage(profiler, "construction");
+			typename BPT::Reconstructor reconstructor(wrag->begin(), wrag->end(), wrag->getIdContext());
+			typename BPT::NodeSet consSet = reconstructor.template getBinaryPartitionForest<ModelMerge > (msFile, 1);
+			cout << "BPT created. (Elapsed " << 1000 * bptStage.stop() << " milliseconds)" << endl;
+			cout << "Number of Nodes existing: " << BPT::NodeStoragePolicy::balance << endl;
+			cout << "Number of Dissimilarities existing: " << BPT::DissimilarityStoragePolicy::balance << endl;
+			msFile.close();
+
+			root = *(consSet.begin());
+		}
+		profiler.setCounter("nodes_created", BPT::NodeStoragePolicy::created - nodesCreated);
+		profiler.setCounter("dissimilarities_created", BPT::DissimilarityStoragePolicy::created - dissimilaritiesCreated);
+
+		// Debug validation of the constructed BPT (expensive checks, see BPTFrame::validate())
+		if(opt.validate){
+			cout << "\nValidating the BPT... " << flush;
+			StageProfiler::Scope validateStage(profiler, "validate");
+			const size_t errors = BPT::validate(root, rows * cols);
+			cout << "Done. (Elapsed " << 1000 * validateStage.stop() << " milliseconds, " << errors << " errors)" << endl;
+			profiler.setCounter("validation_errors", errors);
+			if(errors > 0) __throw_runtime_error(__N("ERROR: The BPT validation failed"));
+		}
+	}
+
+	void write(){
+		// Save the BPT (topology, homogeneity and models) for later prunes (TEBPT-prune)
+		if(opt.save_tree){
+			cout << "\nSaving the BPT into BPT.tree... " << flush;
+			StageProfiler::Scope treeStage(profiler, "write");
+			BPTTreeFileWriter<typename BPT::CheckingPol>		treeWriter(rows, cols, Config::subMatrix_size, Config::outputPrefix());
+			treeWriter.writeToFile(opt.outputFile("BPT.tree"), root);
+			profiler.addCounter("bytes_written", StageProfiler::fileBytes(opt.outputFile("BPT.tree")));
+			cout << "Done. (Elapsed " << 1000 * treeStage.stop() << " milliseconds)" << endl;
+		}
+
+		// Region id label maps for a fixed number of regions (multiscale products)
+		if(!opt.nregs.empty()){
+			cout << "\nGenerating the region ID data of " << opt.nregs.size() << " NRegs prune(s)... " << flush;
+			StageProfiler::Scope nregsStage(profiler, "nregs");
+			vector<vector<typename BPT::NodeID> > labels;
+			BPT::NRegs_labels(root, opt.nregs, rows, cols, labels);
+			for(size_t k = 0; k < opt.nregs.size(); ++k){
+				const string file = opt.outputFile(string("RegId_NRegs_") + to_string(opt.nregs[k]) + ".bin");
+				ofstream RIDFile (file.c_str());
+				if(RIDFile.fail()) cerr<<"ERROR: region ID file cannot be opened!"<<endl;
+				RIDFile.write(reinterpret_cast<const char*>(&(labels[k][0])), labels[k].size() * sizeof(typename BPT::NodeID));
+				RIDFile.close();
+				profiler.addCounter("bytes_written", StageProfiler::fileBytes(file));
+			}
+			cout << "Done. (Elapsed " << 1000 * nregsStage.stop() << " milliseconds)" << endl;
+		}
+
+		// Homogeneity of all the nodes, computed once for several prunes (or before releasing the models)
+		// NOTE: The prune criterion reads it instead of accessing the node models. A single prune
+		// only evaluates the nodes above its regions, cheaper than the table of all the nodes
+		size_t prunes = 0;
+		for(double pruneFactor = opt.startPF; pruneFactor <= opt.endPF; pruneFactor += opt.incPF) ++prunes;
+		typename PruneCriterion::HomogeneityTable homogTable;
+		const typename PruneCriterion::HomogeneityTable* homog = NULL;
+		if(prunes > 1 || opt.reclaim_memory){
+			cout << "\nComputing the homogeneity of the BPT nodes... " << flush;
+			StageProfiler::Scope homogStage(profiler, "tables");
+			homogTable.build(root);
+			homog = &homogTable;
+			cout << "Done. (Elapsed " << 1000 * homogStage.stop() << " milliseconds)" << endl;
+		}
+		profiler.setCounter("merges", rows * cols - 1);
+
+		// Leaves of each node as a slice of a DFS ordering, to scatter the pruned regions into images
+		cout << "\nComputing the leaf ordering of the BPT... " << flush;
+		StageProfiler::Scope orderStage(profiler, "tables");
+		NodeLeafOrder leafOrder;
+		leafOrder.build(root, rows, cols);
+		cout << "Done. (Elapsed " << 1000 * orderStage.stop() << " milliseconds)" << endl;
+
+		// Bounding box and perimeter of all the nodes, for the region feature tables
+		NodeShapeTable shapeTable;
+		if(opt.gen_features){
+			cout << "Computing the shape of the BPT nodes... " << flush;
+			StageProfiler::Scope shapeStage(profiler, "tables");
+			shapeTable.build(root, rows, cols);
+			cout << "Done. (Elapsed " << 1000 * shapeStage.stop() << " milliseconds)" << endl;
+		}
+
+		// Set to contain the pruned nodes
+		typename BPT::NodeSet prunedSet;
+
+		// Temporal stability of the pruned regions, cached between prune levels
+		typedef TemporalStabilityEngine<typename BPT::NodePointer, double>	TSEngine;
+		TSEngine tsEngine(root->getModel().getNumCovariances(), opt.gen_dist_pairs);
+
+		// Once the tables are built, only the models of the regions of the prunes (and the root) are needed
+		if(opt.reclaim_memory){
+			cout << "\nReleasing the models not needed by the prunes... " << flush;
+			StageProfiler::Scope reclaimStage(profiler, "reclaim");
+			typename BPT::NodeSet keep;
+			keep.insert(root);
+			for(double pruneFactor = opt.startPF; pruneFactor <= opt.endPF; pruneFactor += opt.incPF){
+				BPT::prune(root, keep, PruneCriterion(pruneFactor, homog));
+			}
+			const size_t released = BPT::releaseModels(root, keep);
+			const long rss = MemoryUsage::currentRSS();
+			MemoryUsage::trim();
+			const long reclaimed = max(0L, rss - MemoryUsage::currentRSS());
+			profiler.addCounter("released_models", released);
+			profiler.addCounter("memory_trims", 1);
+			profiler.addCounter("reclaimed_kb", reclaimed);
+			cout << "Done. (Elapsed " << 1000 * reclaimStage.stop() << " milliseconds, " << released << " models released, "
+					<< reclaimed / 1024.0 << " MB returned to the system)" << endl;
+		}
+
+		// Print the TotalSumOfSquares of the root node
+//		cout << "Root Node TSS: \t" << root->getModel().getTotalSumOfSquares() << endl;
+
+		// The compact Regions.lbl replaces the region id and temporal stability rasters, unless --no-write
+		const bool compact = opt.compact_out && opt.write_prune;
+
+		// Start BPT pruning processes, for each prune factor
+		for(double pruneFactor = opt.startPF; pruneFactor <= opt.endPF; pruneFactor += opt.incPF){
+			cout << "\nPruning BPT at " << pruneFactor << " dB ... " << flush;
+			StageProfiler::Scope pruneStage(profiler, "prune");
+
+			// Prune the BPT
+			// NOTE: PruneCriterion defined in _config.h (for each configuration)
+			BPT::prune(root, prunedSet, PruneCriterion(pruneFactor, homog));
+
+			cout << "Done. (Elapsed " << 1000 * pruneStage.stop() << " milliseconds)" << endl;
+			cout << "  Number of pruned regions: " << prunedSet.size() << endl;
+			profiler.addCounter("prunes", 1);
+			profiler.addCounter("pruned_regions", prunedSet.size());
+			cout << "  Average region size: " << static_cast<double>(rows) * cols / prunedSet.size() << endl;
+
+			cout << "Generating image from pruned tree... " << flush;
+			StageProfiler::Scope rasterStage(profiler, "raster");
+
+			// Generate a image source from the set of pruned nodes
+			BPTDataSource<typename BPT::NodePointer, 2>		source(prunedSet, leafOrder);
+			cout << "Done. (Elapsed " << 1000 * rasterStage.stop() << " milliseconds)" << endl;
+
+			string dir = opt.outputFile(string("Prune_") + to_string(pruneFactor));
+			{	// Creating the directory path dir
+				struct stat fstat;
+				if (stat(dir.c_str(), &fstat) != 0){
+					cout << "\n  Creating dir " << dir.c_str() << endl;
+					assert(mkdir(dir.c_str(), S_IRWXU)==0);
+				}
+			}
+			dir += to_string("/") + Config::outputFolder();
+			{ // Creating the directory path dir
+				struct stat fstat;
+				if (stat(dir.c_str(), &fstat) != 0){
+					cout << "  Creating dir " << dir.c_str() << endl;
+					assert(mkdir(dir.c_str(), S_IRWXU)==0);
+				}
+			}
+
+			if(opt.write_prune){
+				cout << "Writing sequence data... " << flush;
+				StageProfiler::Scope seqStage(profiler, "write");
+
+				// Save the whole matrix (Only use this with DynamicMatrixModel)
+//				PolSARProFormatMatrixWriter<> writer;
+				// Save only polarimetric submatrices (Use with VectorMatrixModel)
+				PolSARProFormatVectorMatrixWriter<Config::subMatrix_size, typename BPT::CheckingPol> writer;
+
+				writer.writeDataToDir(dir, source.begin(), source.end(), Config::outputPrefix());
+				writer.writeConfigFile(dir, rows, cols);
+				cout << "Done. (Elapsed " << 1000 * seqStage.stop() << " milliseconds)" << endl;
+
+				if(!compact){
+					cout << "Generating region ID data... " << flush;
+					StageProfiler::Scope regIdStage(profiler, "write");
+					ofstream RIDFile ((dir + "/RegId.bin").c_str());
+					if(RIDFile.fail()) cerr<<"ERROR: region ID file cannot be opened!"<<endl;
+					for_each(source.begin(), source.end(), printRegIdTo<typename BPT::NodeID>(RIDFile));
+					RIDFile.close();
+					cout << "Done. (Elapsed " << 1000 * regIdStage.stop() << " milliseconds)" << endl;
+				}
+			}
+
+			// Only generate temporal stability data if NumCovariances() > 1
+			if(opt.gen_ts && root->getModel().getNumCovariances() > 1){
+				// Temporal stability of all the pruned regions (GEIG, DG and pairs in one pass)
+				cout << "Generating region temporal stability data (GEIGs_Full, DGs_Full" << (opt.gen_dist_pairs ? ", pairs" : "") << ")... " << flush;
+				StageProfiler::Scope tsStage(profiler, "temporal_stability");
+				const size_t reused = tsEngine.getReused();
+				{ ProgressDisplay progress(1);
+				tsEngine.evaluate(prunedSet); }
+				cout << "Done. (Elapsed " << 1000 * tsStage.stop() << " milliseconds, "
+						<< tsEngine.getReused() - reused << " regions reused)" << endl;
+			}
+
+			if(opt.gen_ts && root->getModel().getNumCovariances() > 1 && !compact){
+				// Temporal stability with full matrix geodesic measure
+				cout << "Writing region temporal stability data (GEIGs_Full)... " << flush;
+				StageProfiler::Scope geigStage(profiler, "write");
+				ofstream TSFileGEIG_full((dir + "/TStability_GEIGs_full.bin").c_str());
+				if (TSFileGEIG_full.fail())
+					cerr << "ERROR: temporal stability file cannot be opened!" << endl;
+
+				BPTDataSource<typename BPT::NodePointer, 2, typename TSEngine::GEIG>		TSsourceGEIG_full(prunedSet, leafOrder, tsEngine.geig());
+				for_each(TSsourceGEIG_full.begin(), TSsourceGEIG_full.end(), printValueTo<double>(TSFileGEIG_full));
+				// Close file
+				TSFileGEIG_full.close();
+				cout << "Done. (Elapsed " << 1000 * geigStage.stop() << " milliseconds)" << endl;
+
+				// Temporal stability with diagonal geodesic measure
+				cout << "Writing region temporal stability data (DGs_Full)... " << flush;
+				StageProfiler::Scope dgStage(profiler, "write");
+				ofstream TSFileDG_full((dir + "/TStability_DGs_full.bin").c_str());
+				if (TSFileDG_full.fail())
+					cerr << "ERROR: temporal stability file cannot be opened!" << endl;
+
+				BPTDataSource < typename BPT::NodePointer, 2, typename TSEngine::DG > TSsourceDG_full(
+						prunedSet, leafOrder, tsEngine.dg());
+				for_each(TSsourceDG_full.begin(), TSsourceDG_full.end(),
+						printValueTo<double> (TSFileDG_full));
+				// Close file
+				TSFileDG_full.close();
+				cout << "Done. (Elapsed " << 1000 * dgStage.stop() << " milliseconds)" << endl;
+
+				// Generate change images for each acquisition pair if enabled
+				// NOTE: May be a large number of images
+				if(opt.gen_dist_pairs){
+					cout << "Writing all change images pairs (GEIG)... " << flush;
+					StageProfiler::Scope dpStage(profiler, "write");
+					vector<string> DPFiles;
+					for(size_t i = 0; i < root->getModel().getNumCovariances(); ++i){
+						for(size_t j = i+1; j < root->getModel().getNumCovariances(); ++j){
+							DPFiles.push_back(dir + string("/DP_GEIG_") + to_string(i) + string("_") + to_string(j) + ".bin");
+						}
+					}
+					// All the pair images in a single pass over the pruned regions and the image
+					BPTMultiDataSource<typename BPT::NodePointer, typename TSEngine::Pairs>	DPSource(prunedSet, tsEngine.pairs());
+					DPSource.writeToFiles(DPFiles, source.begin(), source.end());
+					cout << "Done. (Elapsed " << 1000 * dpStage.stop() << " milliseconds)" << endl;
+				}
+			}
+
+			if(opt.gen_features){
+				cout << "Writing region features table... " << flush;
+				StageProfiler::Scope featuresStage(profiler, "write");
+				RegionFeatureTableWriter<typename BPT::NodePointer, typename BPT::CheckingPol>	features(Config::subMatrix_size, Config::outputPrefix());
+				features.setRegions(prunedSet, shapeTable);
+				if(opt.gen_ts && root->getModel().getNumCovariances() > 1){
+					features.addColumn("TStability_GEIGs_full", tsEngine.geig());
+					features.addColumn("TStability_DGs_full", tsEngine.dg());
+					if(opt.gen_dist_pairs){
+						for(size_t i = 0; i < root->getModel().getNumCovariances(); ++i){
+							for(size_t j = i+1; j < root->getModel().getNumCovariances(); ++j){
+								features.addColumn(string("DP_GEIG_") + to_string(i) + string("_") + to_string(j), tsEngine.pair(i,j));
+							}
+						}
+					}
+				}
+				features.writeToFiles(dir + "/Regions.features", rows, cols);
+				cout << "Done. (Elapsed " << 1000 * featuresStage.stop() << " milliseconds)" << endl;
+			}
+
+			if(compact){
+				cout << "Writing compact region data... " << flush;
+				StageProfiler::Scope compactStage(profiler, "write");
+				// Compact output of the region ids and per region values (see RegionLabelMapFormat.hpp)
+				RegionLabelMapWriter<typename BPT::NodePointer, typename BPT::CheckingPol>	labelMap(rows, cols, true);
+				labelMap.setRegions(prunedSet);
+				if(opt.gen_ts && root->getModel().getNumCovariances() > 1){
+					labelMap.addColumn("TStability_GEIGs_full", tsEngine.geig());
+					labelMap.addColumn("TStability_DGs_full", tsEngine.dg());
+					if(opt.gen_dist_pairs){
+						for(size_t i = 0; i < root->getModel().getNumCovariances(); ++i){
+							for(size_t j = i+1; j < root->getModel().getNumCovariances(); ++j){
+								labelMap.addColumn(string("DP_GEIG_") + to_string(i) + string("_") + to_string(j), tsEngine.pair(i,j));
+							}
+						}
+					}
+				}
+				labelMap.writeToFile(dir + "/Regions.lbl", source.begin(), source.end());
+				cout << "Done. (Elapsed " << 1000 * compactStage.stop() << " milliseconds)" << endl;
+			}
+
+			profiler.addCounter("bytes_written", StageProfiler::directoryBytes(dir));
+
+			// Clear the pruned set
+			prunedSet.clear();
+		}
+	}
+
+	void release(){
+		if(root) BPT::Node::removeBPTNodes(root);
+		// Construction aborted by an error: free its leaves and merged nodes
+		else if(wrag) BPT::removeForest(wrag->begin(), wrag->end());
+		root = NULL;
+		delete wrag;
+		wrag = NULL;
+	}
+
+private:
+	// Non copyable (owns the reader and the BPT)
+	TEBPTScene(const TEBPTScene&);
+	TEBPTScene& operator=(const TEBPTScene&);
+
+	// Check all the files and their sizes
+	static Matrix2DFiles openFiles(const TEBPTOptions& opt){
+		// Models with a fixed number of covariance matrices (-DTEBPT_ACQUISITIONS=N)
+		if(Config::num_covariances > 0 && opt.files.size() != Config::num_covariances * Config::files_per_acquisition){
+			cerr << "ERROR: TEBPT has been compiled for " << Config::num_covariances << " acquisitions ("
+					<< Config::num_covariances * Config::files_per_acquisition << " input files), but " << opt.files.size() << " files were given" << endl;
+			__throw_invalid_argument(__N("ERROR: The number of input files does not correspond to TEBPT_ACQUISITIONS"));
+		}
+		return (opt.rows != 0 && opt.cols != 0)?
+			Matrix2DFiles(&(opt.files[0]), opt.files.size(), opt.rows, opt.cols, opt.swap_endianness) :
+			Matrix2DFiles(&(opt.files[0]), opt.files.size(), opt.swap_endianness);
+	}
+
+	// Bytes of the crop of all the input files
+	size_t rawBytes() const {
+		return opt.crop_height * opt.crop_with * opt.files.size() * sizeof(complex<float>);
+	}
+
+	TEBPTOptions					opt;
+	StageProfiler&					profiler;
+	Matrix2DFiles					inputFiles;
+	Matrix2DReader*					fileReader;
+	WRAG*							wrag;
+	size_t							rows, cols;
+	// Pointer to contain the root node
+	typename BPT::WeakNodePointer	root;
+};
+
+/**
+ * Create the processing of the scene given by opt, dispatching to the
+ * configuration (model and basis) of its matrix. Returns NULL if the matrix
+ * is unknown.
+ */
+inline TEBPTSceneBase* newTEBPTScene(const TEBPTOptions& opt, StageProfiler& profiler){
+	if(opt.matrix == "C3") return new TEBPTScene<ConfigC3>(opt, profiler);
+	else if(opt.matrix == "T3") return new TEBPTScene<ConfigT3>(opt, profiler);
+	else if(opt.matrix == "C2") return new TEBPTScene<ConfigC2>(opt, profiler);
+	else if(opt.matrix == "C1") return new TEBPTScene<ConfigC1>(opt, profiler);
+	return NULL;
+}
+
+#endif /* TEBPT_STAGES_H_ */
@@ -0,0 +1,214 @@
+/*
+ * Benchmark.hpp
+ *
+ * Copyright (c) 2015 Alberto Alonso Gonzalez
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ *  Created on: 19/10/2026
+ *      Author: Alberto Alonso-Gonzalez
+ */
+
+#ifndef BENCHMARK_HPP_
+#define BENCHMARK_HPP_
+
+#include <cstddef>
+#include <ctime>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <unistd.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace tscbpt
+{
+
+using namespace std;
+
+// Prevent the compiler from removing the computation of a benchmarked value
+template<typename T>
+inline void doNotOptimize(const T& value){
+	asm volatile("" : : "r"(&value) : "memory");
+}
+
+/**
+ * Self-contained microbenchmark runner (no external dependencies).
+ *
+ * A benchmark is a functor called with a number of iterations, running the
+ * measured operation that number of times. The number of iterations is first
+ * calibrated to last at least minTime seconds and then the benchmark is
+ * repeated the given number of times: the median wall clock and CPU times per
+ * iteration, and the minimum wall clock time, are reported.
+ *
+ * The results are written as JSON, with the same fields as Google Benchmark
+ * (name, iterations, real_time, cpu_time, time_unit) and one benchmark per
+ * line, so that they may be compared with its tools or against a baseline
+ * with compare() to detect performance regressions.
+ */
+class BenchmarkRunner
+{
+public:
+	struct Result
+	{
+		string		name;
+		size_t		iterations;
+		double		realNs, cpuNs, minRealNs;
+	};
+
+	BenchmarkRunner(double minTime = 0.1, size_t repetitions = 3, const string& filter = "") :
+		_minTime(minTime), _repetitions(max<size_t>(repetitions, 1)), _filter(filter){}
+
+	// Run the benchmark (if its name contains the filter string)
+	template<class Benchmark>
+	void run(const string& name, const Benchmark& bench){
+		if(!_filter.empty() && name.find(_filter) == string::npos) return;
+
+		// Calibrate the number of iterations
+		size_t iterations = 1;
+		double cpu, real = measure(bench, iterations, cpu);
+		while(real < _minTime){
+			const double factor = (real > 0) ? min(10.0, 1.2 * _minTime / real) : 10.0;
+			iterations = max(iterations + 1, static_cast<size_t>(iterations * factor));
+			real = measure(bench, iterations, cpu);
+		}
+
+		vector<double> reals, cpus;
+		for(size_t r = 0; r < _repetitions; ++r){
+			reals.push_back(measure(bench, iterations, cpu) * 1e9 / iterations);
+			cpus.push_back(cpu * 1e9 / iterations);
+		}
+		Result res;
+		res.name = name;
+		res.iterations = iterations;
+		res.minRealNs = *min_element(reals.begin(), reals.end());
+		res.realNs = median(reals);
+		res.cpuNs = median(cpus);
+		_results.push_back(res);
+
+		cout << left << setw(56) << name << right << setw(16) << fixed << setprecision(1) << res.realNs << " ns"
+				<< setw(16) << res.cpuNs << " ns" << setw(12) << iterations << endl;
+	}
+
+	const vector<Result>& getResults() const {
+		return _results;
+	}
+
+	void writeJSON(ostream& os) const {
+		char date[64];
+		const time_t now = time(NULL);
+		strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+		int threads = 1;
+		#ifdef _OPENMP
+		threads = omp_get_max_threads();
+		#endif
+		os << setprecision(6) << fixed;
+		os << "{\n  \"context\": {\"date\": \"" << date << "\", \"num_cpus\": " << sysconf(_SC_NPROCESSORS_ONLN)
+				<< ", \"threads\": " << threads << ", \"min_time\": " << _minTime << ", \"repetitions\": " << _repetitions << "},\n";
+		os << "  \"benchmarks\": [";
+		for(size_t i = 0; i < _results.size(); ++i){
+			const Result& r = _results[i];
+			os << (i ? ",\n" : "\n") << "    {\"name\": \"" << r.name << "\", \"iterations\": " << r.iterations
+					<< ", \"real_time\": " << r.realNs << ", \"cpu_time\": " << r.cpuNs << ", \"min_real_time\": " << r.minRealNs
+					<< ", \"time_unit\": \"ns\"}";
+		}
+		os << "\n  ]\n}\n";
+	}
+
+	// Write the JSON results into the given file. Returns false on failure
+	bool writeJSON(const string& file) const {
+		ofstream os(file.c_str(), ios::out | ios::trunc);
+		if(!os.good()) return false;
+		writeJSON(os);
+		return os.good();
+	}
+
+	/**
+	 * Compare the results with a baseline (a JSON file written by writeJSON),
+	 * reporting the benchmarks whose real time is more than tolerance (e.g.
+	 * 0.1 for 10%) above the baseline. Returns the number of regressions.
+	 */
+	size_t compare(const string& baselineFile, double tolerance, ostream& os) const {
+		ifstream is(baselineFile.c_str());
+		if(!is.good()){
+			os << "ERROR: Cannot read the baseline file " << baselineFile << endl;
+			return 1;
+		}
+		map<string, double> baseline;
+		string line;
+		while(getline(is, line)){
+			const string name = field(line, "\"name\": \"", "\"");
+			const string real = field(line, "\"real_time\": ", ",}");
+			if(!name.empty() && !real.empty()) baseline[name] = atof(real.c_str());
+		}
+
+		size_t regressions = 0;
+		for(size_t i = 0; i < _results.size(); ++i){
+			const map<string, double>::const_iterator it = baseline.find(_results[i].name);
+			if(it == baseline.end() || it->second <= 0) continue;
+			const double ratio = _results[i].realNs / it->second;
+			if(ratio > 1.0 + tolerance){
+				os << "REGRESSION: " << _results[i].name << " " << fixed << setprecision(1) << it->second << " ns -> "
+						<< _results[i].realNs << " ns (+" << (ratio - 1.0) * 100 << "%)" << endl;
+				++regressions;
+			}
+		}
+		return regressions;
+	}
+
+	// Monotonic wall clock time, in seconds
+	static double wallTime(){
+		timespec ts;
+		clock_gettime(CLOCK_MONOTONIC, &ts);
+		return ts.tv_sec + ts.tv_nsec * 1e-9;
+	}
+
+	// CPU time of the process (all threads), in seconds
+	static double cpuTime(){
+		timespec ts;
+		clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+		return ts.tv_sec + ts.tv_nsec * 1e-9;
+	}
+
+private:
+	template<class Benchmark>
+	static double measure(const Benchmark& bench, size_t iterations, double& cpu){
+		const double startCpu = cpuTime(), start = wallTime();
+		bench(iterations);
+		const double real = wallTime() - start;
+		cpu = cpuTime() - startCpu;
+		return real;
+	}
+
+	static double median(vector<double> values){
+		sort(values.begin(), values.end());
+		const size_t n = values.size();
+		return (n % 2) ? values[n / 2] : 0.5 * (values[n / 2 - 1] + values[n / 2]);
+	}
+
+	// Text of line after key and before any of the end characters
+	static string field(const string& line, const string& key, const char* end){
+		const size_t start = line.find(key);
+		if(start == string::npos) return string();
+		const size_t first = start + key.size();
+		return line.substr(first, line.find_first_of(end, first) - first);
+	}
+
+	double				_minTime;
+	size_t				_repetitions;
+	string				_filter;
+	vector<Result>		_results;
+};
+
+}
+
+#endif /* BENCHMARK_HPP_ */
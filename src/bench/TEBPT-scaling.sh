@@ -0,0 +1,86 @@
+#!/bin/sh
+#
+# TEBPT-scaling.sh
+#
+# Copyright (c) 2015 Alberto Alonso Gonzalez
+#
+# This Source Code Form is subject to the terms of the
+# Mozilla Public License, v. 2.0.
+# If a copy of the MPL was not distributed with this file,
+# You can obtain one at http://mozilla.org/MPL/2.0/.
+#
+#  Created on: 19/10/2026
+#      Author: Alberto Alonso-Gonzalez
+#
+# End to end throughput benchmark of TEBPT: for each scene size (in
+# megapixels, square scenes of 1024 x 1024 pixels per megapixel), a synthetic
+# time series is generated with TEBPT-synth and processed with TEBPT. The
+# stages of its run report (TEBPT_report.json) are collected into
+# workdir/scaling_stages.csv and a summary (total time, peak memory and
+# merges per second of the BPT construction) into workdir/scaling.csv, giving
+# the scaling curve to compare optimizations against.
+#
+# Usage:
+#     TEBPT-scaling.sh bindir workdir "sizes" "synth_args" "tebpt_args"
+#
+# e.g. TEBPT-scaling.sh bin /scratch/scaling "1 4 16" "--dates 3" "--no-write -2"
+# The generated data of each size is removed after its run.
+
+if [ $# -ne 5 ]; then
+	echo "Usage: $0 bindir workdir \"sizes\" \"synth_args\" \"tebpt_args\"" >&2
+	exit 1
+fi
+
+BIN_DIR=$1
+WORK_DIR=$2
+SIZES=$3
+SYNTH_ARGS=$4
+TEBPT_ARGS=$5
+
+mkdir -p "$WORK_DIR" || exit 1
+# TEBPT opens its inputs relative to its output directory
+WORK_DIR=$(cd "$WORK_DIR" && pwd) || exit 1
+STAGES_CSV="$WORK_DIR/scaling_stages.csv"
+SUMMARY_CSV="$WORK_DIR/scaling.csv"
+echo "megapixels,stage,calls,wall_seconds,cpu_seconds,peak_rss_kb" > "$STAGES_CSV"
+echo "megapixels,rows,cols,wall_seconds,cpu_seconds,peak_rss_kb,construction_seconds,merges,merges_per_second" > "$SUMMARY_CSV"
+
+printf "%10s %14s %14s %14s %16s\n" "MPixels" "Wall (s)" "Peak RSS (MB)" "BPT (s)" "Merges/s"
+for MP in $SIZES; do
+	SIDE=$(awk "BEGIN { printf \"%d\", sqrt($MP) * 1024 }")
+	DATA_DIR="$WORK_DIR/data_$MP"
+	RUN_DIR="$WORK_DIR/run_$MP"
+	rm -rf "$DATA_DIR" "$RUN_DIR"
+	mkdir -p "$DATA_DIR" "$RUN_DIR" || exit 1
+
+	# The last line of TEBPT-synth output is the list of files
+	if ! "$BIN_DIR/TEBPT-synth" $SYNTH_ARGS "$SIDE" "$SIDE" "$DATA_DIR" > "$RUN_DIR/synth.log" 2>&1; then
+		echo "ERROR: TEBPT-synth failed for $MP MPixels (see $RUN_DIR/synth.log)" >&2
+		exit 1
+	fi
+	FILES=$(tail -n 1 "$RUN_DIR/synth.log")
+
+	if ! "$BIN_DIR/TEBPT" --out "$RUN_DIR" --report TEBPT_report.json $TEBPT_ARGS 0 0 $FILES > "$RUN_DIR/TEBPT.log" 2>&1; then
+		echo "ERROR: TEBPT failed for $MP MPixels (see $RUN_DIR/TEBPT.log)" >&2
+		exit 1
+	fi
+	rm -rf "$DATA_DIR"
+
+	# The report has one stage or counter per line
+	REPORT="$RUN_DIR/TEBPT_report.json"
+	sed -n 's/.*{"name": "\([^"]*\)", "calls": \([0-9]*\), "wall_seconds": \([^,]*\), "cpu_seconds": \([^,]*\), "peak_rss_kb": \([0-9]*\)}.*/\1,\2,\3,\4,\5/p' "$REPORT" \
+		| sed "s/^/$MP,/" >> "$STAGES_CSV"
+	awk -v mp="$MP" -v side="$SIDE" '
+		/^  "wall_seconds"/ { gsub(/[,]/, "", $2); wall = $2 }
+		/^  "cpu_seconds"/ { gsub(/[,]/, "", $2); cpu = $2 }
+		/^  "peak_rss_kb"/ { gsub(/[,]/, "", $2); rss = $2 }
+		/"name": "construction"/ { split($0, f, "\"wall_seconds\": "); split(f[2], g, ","); bpt = g[1] }
+		/^    "merges"/ { gsub(/[,]/, "", $2); merges = $2 }
+		END {
+			rate = (bpt > 0) ? merges / bpt : 0
+			printf "%s,%s,%s,%s,%s,%s,%s,%s,%.1f\n", mp, side, side, wall, cpu, rss, bpt, merges, rate >> "'"$SUMMARY_CSV"'"
+			printf "%10s %14.2f %14.1f %14.2f %16.1f\n", mp, wall, rss / 1024.0, bpt, rate
+		}' "$REPORT"
+done
+
+echo "Results written into $SUMMARY_CSV and $STAGES_CSV"
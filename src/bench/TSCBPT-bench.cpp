@@ -0,0 +1,504 @@
+/*
+ * TSCBPT-bench.cpp
+ *
+ * Copyright (c) 2015 Alberto Alonso Gonzalez
+ *
+ * This Source Code Form is subject to the terms of the
+ * Mozilla Public License, v. 2.0.
+ * If a copy of the MPL was not distributed with this file,
+ * You can obtain one at http://mozilla.org/MPL/2.0/.
+ *
+ *  Created on: 19/10/2026
+ *      Author: Alberto Alonso-Gonzalez
+ */
+
+// Microbenchmarks of the TSCBPT kernels: dissimilarity measures, model merges,
+// norm2/dist2, the spatial filters and the BPT construction with each checking
+// policy, over synthetic data. The results are written as JSON (see
+// Benchmark.hpp) and may be compared with a baseline to detect performance
+// regressions.
+
+#include <tscbpt.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <complex>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <armadillo>
+#include "Benchmark.hpp"
+
+using namespace std;
+using namespace tscbpt;
+
+void printUsage(){
+	cerr << "Usage:\n    TSCBPT-bench [options]" << endl;
+	cerr << "\nOptions include:" << endl;
+	cerr << "  --filter text    Run only the benchmarks whose name contains text" << endl;
+	cerr << "  --min-time s     Minimum time of each measurement, in seconds (default: 0.1)" << endl;
+	cerr << "  --repetitions n  Measurements of each benchmark, the median is reported (default: 3)" << endl;
+	cerr << "  --out file       Write the results into file (default: bench.json)" << endl;
+	cerr << "  --baseline file  Compare with a former results file, failing on regressions" << endl;
+	cerr << "  --tolerance pct  Allowed slowdown against the baseline, in percent (default: 10)" << endl;
+	cerr << endl;
+}
+
+// Number of covariances (acquisitions) of the benchmarked models
+static const size_t COVARIANCES[]	= {1, 2, 5, 10, 20};
+static const size_t N_COVARIANCES	= sizeof(COVARIANCES) / sizeof(COVARIANCES[0]);
+
+typedef Pixel<vector<complex<float> >, 2, float>	ComplexPixel;
+typedef Pixel<vector<float>, 2, float>				IntensityPixel;
+
+/**
+ * Deterministic generator of random scattering vectors (circular complex
+ * gaussian, with a different power for each element)
+ */
+class ScatteringGenerator
+{
+public:
+	ScatteringGenerator(unsigned long seed = 1) : _state(seed){}
+
+	double uniform(){
+		_state = _state * 6364136223846793005ULL + 1442695040888963407ULL;
+		return ((_state >> 11) + 0.5) / 9007199254740992.0;
+	}
+
+	double gaussian(){
+		return sqrt(-2.0 * log(uniform())) * cos(2.0 * M_PI * uniform());
+	}
+
+	vector<complex<float> > scattering(size_t elems){
+		vector<complex<float> > v(elems);
+		for(size_t i = 0; i < elems; ++i){
+			const double sigma = sqrt(0.5 * (1 + i % 3));
+			v[i] = complex<float>(sigma * gaussian(), sigma * gaussian());
+		}
+		return v;
+	}
+
+	vector<float> intensity(size_t elems){
+		vector<complex<float> > s = scattering(elems);
+		vector<float> v(elems);
+		for(size_t i = 0; i < elems; ++i) v[i] = norm(s[i]);
+		return v;
+	}
+
+private:
+	unsigned long long	_state;
+};
+
+ComplexPixel complexPixel(ScatteringGenerator& gen, size_t elems){
+	static const float pos[2] = {0, 0};
+	return ComplexPixel(gen.scattering(elems), pos);
+}
+
+IntensityPixel intensityPixel(ScatteringGenerator& gen, size_t elems){
+	static const float pos[2] = {0, 0};
+	return IntensityPixel(gen.intensity(elems), pos);
+}
+
+// Model of a region averaging random pixels (at least 2 per element, for full rank covariances)
+template<class Model, class PixelType>
+Model makeRegion(ScatteringGenerator& gen, size_t elems, PixelType (*pixel)(ScatteringGenerator&, size_t)){
+	PixelType p = pixel(gen, elems);
+	Model m(p);
+	for(size_t i = 1; i < max<size_t>(16, 2 * elems); ++i){
+		PixelType q = pixel(gen, elems);
+		m = m.merge(Model(q));
+	}
+	return m;
+}
+
+// Minimal node holding a region model, as accessed by the measures and the merge operators
+template<class Model>
+struct BenchNode
+{
+	typedef Model		RegionModel;
+
+	BenchNode(const Model& m) : model(m){}
+
+	Model& getModel() {
+		return model;
+	}
+
+	const Model& getModel() const {
+		return model;
+	}
+
+	Model		model;
+};
+
+template<class Model, template<class, class> class Measure>
+struct MeasureBench
+{
+	typedef BenchNode<Model>*			NodePointer;
+
+	MeasureBench(const Model& a, const Model& b) : _a(a), _b(b){}
+
+	void operator()(size_t iterations) const {
+		double sum = 0;
+		for(size_t i = 0; i < iterations; ++i){
+			sum += _measure(&_a, &_b);
+			doNotOptimize(sum);
+		}
+	}
+
+	mutable BenchNode<Model>			_a, _b;
+	Measure<NodePointer, double>		_measure;
+};
+
+template<class Model>
+struct MergeBench
+{
+	typedef BenchNode<Model>*			NodePointer;
+
+	MergeBench(const Model& a, const Model& b) : _a(a), _b(b){}
+
+	void operator()(size_t iterations) const {
+		for(size_t i = 0; i < iterations; ++i){
+			Model m = _merge(&_a, &_b);
+			doNotOptimize(m);
+		}
+	}
+
+	mutable BenchNode<Model>			_a, _b;
+	ModelMerge<NodePointer, Model>		_merge;
+};
+
+template<class Model>
+struct Norm2Bench
+{
+	Norm2Bench(const Model& a) : _a(a){}
+
+	void operator()(size_t iterations) const {
+		double sum = 0;
+		for(size_t i = 0; i < iterations; ++i){
+			sum += norm2(_a);
+			doNotOptimize(sum);
+		}
+	}
+
+	Model		_a;
+};
+
+template<class Model>
+struct Dist2Bench
+{
+	Dist2Bench(const Model& a, const Model& b) : _a(a), _b(b){}
+
+	void operator()(size_t iterations) const {
+		double sum = 0;
+		for(size_t i = 0; i < iterations; ++i){
+			sum += dist2(_a, _b);
+			doNotOptimize(sum);
+		}
+	}
+
+	Model		_a, _b;
+};
+
+string benchName(const string& base, size_t subMatrixSize, size_t covariances){
+	return base + "/N" + to_string(subMatrixSize) + "/cov" + to_string(covariances);
+}
+
+/**
+ * Full matrix dissimilarity measures, over a NativeMatrixModel of the size of
+ * the time series covariance (N x Cov), and merge, norm2 and dist2 of it
+ */
+template<size_t N, size_t Cov>
+void benchNativeModels(BenchmarkRunner& runner, ScatteringGenerator& gen){
+	typedef NativeMatrixModel<complex<double>, N * Cov>					NModel;
+	typedef NativeMatrixModelWithHomogeneity<complex<double>, N * Cov>	HNModel;
+	typedef VectorMatrixModel<complex<double>, size_t, float, N, Cov>	FVMModel;
+
+	const HNModel a = makeRegion<HNModel>(gen, N * Cov, complexPixel), b = makeRegion<HNModel>(gen, N * Cov, complexPixel);
+	runner.run(benchName("measure/RevisedWishart", N, Cov), MeasureBench<HNModel, RevisedWishartDissimilarityMeasure>(a, b));
+	runner.run(benchName("measure/Geodesic", N, Cov), MeasureBench<HNModel, GeodesicDissimilarityMeasure>(a, b));
+	runner.run(benchName("measure/Homog", N, Cov), MeasureBench<HNModel, HomogDissimilarityMeasure>(a, b));
+	runner.run(benchName("merge/NativeMatrixModelWithHomogeneity", N, Cov), MergeBench<HNModel>(a, b));
+
+	const NModel na = makeRegion<NModel>(gen, N * Cov, complexPixel), nb = makeRegion<NModel>(gen, N * Cov, complexPixel);
+	runner.run(benchName("merge/NativeMatrixModel", N, Cov), MergeBench<NModel>(na, nb));
+	runner.run(benchName("norm2/NativeMatrixModel", N, Cov), Norm2Bench<NModel>(na));
+	runner.run(benchName("dist2/NativeMatrixModel", N, Cov), Dist2Bench<NModel>(na, nb));
+
+	const FVMModel fa = makeRegion<FVMModel>(gen, N * Cov, complexPixel), fb = makeRegion<FVMModel>(gen, N * Cov, complexPixel);
+	runner.run(benchName("merge/VectorMatrixModel<Fixed>", N, Cov), MergeBench<FVMModel>(fa, fb));
+	runner.run(benchName("dist2/VectorMatrixModel<Fixed>", N, Cov), Dist2Bench<FVMModel>(fa, fb));
+}
+
+/**
+ * Dissimilarity measures over the TEBPT time series models (block diagonal
+ * and diagonal ones) and over the intensities (vector one), and merge,
+ * norm2 and dist2 of each model type
+ */
+template<size_t N>
+void benchModels(BenchmarkRunner& runner, ScatteringGenerator& gen){
+	typedef VectorMatrixModel<complex<double>, size_t, float, N>		VMModel;
+	typedef AddHomogeneity<VMModel>										HVMModel;
+	typedef AddLogDetAverage<VMModel>									LVMModel;
+	typedef VectorModel<double>											VModel;
+
+	for(size_t c = 0; c < N_COVARIANCES; ++c){
+		const size_t cov = COVARIANCES[c];
+		const HVMModel a = makeRegion<HVMModel>(gen, N * cov, complexPixel), b = makeRegion<HVMModel>(gen, N * cov, complexPixel);
+		runner.run(benchName("measure/GeodesicVectorMatrix", N, cov), MeasureBench<HVMModel, GeodesicVectorMatrixDissimilarityMeasure>(a, b));
+		runner.run(benchName("measure/WishartVectorMatrix", N, cov), MeasureBench<HVMModel, WishartVectorMatrixDissimilarityMeasure>(a, b));
+		runner.run(benchName("measure/DiagonalRevisedWishart", N, cov), MeasureBench<HVMModel, DiagonalRevisedWishartDissimilarityMeasure>(a, b));
+		runner.run(benchName("measure/DiagonalGeodesic", N, cov), MeasureBench<HVMModel, DiagonalGeodesicDissimilarityMeasure>(a, b));
+		runner.run(benchName("merge/AddHomogeneity<VectorMatrixModel>", N, cov), MergeBench<HVMModel>(a, b));
+
+		const VMModel ma = makeRegion<VMModel>(gen, N * cov, complexPixel), mb = makeRegion<VMModel>(gen, N * cov, complexPixel);
+		runner.run(benchName("merge/VectorMatrixModel", N, cov), MergeBench<VMModel>(ma, mb));
+		runner.run(benchName("norm2/VectorMatrixModel", N, cov), Norm2Bench<VMModel>(ma));
+		runner.run(benchName("dist2/VectorMatrixModel", N, cov), Dist2Bench<VMModel>(ma, mb));
+		// NOTE: Initialized from full rank regions (the log determinant of a single pixel is not defined)
+		runner.run(benchName("merge/AddLogDetAverage<VectorMatrixModel>", N, cov), MergeBench<LVMModel>(LVMModel(ma), LVMModel(mb)));
+
+		const VModel va = makeRegion<VModel>(gen, N * cov, intensityPixel), vb = makeRegion<VModel>(gen, N * cov, intensityPixel);
+		runner.run(benchName("measure/DiagonalRevisedWishartVector", N, cov), MeasureBench<VModel, DiagonalRevisedWishartVectorDissimilarityMeasure>(va, vb));
+		runner.run(benchName("merge/VectorModel", N, cov), MergeBench<VModel>(va, vb));
+		runner.run(benchName("norm2/VectorModel", N, cov), Norm2Bench<VModel>(va));
+		runner.run(benchName("dist2/VectorModel", N, cov), Dist2Bench<VModel>(va, vb));
+	}
+
+	// Fixed size models, for each number of covariances (see COVARIANCES)
+	benchNativeModels<N, 1>(runner, gen);
+	benchNativeModels<N, 2>(runner, gen);
+	benchNativeModels<N, 5>(runner, gen);
+	benchNativeModels<N, 10>(runner, gen);
+	benchNativeModels<N, 20>(runner, gen);
+}
+
+template<class BPT>
+struct ModelAccessor : public unary_function< typename BPT::NodePointer, typename BPT::Node::RegionModel::covariance_type > {
+	typedef typename BPT::NodePointer 							NodePointer;
+	typedef typename BPT::Node::RegionModel::covariance_type		covariance_type;
+	covariance_type& operator()(NodePointer a) const {
+		return (a->getModel().getFullCovariance());
+	}
+};
+
+// Image of leaf nodes (as given by DenseWRAGGenerator) of the TEBPT model, filtered in place
+template<class BPT>
+struct FilterImage
+{
+	FilterImage(ScatteringGenerator& gen, size_t rows, size_t cols, size_t elems) : rows(rows), cols(cols){
+		for(size_t r = 0; r < rows; ++r){
+			for(size_t c = 0; c < cols; ++c){
+				const float pos[2] = {static_cast<float>(c), static_cast<float>(r)};
+				ComplexPixel p(gen.scattering(elems), pos);
+				nodes.push_back(BPT::NodeStoragePolicy::create(p, static_cast<typename BPT::Node::IDType>(nodes.size())));
+			}
+		}
+	}
+
+	~FilterImage(){
+		for(size_t i = 0; i < nodes.size(); ++i) BPT::NodeStoragePolicy::remove(nodes[i]);
+	}
+
+	size_t									rows, cols;
+	vector<typename BPT::NodePointer>		nodes;
+};
+
+template<class BPT>
+struct BoxCarBench
+{
+	BoxCarBench(FilterImage<BPT>& image, size_t window) : _image(image), _window(window){}
+
+	void operator()(size_t iterations) const {
+		for(size_t i = 0; i < iterations; ++i){
+			boxCarFilter2DFullInterp(_image.nodes.begin(), _image.rows, _image.cols, _window, _window);
+		}
+	}
+
+	FilterImage<BPT>&		_image;
+	size_t					_window;
+};
+
+template<class BPT>
+struct BilateralBench
+{
+	BilateralBench(FilterImage<BPT>& image, size_t window, double sigma_t) : _image(image), _window(window), _sigma_t(sigma_t){}
+
+	void operator()(size_t iterations) const {
+		BLFDiagonalWishartDiss<typename BPT::RegionModel::covariance_type> 	bfdiss(_sigma_t);
+		ImageData<double> 	k_img(_image.rows, _image.cols);
+		for(size_t i = 0; i < iterations; ++i){
+			iterativeCrossBilateralDBF2Filter(
+					make_LinearAccessor(_image.nodes, _image.cols),	// in
+					make_LinearAccessor(_image.nodes, _image.cols),	// ref
+					make_LinearAccessor(_image.nodes, _image.cols),	// out
+					k_img, bfdiss, _image.rows, _image.cols, _window, _window, 2.0, 0.5, 1, ModelAccessor<BPT>());
+		}
+	}
+
+	FilterImage<BPT>&		_image;
+	size_t					_window;
+	double					_sigma_t;
+};
+
+// Spatial filters over a 64x64 image of the TEBPT C3 model with 4 covariances, at several window sizes
+void benchFilters(BenchmarkRunner& runner, ScatteringGenerator& gen){
+	typedef BPTFrame<AddHomogeneity<VectorMatrixModel<complex<double>, size_t, float, 3> > >		BPT;
+	static const size_t ROWS = 64, COLS = 64, COV = 4;
+	static const size_t WINDOWS[] = {3, 5, 7, 9};
+
+	FilterImage<BPT> image(gen, ROWS, COLS, 3 * COV);
+	for(size_t w = 0; w < sizeof(WINDOWS) / sizeof(WINDOWS[0]); ++w){
+		runner.run(string("filter/BoxCar/64x64/N3/cov4/w") + to_string(WINDOWS[w]), BoxCarBench<BPT>(image, WINDOWS[w]));
+	}
+	const double sigma_t = compute_sigma_t(make_LinearAccessor(image.nodes, COLS), ROWS, COLS, ModelAccessor<BPT>(), 8);
+	for(size_t w = 0; w < 3; ++w){
+		runner.run(string("filter/Bilateral/64x64/N3/cov4/w") + to_string(WINDOWS[w]), BilateralBench<BPT>(image, WINDOWS[w], sigma_t));
+	}
+}
+
+// BPT construction (WRAG generation and merging loop, without saving) of the TEBPT C3 model with a checking policy
+template<class CheckingPol>
+struct ConstructionBench
+{
+	typedef BPTFrame<AddHomogeneity<VectorMatrixModel<complex<double>, size_t, float, 3> >,
+			double, uint32_t, DefaultNativeStoragePolicy, CheckingPol>							BPT;
+	typedef typename BPT::Node																Node;
+	typedef BPTConstructor<typename BPT::NodeStoragePolicy, typename BPT::DissimilarityStoragePolicy,
+			Logger<>, CheckingPol>															Constructor;
+	typedef GeodesicVectorMatrixDissimilarityMeasure<typename BPT::NodePointer, double>		Dissimilarity;
+
+	ConstructionBench(const vector<ComplexPixel>& pixels, size_t rows, size_t cols) : _pixels(pixels), _rows(rows), _cols(cols){}
+
+	void operator()(size_t iterations) const {
+		streambuf* out = cout.rdbuf(NULL);	// Silence the progress display
+		for(size_t i = 0; i < iterations; ++i){
+			DenseWRAGGenerator<Node, DefaultNativeStoragePolicy, CheckingPol> wrag(_pixels.begin(), _pixels.end(), _rows, _cols);
+			Dissimilarity diss;
+			wrag.template generateWRAG_2D_Connectivity8<Dissimilarity, typename BPT::Dissimilarity>(diss);
+			Constructor constructor(wrag.begin(), wrag.end(), wrag.getIdContext());
+			typename BPT::NodeSet roots = constructor.template getBinaryPartitionForest<Dissimilarity, ModelMerge>(1, diss);
+			Node::removeBPTNodes(*(roots.begin()));
+		}
+		cout.rdbuf(out);
+		cout.clear();
+	}
+
+	const vector<ComplexPixel>&		_pixels;
+	size_t							_rows, _cols;
+};
+
+// Overhead of each checking level on the BPT construction of a 24x24 image of the TEBPT C3 model with 4 covariances
+void benchConstruction(BenchmarkRunner& runner, ScatteringGenerator& gen){
+	static const size_t ROWS = 24, COLS = 24, COV = 4;
+
+	vector<ComplexPixel> pixels;
+	for(size_t r = 0; r < ROWS; ++r){
+		for(size_t c = 0; c < COLS; ++c){
+			const float pos[2] = {static_cast<float>(c), static_cast<float>(r)};
+			pixels.push_back(ComplexPixel(gen.scattering(3 * COV), pos));
+		}
+	}
+	runner.run("construction/FullChecking/24x24/N3/cov4", ConstructionBench<FullCheckingPolicy>(pixels, ROWS, COLS));
+	runner.run("construction/ReleaseChecking/24x24/N3/cov4", ConstructionBench<ReleaseCheckingPolicy>(pixels, ROWS, COLS));
+	runner.run("construction/NullChecking/24x24/N3/cov4", ConstructionBench<NullCheckingPolicy>(pixels, ROWS, COLS));
+}
+
+// Configuration of the in-memory pipeline benchmark (TEBPT C3 model, scattering vectors given as input)
+struct PipelineBenchConfig
+{
+	static const size_t		subMatrix_size			= 3;
+	static const size_t		files_per_acquisition	= 3;
+	static const size_t		num_covariances			= 0;
+
+	typedef NoOpScatteringVector		SOperator;
+	typedef BPTFrame<AddHomogeneity<VectorMatrixModel<complex<double>, size_t, float, 3> >,
+			double, uint32_t, DefaultNativeStoragePolicy, FullCheckingPolicy>						BPT;
+	typedef GeodesicVectorMatrixDissimilarityMeasure<BPT::NodePointer, double>					Dissimilarity;
+	typedef RelErrorHomogeneityPruneCriterion<> 												PruneCriterion;
+};
+
+// Whole in-memory pipeline (leaves, filter, construction, tables and prunes with their rasters) from a planar buffer
+struct PipelineBench
+{
+	PipelineBench(const vector<complex<float> >& data, size_t rows, size_t cols, size_t channels) :
+		_data(data), _rows(rows), _cols(cols), _channels(channels){
+		_options.setPruneRange(-3, 1, -1);
+		_options.pairs = true;
+	}
+
+	void operator()(size_t iterations) const {
+		streambuf* out = cout.rdbuf(NULL);	// Silence the progress display
+		for(size_t i = 0; i < iterations; ++i){
+			pipeline::Result<PipelineBenchConfig> result;
+			pipeline::run(pipeline::InputSpan(&(_data[0]), _rows, _cols, _channels), _options, result);
+		}
+		cout.rdbuf(out);
+		cout.clear();
+	}
+
+	const vector<complex<float> >&	_data;
+	size_t							_rows, _cols, _channels;
+	pipeline::Options				_options;
+};
+
+// In-memory pipeline of a 24x24 image of the TEBPT C3 model with 4 covariances
+void benchPipeline(BenchmarkRunner& runner, ScatteringGenerator& gen){
+	static const size_t ROWS = 24, COLS = 24, COV = 4, CHANNELS = 3 * COV;
+
+	vector<complex<float> > data(ROWS * COLS * CHANNELS);
+	for(size_t p = 0; p < ROWS * COLS; ++p){
+		const vector<complex<float> > s = gen.scattering(CHANNELS);
+		for(size_t c = 0; c < CHANNELS; ++c) data[c * ROWS * COLS + p] = s[c];
+	}
+	runner.run("pipeline/InMemory/24x24/N3/cov4", PipelineBench(data, ROWS, COLS, CHANNELS));
+}
+
+int main(int argc, char** argv) {
+	double minTime = 0.1, tolerance = 10;
+	size_t repetitions = 3;
+	string filter, out = "bench.json", baseline;
+
+	for(int argi = 1; argi < argc; argi++){
+		if(strcmp(argv[argi], "--filter") == 0 && argi+1 < argc){
+			filter = argv[++argi];
+		} else if(strcmp(argv[argi], "--min-time") == 0 && argi+1 < argc){
+			minTime = atof(argv[++argi]);
+		} else if(strcmp(argv[argi], "--repetitions") == 0 && argi+1 < argc){
+			repetitions = atol(argv[++argi]);
+		} else if(strcmp(argv[argi], "--out") == 0 && argi+1 < argc){
+			out = argv[++argi];
+		} else if(strcmp(argv[argi], "--baseline") == 0 && argi+1 < argc){
+			baseline = argv[++argi];
+		} else if(strcmp(argv[argi], "--tolerance") == 0 && argi+1 < argc){
+			tolerance = atof(argv[++argi]);
+		}else{
+			cerr << "ERROR: Unknown parameter '" << argv[argi] << "'" << endl;
+			printUsage();
+			return EXIT_FAILURE;
+		}
+	}
+
+	BenchmarkRunner runner(minTime, repetitions, filter);
+	ScatteringGenerator gen(12345);
+
+	benchModels<1>(runner, gen);
+	benchModels<2>(runner, gen);
+	benchModels<3>(runner, gen);
+	benchFilters(runner, gen);
+	benchConstruction(runner, gen);
+	benchPipeline(runner, gen);
+
+	if(!runner.writeJSON(out)){
+		cerr << "ERROR: the results file '" << out << "' cannot be written!" << endl;
+		return EXIT_FAILURE;
+	}
+	cout << "\nResults written into " << out << endl;
+
+	if(!baseline.empty()){
+		const size_t regressions = runner.compare(baseline, tolerance / 100.0, cout);
+		cout << regressions << " regression(s) against " << baseline << " (tolerance " << tolerance << "%)" << endl;
+		if(regressions > 0) return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
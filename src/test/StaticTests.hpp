@@ -98,7 +98,7 @@ public:
 	template<typename BPT, typename ModelParam>
 	void __GenericTestBPTFrame(ModelParam param) {
 		__GenericTestBPTFrame<BPT>();
-		typename BPT::Node n(param);
+		typename BPT::Node n(param, 0);
 		typename BPT::WeakNodePointer p = n.getFather();
 		typename BPT::StrongNodePointer pl = n.getLeftSoon();
 		typename BPT::StrongNodePointer pr = n.getRightSoon();